@@ -398,6 +398,7 @@ msab_marchConnection(const char *host, const int port)
 }
 
 #define STARTEDFILE ".started"
+#define PROGRESSFILE ".progress"
 /**
  * Removes all known publications of available services.  The function
  * name is a nostalgic phrase from "Defender of the Crown" from the
@@ -421,6 +422,10 @@ msab_wildRetreat(void)
 		return(tmp);
 	(void) remove(pathbuf);
 
+	if ((tmp = getDBPath(pathbuf, sizeof(pathbuf), PROGRESSFILE)) != NULL)
+		return(tmp);
+	(void) remove(pathbuf);
+
 	if ((tmp = getDBPath(pathbuf, sizeof(pathbuf), _sabaoth_internal_uuid)) != NULL)
 		return(tmp);
 	(void) remove(pathbuf);
@@ -504,6 +509,41 @@ msab_registerStarted(void)
 	else
 		return strdup("sabaoth cannot create " STARTEDFILE);
 
+	/* there is no more progress to report */
+	return(msab_registerProgress(NULL));
+}
+
+/**
+ * Publishes a single line describing what the server is doing while
+ * it is starting up, e.g. how far it got replaying its write-ahead
+ * log, such that it can be shown by the database status.  Passing
+ * NULL removes the message.
+ */
+char *
+msab_registerProgress(const char *msg)
+{
+	char pathbuf[FILENAME_MAX];
+	char line[256];
+	char *tmp;
+	size_t i;
+	FILE *fp;
+
+	if ((tmp = getDBPath(pathbuf, sizeof(pathbuf), PROGRESSFILE)) != NULL)
+		return(tmp);
+	if (msg == NULL) {
+		(void) remove(pathbuf);
+		return(NULL);
+	}
+	/* the message ends up in the serialised form, which uses , as
+	 * separator */
+	for (i = 0; msg[i] != '\0' && i < sizeof(line) - 1; i++)
+		line[i] = msg[i] == ',' || msg[i] == '\n' ? ' ' : msg[i];
+	line[i] = '\0';
+	if ((fp = fopen(pathbuf, "w")) == NULL)
+		return strdup("sabaoth cannot create " PROGRESSFILE);
+	fprintf(fp, "%s\n", line);
+	(void)fclose(fp);
+
 	return(NULL);
 }
 
@@ -582,6 +622,7 @@ msab_getSingleStatus(const char *pathbuf, const char *dbname, sabdb *next)
 	sdb = malloc(sizeof(sabdb));
 	sdb->uplog = NULL;
 	sdb->uri = NULL;
+	sdb->progress = NULL;
 	sdb->next = next;
 
 	/* store the database name */
@@ -661,6 +702,18 @@ msab_getSingleStatus(const char *pathbuf, const char *dbname, sabdb *next)
 			sdb->state = SABdbInactive;
 		}
 	}
+	if (sdb->state == SABdbStarting) {
+		/* what is the database doing while starting */
+		snprintf(buf, sizeof(buf), "%s/%s/%s", pathbuf, dbname, PROGRESSFILE);
+		if ((f = fopen(buf, "r")) != NULL) {
+			if (fgets(data, 8095, f) != NULL) {
+				if (*data != '\0' && data[strlen(data) - 1] == '\n')
+					data[strlen(data) - 1] = '\0';
+				sdb->progress = strdup(data);
+			}
+			(void)fclose(f);
+		}
+	}
 	snprintf(buf, sizeof(buf), "%s/%s/%s", pathbuf, dbname, MAINTENANCEFILE);
 	if (stat(buf, &statbuf) == -1) {
 		sdb->locked = 0;
@@ -783,6 +836,8 @@ msab_freeStatus(sabdb** ret)
 			free(p->uri);
 		if (p->uplog != NULL)
 			free(p->uplog);
+		if (p->progress != NULL)
+			free(p->progress);
 		r = p->scens;
 		while (r != NULL) {
 			if (r->val != NULL)
@@ -919,7 +974,7 @@ msab_getUplogInfo(sabuplog *ret, const sabdb *db)
 }
 
 /* used in the serialisation to be able to change it in the future */
-#define SABDBVER "2"
+#define SABDBVER "3"
 
 /**
  * Produces a string representation suitable for storage/sending.
@@ -959,14 +1014,15 @@ msab_serialise(char **ret, const sabdb *db)
 			 "%d,%d,%d,"
 			 "%" PRId64 ",%" PRId64 ",%" PRId64 ","
 			 "%" PRId64 ",%" PRId64 ",%" PRId64 ","
-			 "%d,%f,%f",
+			 "%d,%f,%f,%s",
 			 db->dbname, db->uri ? db->uri : "", db->locked,
 			 (int) db->state, scens,
 			 dbu.startcntr, dbu.stopcntr, dbu.crashcntr,
 			 (int64_t) dbu.avguptime, (int64_t) dbu.maxuptime,
 			 (int64_t) dbu.minuptime, (int64_t) dbu.lastcrash,
 			 (int64_t) dbu.laststart, (int64_t) dbu.laststop,
-			 dbu.crashavg1, dbu.crashavg10, dbu.crashavg30);
+			 dbu.crashavg1, dbu.crashavg10, dbu.crashavg30,
+			 db->progress ? db->progress : "");
 
 	*ret = strdup(buf);
 	return(NULL);
@@ -983,6 +1039,7 @@ msab_deserialise(sabdb **ret, char *sdb)
 	int locked;
 	int state;
 	char *scens = "";
+	char *progress = NULL;
 	sabdb *s;
 	sabuplog *u;
 	sablist *l;
@@ -1023,6 +1080,9 @@ msab_deserialise(sabdb **ret, char *sdb)
 		 * reading protocol 1, we use the path field to set dbname, but
 		 * ignore the path information (and set uri to "<unknown>".  The
 		 * SABdbStarting state never occurs. */
+	} else if (strcmp(lasts, "2") == 0) {
+		/* Protocol 3 added the progress of a starting database as
+		 * the last field. */
 	} else if (strcmp(lasts, SABDBVER) != 0) {
 		snprintf(buf, sizeof(buf), 
 				"string has unsupported version: %s", lasts);
@@ -1191,6 +1251,17 @@ msab_deserialise(sabdb **ret, char *sdb)
 	*p++ = '\0';
 	u->crashavg10 = atof(lasts);
 	lasts = p;
+	if (protover >= '3') {
+		if ((p = strchr(p, ',')) == NULL) {
+			free(u);
+			snprintf(buf, sizeof(buf), 
+					"string does not contain crashavg30: %s", lasts);
+			return(strdup(buf));
+		}
+		*p++ = '\0';
+		progress = p;
+		p = lasts;
+	}
 	if ((p = strchr(p, ',')) != NULL) {
 		free(u);
 		snprintf(buf, sizeof(buf), 
@@ -1238,6 +1309,7 @@ msab_deserialise(sabdb **ret, char *sdb)
 	}
 	s->conns = NULL;
 	s->uplog = u;
+	s->progress = progress && *progress ? strdup(progress) : NULL;
 	s->next = NULL;
 
 	*ret = s;
@@ -32,6 +32,7 @@ typedef struct Ssabdb {
 	sablist* scens;          /* scenarios available for this database */
 	sablist* conns;          /* connections available for this database */
 	struct Ssabuplog *uplog; /* sabuplog struct for this database */
+	char *progress;          /* what the database does while starting */
 	char *uri;               /* URI to connect to this database */
 	struct Ssabdb* next;     /* next database */
 } sabdb;
@@ -71,6 +72,7 @@ msab_export char *msab_marchConnection(const char *host, const int port);
 msab_export char *msab_wildRetreat(void);
 msab_export char *msab_registerStarting(void);
 msab_export char *msab_registerStarted(void);
+msab_export char *msab_registerProgress(const char *msg);
 msab_export char *msab_registerStop(void);
 msab_export char *msab_getMyStatus(sabdb** ret);
 msab_export char *msab_getStatus(sabdb** ret, char *dbname);
@@ -432,6 +432,9 @@
 #define FORCEMITOMASK	(1<<29)
 #define FORCEMITODEBUG	if (GDKdebug & FORCEMITOMASK)
 
+/* don't use the vectorized (SIMD) kernels, only the scalar ones */
+#define NOSIMDMASK	(1<<30)
+
 /*
  * @- GDK session handling
  * @multitable @columnfractions 0.08 0.7
@@ -565,11 +568,14 @@ typedef enum {
 	STORE_INVALID		/* invalid value, used to indicate error */
 } storage_t;
 
+typedef struct StrDict StrDict;
+
 typedef struct {
 	size_t free;		/* index where free area starts. */
 	size_t size;		/* size of the heap (bytes) */
 	char *base;		/* base pointer in memory. */
 	char filename[32];	/* file containing image of the heap */
+	StrDict *dict;		/* string dictionary (string heaps only) */
 
 	bool copied:1,		/* a copy of an existing map. */
 		hashash:1,	/* the string heap contains hash values */
@@ -593,7 +599,16 @@ typedef struct {
 	Heap heap;		/* heap where the hash is stored */
 } Hash;
 
+typedef struct {
+	int type;		/* type of index entity */
+	int posbits;		/* nr of low slot bits holding position+1 */
+	BUN mask;		/* number of slots-1 (power of 2) */
+	ulng *Slot;		/* slot array, 0 means empty */
+	Heap heap;		/* heap where the hash is stored */
+} BHash;
+
 typedef struct Imprints Imprints;
+typedef struct Zonemap Zonemap;
 
 /*
  * @+ Binary Association Tables
@@ -752,6 +767,18 @@ typedef struct {
 
 typedef struct PROPrec PROPrec;
 
+/* A candidate list (sorted, unique oids) can be kept as a bitmap: bit
+ * i of bits is set if oid first+i is a candidate.  The first and last
+ * bit are always set.  Unless materialized is set, the tail heap of
+ * the BAT is not allocated and only code that knows about the mask
+ * may look at the BAT (see BATcanddescriptor). */
+typedef struct CandMask {
+	oid first;		/* first candidate */
+	BUN nbits;		/* number of bits (last - first + 1) */
+	bool materialized;	/* the tail heap holds the oids as well */
+	uint64_t *bits;		/* the bitmap, (nbits + 63) / 64 words */
+} CandMask;
+
 /* see also comment near BATassertProps() for more information about
  * the properties */
 typedef struct {
@@ -775,8 +802,11 @@ typedef struct {
 	Heap heap;		/* space for the column. */
 	Heap *vheap;		/* space for the varsized data. */
 	Hash *hash;		/* hash table */
+	BHash *bhash;		/* bucketized (open addressing) hash table */
 	Imprints *imprints;	/* column imprints index */
+	Zonemap *zonemap;	/* per block minimum and maximum */
 	Heap *orderidx;		/* order oid index */
+	CandMask *mask;		/* compressed candidate list */
 
 	PROPrec *props;		/* list of dynamic properties stored in the bat descriptor */
 } COLrec;
@@ -841,7 +871,10 @@ typedef struct BATiter {
 #define theap		T.heap
 #define tvheap		T.vheap
 #define thash		T.hash
+#define tbhash		T.bhash
 #define timprints	T.imprints
+#define tzonemap	T.zonemap
+#define tmask		T.mask
 #define tprops		T.props
 
 
@@ -876,6 +909,12 @@ typedef struct BATiter {
  * @item int
  * @tab
  *  HEAPwarm (Heap *h);
+ * @item int
+ * @tab
+ *  HEAPcompress (Heap *h, int tpe, void **img, size_t *len);
+ * @item int
+ * @tab
+ *  HEAPdecompress (Heap *h, int tpe, void *img, size_t len);
  * @end multitable
  *
  *
@@ -886,6 +925,10 @@ gdk_export gdk_return HEAPextend(Heap *h, size_t size, bool mayshare)
 	__attribute__((__warn_unused_result__));
 gdk_export size_t HEAPvmsize(Heap *h);
 gdk_export size_t HEAPmemsize(Heap *h);
+gdk_export gdk_return HEAPcompress(const Heap *h, int tpe, void **imgp, size_t *lenp)
+	__attribute__((__warn_unused_result__));
+gdk_export gdk_return HEAPdecompress(Heap *h, int tpe, const void *img, size_t len)
+	__attribute__((__warn_unused_result__));
 
 /*
  * @- Internal HEAP Chunk Management
@@ -1334,8 +1377,13 @@ gdk_export int BATgetaccess(BAT *b);
 gdk_export gdk_return BATclear(BAT *b, bool force);
 gdk_export BAT *COLcopy(BAT *b, int tt, bool writable, int role);
 
+/* Large inputs with many groups are grouped by GDKnr_threads
+ * threads; BATgroupthreads does the same with an explicit maximum
+ * number of threads.  Both produce the same groups. */
 gdk_export gdk_return BATgroup(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h)
 	__attribute__((__warn_unused_result__));
+gdk_export gdk_return BATgroupthreads(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, int nthreads)
+	__attribute__((__warn_unused_result__));
 
 /*
  * @- BAT Input/Output
@@ -1412,8 +1460,14 @@ gdk_export gdk_return BATprint(BAT *b);
 gdk_export bool BATkeyed(BAT *b);
 gdk_export bool BATordered(BAT *b);
 gdk_export bool BATordered_rev(BAT *b);
+/* Large columns of fixed size numeric values are sorted by
+ * GDKnr_threads threads; BATsortthreads does the same with an
+ * explicit maximum number of threads.  Both produce the same
+ * result. */
 gdk_export gdk_return BATsort(BAT **sorted, BAT **order, BAT **groups, BAT *b, BAT *o, BAT *g, bool reverse, bool stable)
 	__attribute__((__warn_unused_result__));
+gdk_export gdk_return BATsortthreads(BAT **sorted, BAT **order, BAT **groups, BAT *b, BAT *o, BAT *g, bool reverse, bool stable, int nthreads)
+	__attribute__((__warn_unused_result__));
 
 
 gdk_export void GDKqsort(void *restrict h, void *restrict t, const void *restrict base, size_t n, int hs, int ts, int tpe);
@@ -1548,6 +1602,9 @@ typedef struct {
 	int refs;		/* in-memory references on which the loaded status of a BAT relies */
 	int lrefs;		/* logical references on which the existence of a BAT relies */
 	volatile unsigned status; /* status mask used for spin locking */
+	unsigned heat;		/* number of recent fixes, decays over time */
+	unsigned lastused;	/* BBP clock tick of most recent fix */
+	ulng dirhash;		/* hash value of entry in BBP.dir/BBP.dlt */
 	/* MT_Id pid;           non-zero thread-id if this BAT is private */
 } BBPrec;
 
@@ -1578,6 +1635,9 @@ gdk_export BBPrec *BBP[N_BBPINIT];
 #define BBP_refs(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].refs
 #define BBP_lrefs(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].lrefs
 #define BBP_status(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].status
+#define BBP_heat(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].heat
+#define BBP_lastused(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].lastused
+#define BBP_dirhash(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].dirhash
 #define BBP_pid(i)	BBP[(i)>>BBPINITLOG][(i)&(BBPINIT-1)].pid
 
 /* macros that nicely check parameters */
@@ -1812,9 +1872,19 @@ gdk_export ptr ATOMdup(int id, const void *val);
  *
  * The routine BAThash makes sure that a hash accelerator on the tail of the
  * BAT exists. GDK_FAIL is returned upon failure to create the supportive
- * structures.
+ * structures.  Large hash tables are built by GDKnr_threads threads;
+ * BAThashbuild does the same with an explicit maximum number of
+ * threads.  Both produce the very same table.
+ *
+ * The routine BATbhash creates the alternative bucketized hash
+ * accelerator, an open addressing table in which all candidates for a
+ * value are found in one or two consecutive cache lines instead of by
+ * following a collision chain.  When present, it is preferred over the
+ * chained hash by equi-selects and hash joins.
  */
 gdk_export gdk_return BAThash(BAT *b);
+gdk_export gdk_return BAThashbuild(BAT *b, int nthreads);
+gdk_export gdk_return BATbhash(BAT *b);
 
 /*
  * @- Column Imprints Functions
@@ -1833,9 +1903,21 @@ gdk_export gdk_return BATimprints(BAT *b);
 gdk_export void IMPSdestroy(BAT *b);
 gdk_export lng IMPSimprintsize(BAT *b);
 
-/* The ordered index structure */
+/* The zone map records the smallest and largest value of each cache
+ * line sized block of a fixed size column.  It is kept in memory
+ * only, and it is not invalidated by appends: it is extended with the
+ * appended values the next time it is used.  Range joins, band joins,
+ * theta joins and range selects use it to skip the blocks that cannot
+ * contain a match. */
+gdk_export gdk_return BATzonemap(BAT *b);
+
+/* The ordered index structure.  Large stable (or unique) order
+ * indexes are built by GDKnr_threads threads; BATorderidxbuild does
+ * the same with an explicit maximum number of threads.  The result is
+ * the same as that of a serial build. */
 
 gdk_export gdk_return BATorderidx(BAT *b, bool stable);
+gdk_export gdk_return BATorderidxbuild(BAT *b, bool stable, int nthreads);
 gdk_export gdk_return GDKmergeidx(BAT *b, BAT**a, int n_ar);
 
 /*
@@ -2345,8 +2427,13 @@ BBPcheck(bat x, const char *y)
 	return 0;
 }
 
+gdk_export gdk_return BATcandmaterialize(BAT *s)
+	__attribute__((__warn_unused_result__));
+
+/* BATcanddescriptor does not materialize a compressed candidate
+ * list, it is for code that deals with CandMask itself */
 static inline BAT *
-BATdescriptor(bat i)
+BATcanddescriptor(bat i)
 {
 	BAT *b = NULL;
 
@@ -2360,6 +2447,19 @@ BATdescriptor(bat i)
 	return b;
 }
 
+static inline BAT *
+BATdescriptor(bat i)
+{
+	BAT *b = BATcanddescriptor(i);
+
+	if (b && b->tmask && !b->tmask->materialized &&
+	    BATcandmaterialize(b) != GDK_SUCCEED) {
+		BBPunfix(b->batCacheid);
+		return NULL;
+	}
+	return b;
+}
+
 static inline char *
 Tpos(BATiter *bi, BUN p)
 {
@@ -2424,8 +2524,9 @@ Tpos(BATiter *bi, BUN p)
  *
  * TMsubcommit is intended to quickly add or remove BATs from the
  * persistent set. In both cases, rollback is not necessary, such that
- * the commit protocol can be accelerated. It comes down to writing a
- * new BBP.dir.
+ * the commit protocol can be accelerated. It comes down to writing the
+ * BBP.dir entries of the BATs (in BBP.dlt, which is merged into
+ * BBP.dir now and then).
  *
  * Its parameter is a BAT-of-BATs (in the tail); the persistence
  * status of that BAT is committed. We assume here that the calling
@@ -2745,9 +2846,12 @@ gdk_export BAT *BATunique(BAT *b, BAT *s);
 
 gdk_export BAT *BATmergecand(BAT *a, BAT *b);
 gdk_export BAT *BATintersectcand(BAT *a, BAT *b);
+gdk_export void BATcandcompress(BAT *s);
 
 gdk_export gdk_return BATfirstn(BAT **topn, BAT **gids, BAT *b, BAT *cands, BAT *grps, BUN n, bool asc, bool distinct)
 	__attribute__((__warn_unused_result__));
+gdk_export gdk_return BATfirstnkeys(BAT **topn, BAT **bats, const bool *asc, int nkeys, BAT *cands, BUN n)
+	__attribute__((__warn_unused_result__));
 
 #include "gdk_calc.h"
 
@@ -136,6 +136,9 @@ BATgroupaggrinit(BAT *b, BAT *g, BAT *e, BAT *s,
 	*maxp = max;
 	*ngrpp = ngrp;
 
+	/* the aggregates iterate over an array of candidates */
+	if (BATcandmaterialize(s) != GDK_SUCCEED)
+		return "cannot materialize candidate list";
 	CANDINIT(b, s, start, end, cnt, cand, candend);
 	*startp = start;
 	*endp = end;
@@ -2634,6 +2637,7 @@ BATmin(BAT *b, void *aggr)
 		oid pos;
 		BATiter bi;
 		BAT *pb = NULL;
+		BUN start, end;
 
 		if (BATcheckorderidx(b) ||
 		    (VIEWtparent(b) &&
@@ -2676,6 +2680,11 @@ BATmin(BAT *b, void *aggr)
 					break;
 				}
 			}
+		} else if (ZONEminmax(b, false, &start, &end)) {
+			/* only look at the block that contains it */
+			(void) do_groupmin(&pos, b, NULL, 1, 0, 0, start,
+					   end, NULL, NULL, BATcount(b),
+					   true, false);
 		} else {
 			(void) do_groupmin(&pos, b, NULL, 1, 0, 0, 0,
 					   BATcount(b), NULL, NULL, BATcount(b),
@@ -2728,6 +2737,7 @@ BATmax(BAT *b, void *aggr)
 		oid pos;
 		BATiter bi;
 		BAT *pb = NULL;
+		BUN start, end;
 
 		if (BATcheckorderidx(b) ||
 		    (VIEWtparent(b) &&
@@ -2753,6 +2763,11 @@ BATmax(BAT *b, void *aggr)
 					break;
 				}
 			}
+		} else if (ZONEminmax(b, true, &start, &end)) {
+			/* only look at the block that contains it */
+			(void) do_groupmax(&pos, b, NULL, 1, 0, 0, start,
+					   end, NULL, NULL, BATcount(b),
+					   true, false);
 		} else {
 			(void) do_groupmax(&pos, b, NULL, 1, 0, 0, 0,
 					   BATcount(b), NULL, NULL, BATcount(b),
@@ -2779,6 +2794,494 @@ BATmax(BAT *b, void *aggr)
 }
 
 
+/* ---------------------------------------------------------------------- */
+/* several aggregates in one pass */
+
+/* Calculate any combination of the group sum, count, minimum,
+ * maximum, and average of b in a single scan over the input.  An
+ * aggregate is only calculated if the corresponding output pointer
+ * is not NULL.  The results are the same as those of BATgroupsum
+ * (with result type sumtp), BATgroupcount, BATgroupmin and
+ * BATgroupmax (but with the values instead of their positions), and
+ * BATgroupavg (without scale).  The per-group state of all requested
+ * aggregates is updated while the value and its group id are in
+ * registers, so the input is read only once instead of once per
+ * aggregate.  Types and type combinations that the one pass code
+ * does not handle are delegated to the individual functions. */
+
+#ifdef HAVE_HGE
+#define AGGRS_ACC	hge
+#define AGGRS_ACC_nil	hge_nil
+#define AGGRS_ACC_max	GDK_hge_max
+#define TYPE_acc	TYPE_hge
+#else
+#define AGGRS_ACC	lng
+#define AGGRS_ACC_nil	lng_nil
+#define AGGRS_ACC_max	GDK_lng_max
+#define TYPE_acc	TYPE_lng
+#endif
+
+/* update the state of group gid with the value x; NONIL is a
+ * compile time constant so that the nil checks disappear from the
+ * loop for inputs without nils; SUM and AVG are the macros that
+ * update the sum and the average */
+#define AGGRS_ITER(TYPE, NONIL, SUM, AVG)				\
+	do {								\
+		if (gid < min || gid > max)				\
+			continue;					\
+		gid -= min;						\
+		x = vals[i];						\
+		if (rows)						\
+			rows[gid]++;					\
+		if (!(NONIL)) {						\
+			if (is_##TYPE##_nil(x)) {			\
+				if (!skip_nils)				\
+					cnts[gid] = lng_nil;		\
+				continue;				\
+			}						\
+			if (is_lng_nil(cnts[gid]))			\
+				continue;				\
+		}							\
+		if (mins && (cnts[gid] == 0 || x < mins[gid]))		\
+			mins[gid] = x;					\
+		if (maxs && (cnts[gid] == 0 || x > maxs[gid]))		\
+			maxs[gid] = x;					\
+		SUM(TYPE);						\
+		AVG(TYPE);						\
+	} while (0)
+
+#define AGGRS_LOOP(TYPE, SUM, AVG)					\
+	do {								\
+		const TYPE *restrict vals = (const TYPE *) Tloc(b, 0);	\
+		TYPE *restrict mins = mn ? (TYPE *) Tloc(mn, 0) : NULL;	\
+		TYPE *restrict maxs = xn ? (TYPE *) Tloc(xn, 0) : NULL;	\
+		TYPE x;							\
+		if (cand == NULL && gids != NULL && b->tnonil) {	\
+			/* the common case: a tight loop */		\
+			for (i = start; i < end; i++) {			\
+				gid = gids[i];				\
+				AGGRS_ITER(TYPE, true, SUM, AVG);	\
+			}						\
+		} else {						\
+			for (;;) {					\
+				if (cand) {				\
+					if (cand == candend)		\
+						break;			\
+					i = *cand++ - b->hseqbase;	\
+					if (i >= end)			\
+						break;			\
+				} else {				\
+					i = start++;			\
+					if (i == end)			\
+						break;			\
+				}					\
+				gid = gids ? gids[i] : g->tseqbase + i;	\
+				AGGRS_ITER(TYPE, false, SUM, AVG);	\
+			}						\
+		}							\
+		for (i = 0; i < ngrp; i++) {				\
+			if (cnts[i] == 0 || is_lng_nil(cnts[i])) {	\
+				if (mins)				\
+					mins[i] = TYPE##_nil;		\
+				if (maxs)				\
+					maxs[i] = TYPE##_nil;		\
+				nils++;					\
+			}						\
+		}							\
+	} while (0)
+
+#define AGGRS_SUM(TYPE)							\
+	do {								\
+		AGGRS_ACC *restrict sum = (AGGRS_ACC *) sums;		\
+		if (sum && sum[gid] != AGGRS_ACC_nil)			\
+			ADD_WITH_CHECK(TYPE, x, AGGRS_ACC, sum[gid],	\
+				       AGGRS_ACC, sum[gid],		\
+				       AGGRS_ACC_max,			\
+				       goto overflow);			\
+	} while (0)
+
+#define AGGRS_NOSUM(TYPE)	((void) 0)
+
+#define AGGRS_AVG(TYPE)							\
+	do {								\
+		if (avgs)						\
+			AVERAGE_ITER(TYPE, x, ((TYPE *) avgs)[gid],	\
+				     rems[gid], cnts[gid]);		\
+		else							\
+			cnts[gid]++;					\
+	} while (0)
+
+#define AGGRS_AVG_FLOAT(TYPE)						\
+	do {								\
+		if (dbls)						\
+			AVERAGE_ITER_FLOAT(TYPE, x, dbls[gid], cnts[gid]); \
+		else							\
+			cnts[gid]++;					\
+	} while (0)
+
+#define AGGRS_AVG_FINISH(TYPE)						\
+	do {								\
+		const TYPE *restrict avg = (const TYPE *) avgs;		\
+		for (i = 0; i < ngrp; i++) {				\
+			if (cnts[i] == 0 || is_lng_nil(cnts[i]))	\
+				dbls[i] = dbl_nil;			\
+			else						\
+				dbls[i] = avg[i] + (dbl) rems[i] / cnts[i]; \
+		}							\
+	} while (0)
+
+#define AGGRS_SUM_FINISH(TYPE)						\
+	do {								\
+		const AGGRS_ACC *restrict sum = (const AGGRS_ACC *) sums; \
+		TYPE *restrict res = (TYPE *) Tloc(sn, 0);		\
+		for (i = 0; i < ngrp; i++) {				\
+			if (cnts[i] == 0 || is_lng_nil(cnts[i]) ||	\
+			    sum[i] == AGGRS_ACC_nil) {			\
+				res[i] = TYPE##_nil;			\
+				nils++;					\
+			} else if (sum[i] > GDK_##TYPE##_max ||		\
+				   sum[i] < -GDK_##TYPE##_max) {	\
+				if (abort_on_error)			\
+					goto overflow;			\
+				res[i] = TYPE##_nil;			\
+				nils++;					\
+			} else {					\
+				res[i] = (TYPE) sum[i];			\
+			}						\
+		}							\
+	} while (0)
+
+/* the types the one pass code handles */
+static bool
+aggrs_supported(int tp)
+{
+	switch (tp) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void
+aggrs_props(BAT *bn, BUN ngrp, BUN nils)
+{
+	BATsetcount(bn, ngrp);
+	bn->tkey = BATcount(bn) <= 1;
+	bn->tsorted = BATcount(bn) <= 1;
+	bn->trevsorted = BATcount(bn) <= 1;
+	bn->tnil = nils != 0;
+	bn->tnonil = nils == 0;
+}
+
+/* the minimum or maximum values (instead of positions) of the groups
+ * using the individual function */
+static BAT *
+aggrs_minmax(BAT *b, BAT *g, BAT *e, BAT *s, bool skip_nils,
+	     bool abort_on_error,
+	     BAT *(*minmax)(BAT *, BAT *, BAT *, BAT *, int, bool, bool))
+{
+	BAT *pn, *bn;
+
+	if ((pn = (*minmax)(b, g, e, s, TYPE_oid, skip_nils, abort_on_error)) == NULL)
+		return NULL;
+	bn = BATproject(pn, b);
+	BBPunfix(pn->batCacheid);
+	return bn;
+}
+
+gdk_return
+BATgroupaggrs(BAT **sump, int sumtp, BAT **cntp, BAT **minp, BAT **maxp,
+	      BAT **avgp, BAT *b, BAT *g, BAT *e, BAT *s,
+	      bool skip_nils, bool abort_on_error)
+{
+	const oid *restrict gids;
+	oid gid, min, max;
+	BUN i, ngrp, start, end;
+	BUN nils = 0;
+	const oid *cand = NULL, *candend = NULL;
+	const char *err;
+	lng *restrict cnts = NULL;
+	lng *restrict rows = NULL;
+	void *sums = NULL, *avgs = NULL;
+	BUN *restrict rems = NULL;
+	dbl *restrict dbls = NULL;
+	BAT *sn = NULL, *cn = NULL, *mn = NULL, *xn = NULL, *an = NULL;
+	bool dosum = sump != NULL;
+	lng t0 = 0;
+
+	if (sump)
+		*sump = NULL;
+	if (cntp)
+		*cntp = NULL;
+	if (minp)
+		*minp = NULL;
+	if (maxp)
+		*maxp = NULL;
+	if (avgp)
+		*avgp = NULL;
+
+	if ((err = BATgroupaggrinit(b, g, e, s, &min, &max, &ngrp, &start, &end,
+				    &cand, &candend)) != NULL) {
+		GDKerror("BATgroupaggrs: %s\n", err);
+		return GDK_FAIL;
+	}
+	if (g == NULL) {
+		GDKerror("BATgroupaggrs: b and g must be aligned\n");
+		return GDK_FAIL;
+	}
+
+	if (dosum &&
+	    (!ATOMlinear(sumtp) || ATOMstorage(sumtp) != sumtp ||
+	     sumtp == TYPE_flt || sumtp == TYPE_dbl || sumtp == TYPE_oid ||
+	     b->ttype == TYPE_flt || b->ttype == TYPE_dbl ||
+	     ATOMsize(sumtp) < ATOMsize(b->ttype))) {
+		/* floating point sums are calculated more precisely
+		 * than can be done here, and type combinations that
+		 * are not supported give an error there */
+		if ((*sump = BATgroupsum(b, g, e, s, sumtp, skip_nils, abort_on_error)) == NULL)
+			return GDK_FAIL;
+		dosum = false;
+	}
+
+	if (BATcount(b) == 0 || ngrp == 0 || !aggrs_supported(b->ttype)) {
+		/* trivial or not supported here: use the individual
+		 * functions */
+		if (dosum &&
+		    (*sump = BATgroupsum(b, g, e, s, sumtp, skip_nils, abort_on_error)) == NULL)
+			goto bailout;
+		if (cntp &&
+		    (*cntp = BATgroupcount(b, g, e, s, TYPE_lng, skip_nils, abort_on_error)) == NULL)
+			goto bailout;
+		if (minp &&
+		    (*minp = aggrs_minmax(b, g, e, s, skip_nils, abort_on_error, BATgroupmin)) == NULL)
+			goto bailout;
+		if (maxp &&
+		    (*maxp = aggrs_minmax(b, g, e, s, skip_nils, abort_on_error, BATgroupmax)) == NULL)
+			goto bailout;
+		if (avgp &&
+		    BATgroupavg(avgp, NULL, b, g, e, s, TYPE_dbl, skip_nils, abort_on_error, 0) != GDK_SUCCEED)
+			goto bailout;
+		return GDK_SUCCEED;
+	}
+
+	ALGODEBUG {
+		fprintf(stderr, "#BATgroupaggrs(b=" ALGOBATFMT ",g=" ALGOBATFMT
+			",s=" ALGOOPTBATFMT "):%s%s%s%s%s in one pass\n",
+			ALGOBATPAR(b), ALGOBATPAR(g), ALGOOPTBATPAR(s),
+			dosum ? " sum" : "", cntp ? " count" : "",
+			minp ? " min" : "", maxp ? " max" : "",
+			avgp ? " avg" : "");
+		t0 = GDKusec();
+	}
+
+	/* cnts is the number of non-nil values per group, or lng_nil
+	 * if the group contains a nil and we don't skip nils (in
+	 * which case all results for the group are nil); when
+	 * counting all values (not skipping nils), the number of rows
+	 * per group is maintained separately */
+	if (cntp && skip_nils) {
+		if ((cn = COLnew(min, TYPE_lng, ngrp, TRANSIENT)) == NULL)
+			goto alloc_fail;
+		cnts = (lng *) Tloc(cn, 0);
+		memset(cnts, 0, ngrp * sizeof(lng));
+	} else {
+		if ((cnts = GDKzalloc(ngrp * sizeof(lng))) == NULL)
+			goto alloc_fail;
+		if (cntp) {
+			if ((cn = COLnew(min, TYPE_lng, ngrp, TRANSIENT)) == NULL)
+				goto alloc_fail;
+			rows = (lng *) Tloc(cn, 0);
+			memset(rows, 0, ngrp * sizeof(lng));
+		}
+	}
+	if (dosum) {
+		if ((sn = COLnew(min, sumtp, ngrp, TRANSIENT)) == NULL ||
+		    (sums = GDKzalloc(ngrp * ATOMsize(TYPE_acc))) == NULL)
+			goto alloc_fail;
+	}
+	if (minp && (mn = COLnew(min, b->ttype, ngrp, TRANSIENT)) == NULL)
+		goto alloc_fail;
+	if (maxp && (xn = COLnew(min, b->ttype, ngrp, TRANSIENT)) == NULL)
+		goto alloc_fail;
+	if (avgp) {
+		if ((an = COLnew(min, TYPE_dbl, ngrp, TRANSIENT)) == NULL)
+			goto alloc_fail;
+		dbls = (dbl *) Tloc(an, 0);
+		if (b->ttype == TYPE_flt || b->ttype == TYPE_dbl) {
+			memset(dbls, 0, ngrp * sizeof(dbl));
+		} else if ((avgs = GDKzalloc(ngrp * ATOMsize(b->ttype))) == NULL ||
+			   (rems = GDKzalloc(ngrp * sizeof(BUN))) == NULL) {
+			goto alloc_fail;
+		}
+	}
+
+	if (BATtdense(g))
+		gids = NULL;
+	else
+		gids = (const oid *) Tloc(g, 0);
+
+	switch (b->ttype) {
+	case TYPE_bte:
+		AGGRS_LOOP(bte, AGGRS_SUM, AGGRS_AVG);
+		break;
+	case TYPE_sht:
+		AGGRS_LOOP(sht, AGGRS_SUM, AGGRS_AVG);
+		break;
+	case TYPE_int:
+		AGGRS_LOOP(int, AGGRS_SUM, AGGRS_AVG);
+		break;
+	case TYPE_lng:
+		AGGRS_LOOP(lng, AGGRS_SUM, AGGRS_AVG);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		AGGRS_LOOP(hge, AGGRS_SUM, AGGRS_AVG);
+		break;
+#endif
+	case TYPE_flt:
+		AGGRS_LOOP(flt, AGGRS_NOSUM, AGGRS_AVG_FLOAT);
+		break;
+	case TYPE_dbl:
+		AGGRS_LOOP(dbl, AGGRS_NOSUM, AGGRS_AVG_FLOAT);
+		break;
+	default:
+		assert(0);
+	}
+
+	/* nils is the number of groups with a nil result (other than
+	 * the count) */
+	if (mn)
+		aggrs_props(mn, ngrp, nils);
+	if (xn)
+		aggrs_props(xn, ngrp, nils);
+	if (an) {
+		switch (b->ttype) {
+		case TYPE_bte:
+			AGGRS_AVG_FINISH(bte);
+			break;
+		case TYPE_sht:
+			AGGRS_AVG_FINISH(sht);
+			break;
+		case TYPE_int:
+			AGGRS_AVG_FINISH(int);
+			break;
+		case TYPE_lng:
+			AGGRS_AVG_FINISH(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			AGGRS_AVG_FINISH(hge);
+			break;
+#endif
+		default:
+			/* floating point averages are complete,
+			 * except for the empty groups */
+			for (i = 0; i < ngrp; i++)
+				if (cnts[i] == 0 || is_lng_nil(cnts[i]))
+					dbls[i] = dbl_nil;
+			break;
+		}
+		aggrs_props(an, ngrp, nils);
+	}
+	if (sn) {
+		/* sums can also be nil because of overflow */
+		nils = 0;
+		switch (sumtp) {
+		case TYPE_bte:
+			AGGRS_SUM_FINISH(bte);
+			break;
+		case TYPE_sht:
+			AGGRS_SUM_FINISH(sht);
+			break;
+		case TYPE_int:
+			AGGRS_SUM_FINISH(int);
+			break;
+		case TYPE_lng:
+			AGGRS_SUM_FINISH(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			AGGRS_SUM_FINISH(hge);
+			break;
+#endif
+		default:
+			assert(0);
+		}
+		aggrs_props(sn, ngrp, nils);
+	}
+	if (cn) {
+		aggrs_props(cn, ngrp, 0);
+		cn->tnil = false;
+	}
+
+	GDKfree(sums);
+	GDKfree(avgs);
+	GDKfree(rems);
+	if (cn == NULL || rows != NULL)
+		GDKfree(cnts);
+	if (sn)
+		*sump = sn;
+	if (cn)
+		*cntp = cn;
+	if (mn)
+		*minp = mn;
+	if (xn)
+		*maxp = xn;
+	if (an)
+		*avgp = an;
+	ALGODEBUG fprintf(stderr, "#BATgroupaggrs: " BUNFMT " groups "
+			  "(" LLFMT " usec)\n", ngrp, GDKusec() - t0);
+	return GDK_SUCCEED;
+
+  alloc_fail:
+	GDKerror("BATgroupaggrs: cannot allocate enough memory.\n");
+	goto cleanup;
+  overflow:
+	GDKerror("22003!overflow in calculation.\n");
+  cleanup:
+	GDKfree(sums);
+	GDKfree(avgs);
+	GDKfree(rems);
+	if (cn == NULL || rows != NULL)
+		GDKfree(cnts);
+	BBPreclaim(sn);
+	BBPreclaim(cn);
+	BBPreclaim(mn);
+	BBPreclaim(xn);
+	BBPreclaim(an);
+  bailout:
+	if (sump && *sump) {
+		BBPunfix((*sump)->batCacheid);
+		*sump = NULL;
+	}
+	if (cntp && *cntp) {
+		BBPunfix((*cntp)->batCacheid);
+		*cntp = NULL;
+	}
+	if (minp && *minp) {
+		BBPunfix((*minp)->batCacheid);
+		*minp = NULL;
+	}
+	if (maxp && *maxp) {
+		BBPunfix((*maxp)->batCacheid);
+		*maxp = NULL;
+	}
+	if (avgp && *avgp) {
+		BBPunfix((*avgp)->batCacheid);
+		*avgp = NULL;
+	}
+	return GDK_FAIL;
+}
+
 /* ---------------------------------------------------------------------- */
 /* quantiles/median */
 
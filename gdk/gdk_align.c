@@ -124,8 +124,11 @@ VIEWcreate(oid seq, BAT *b)
 	BATinit_idents(bn);
 	bn->batRestricted = BAT_READ;
 	bn->thash = NULL;
+	bn->tbhash = NULL;
+	bn->tmask = NULL;
 	/* imprints are shared, but the check is dynamic */
 	bn->timprints = NULL;
+	bn->tzonemap = NULL;
 	/* Order OID index */
 	bn->torderidx = NULL;
 	if (BBPcacheit(bn, 1) != GDK_SUCCEED) {	/* enter in BBP */
@@ -175,6 +178,7 @@ BATmaterialize(BAT *b)
 	/* cleanup possible ACC's */
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	BHASHdestroy(b);
 	OIDXdestroy(b);
 
 	snprintf(b->theap.filename, sizeof(b->theap.filename), "%s.tail", BBP_physical(b->batCacheid));
@@ -412,6 +416,7 @@ VIEWdestroy(BAT *b)
 	/* remove any leftover private hash structures */
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	BHASHdestroy(b);
 	OIDXdestroy(b);
 	VIEWunlink(b);
 
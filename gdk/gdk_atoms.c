@@ -1221,10 +1221,15 @@ strLocate(Heap *h, const char *v)
 	/* search hash-table, if double-elimination is still in place */
 	BUN off;
 	GDK_STRHASH(v, off);
-	off &= GDK_STRHASHMASK;
 
 	/* should only use strLocate iff fully double eliminated */
-	assert(GDK_ELIMBASE(h->free) == 0);
+	assert(GDK_ELIMALL(h));
+
+	if (h->dict) {
+		/* large string heap: search the dictionary */
+		return STRDICTlocate(h, v, off);
+	}
+	off &= GDK_STRHASHMASK;
 
 	/* search the linked list */
 	for (ref = ((stridx_t *) h->base) + off; *ref; ref = next) {
@@ -1250,7 +1255,16 @@ strPut(Heap *h, var_t *dst, const char *v)
 	off &= GDK_STRHASHMASK;
 	bucket = ((stridx_t *) h->base) + off;
 
-	if (*bucket) {
+	if (h->dict) {
+		/* large string heap (>=64KiB) with a dictionary --
+		 * still fully double eliminated: search the
+		 * dictionary */
+		h->dict->puts++;
+		if ((pos = STRDICTlocate(h, v, strhash)) != 0) {
+			h->dict->hits++;
+			return *dst = (var_t) pos;
+		}
+	} else if (*bucket) {
 		/* the hash list is not empty */
 		if (*bucket < GDK_ELIMLIMIT) {
 			/* small string heap (<64KiB) -- fully double
@@ -1401,6 +1415,15 @@ strPut(Heap *h, var_t *dst, const char *v)
 	}
 	*bucket = (stridx_t) pos;	/* set bucket to the new string */
 
+	if (h->dict) {
+		STRDICTinsert(h, *dst, strhash);
+	} else if (elimbase == 0 && h->free >= GDK_ELIMLIMIT &&
+		   GDK_strdict != 0) {
+		/* the heap just outgrew the hash table at its start:
+		 * continue double elimination with a dictionary */
+		if (STRDICTcreate(h) != GDK_SUCCEED)
+			GDKclrerr();
+	}
 	return *dst;
 }
 
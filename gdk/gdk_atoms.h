@@ -298,6 +298,9 @@ gdk_export const ptr ptr_nil;
  * Note that a 64KiB chunk of the heap contains at most 8K 8-byte
  * aligned strings. The 1K bucket list means that in worst load, the
  * list length is 8 (OK).
+ * - when a heap grows past 64KiB, it gets a string dictionary (see
+ *   gdk_strdict.c) with which it stays fully duplicate eliminated,
+ *   unless the dictionary is given up on (gdk_strdict option)
  */
 #define GDK_STRHASHTABLE	(1<<10)	/* 1024 */
 #define GDK_STRHASHMASK		(GDK_STRHASHTABLE-1)
@@ -307,6 +310,12 @@ gdk_export const ptr ptr_nil;
 #define GDK_ELIMLIMIT		(1<<GDK_ELIMPOWER)	/* equivalently: ELIMBASE == 0 */
 #define GDK_ELIMBASE(x)		(((x) >> GDK_ELIMPOWER) << GDK_ELIMPOWER)
 #define GDK_VAROFFSET		((var_t) GDK_STRHASHSIZE)
+/* the heap has a string dictionary, so it is fully duplicate
+ * eliminated at any size */
+#define GDK_ELIMDICT(h)		((h)->dict != NULL)
+/* the heap contains each string only once, so that strings in it are
+ * equal if and only if their offsets are */
+#define GDK_ELIMALL(h)		(GDK_ELIMDOUBLES(h) || GDK_ELIMDICT(h))
 
 /*
  * @- String Comparison, NILs and UTF-8
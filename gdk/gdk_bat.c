@@ -42,6 +42,7 @@
 #include "monetdb_config.h"
 #include "gdk.h"
 #include "gdk_private.h"
+#include "gdk_cand.h"
 
 #ifdef ALIGN
 #undef ALIGN
@@ -450,6 +451,9 @@ BATextend(BAT *b, BUN newcap)
 	 * otherwise you may easily corrupt the administration of
 	 * malloc.
 	 */
+	CANDMASKdestroy(b);
+	if (b->tmask)
+		return GDK_FAIL;
 	if (newcap <= BATcapacity(b)) {
 		return GDK_SUCCEED;
 	}
@@ -464,6 +468,7 @@ BATextend(BAT *b, BUN newcap)
 		return GDK_FAIL;
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	BHASHdestroy(b);
 	OIDXdestroy(b);
 	return GDK_SUCCEED;
 }
@@ -495,7 +500,10 @@ BATclear(BAT *b, bool force)
 	/* kill all search accelerators */
 	HASHdestroy(b);
 	IMPSdestroy(b);
+	ZONEdestroy(b);
+	BHASHdestroy(b);
 	OIDXdestroy(b);
+	CANDMASKfree(b);
 	PROPdestroy(b);
 
 	/* we must dispose of all inserted atoms */
@@ -562,7 +570,10 @@ BATfree(BAT *b)
 	PROPdestroy(b);
 	HASHfree(b);
 	IMPSfree(b);
+	ZONEdestroy(b);
+	BHASHfree(b);
 	OIDXfree(b);
+	CANDMASKfree(b);
 	if (b->ttype)
 		HEAPfree(&b->theap, false);
 	else
@@ -1047,7 +1058,9 @@ BUNappend(BAT *b, const void *t, bool force)
 
 
 	IMPSdestroy(b); /* no support for inserts in imprints yet */
+	BHASHdestroy(b);
 	OIDXdestroy(b);
+	CANDMASKdestroy(b);
 	PROPdestroy(b);
 	if (b->thash == (Hash *) 1 ||
 	    (b->thash && ((size_t *) b->thash->heap.base)[0] & (1 << 24))) {
@@ -1113,6 +1126,9 @@ BUNdelete(BAT *b, oid o)
 		}
 	}
 	IMPSdestroy(b);
+	ZONEdestroy(b);
+	BHASHdestroy(b);
+	CANDMASKdestroy(b);
 	OIDXdestroy(b);
 	HASHdestroy(b);
 	PROPdestroy(b);
@@ -1161,6 +1177,9 @@ BUNinplace(BAT *b, BUN p, const void *t, bool force)
 	PROPdestroy(b);
 	OIDXdestroy(b);
 	IMPSdestroy(b);
+	ZONEdestroy(b);
+	BHASHdestroy(b);
+	CANDMASKdestroy(b);
 	if (b->tvarsized && b->ttype) {
 		var_t _d;
 		ptr _ptr;
@@ -1448,6 +1467,9 @@ BATsetcount(BAT *b, BUN cnt)
 	assert(!is_oid_nil(b->hseqbase));
 	assert(cnt <= BUN_MAX);
 
+	/* the zone map is only maintained for appends */
+	if (cnt < b->batCount)
+		ZONEdestroy(b);
 	b->batCount = cnt;
 	b->batDirtydesc = true;
 	b->theap.free = tailsize(b, cnt);
@@ -2084,6 +2106,15 @@ BATassertProps(BAT *b)
 	       b->tvheap == NULL ||
 	       (BBPfarms[b->tvheap->farmid].roles & (1 << b->batRole)));
 
+	if (b->tmask && !b->tmask->materialized) {
+		/* compressed candidate list without tail heap */
+		assert(b->ttype == TYPE_oid);
+		assert(b->tsorted && b->tkey && b->tnonil && !b->tnil);
+		assert(is_oid_nil(b->tseqbase));
+		assert(candmask_count(b->tmask, b->tmask->first, b->tmask->first + b->tmask->nbits) == b->batCount);
+		return;
+	}
+
 	cmpf = ATOMcompare(b->ttype);
 	nilp = ATOMnilptr(b->ttype);
 
@@ -78,6 +78,7 @@ insert_string_bat(BAT *b, BAT *n, BAT *s, bool force)
 	if (cnt == 0)
 		return GDK_SUCCEED;
 	if ((!GDK_ELIMDOUBLES(b->tvheap) || b->batCount == 0) &&
+	    !GDK_ELIMDICT(b->tvheap) &&
 	    !GDK_ELIMDOUBLES(n->tvheap) &&
 	    b->tvheap->hashash == n->tvheap->hashash) {
 		if (b->batRole == TRANSIENT || b->tvheap == n->tvheap) {
@@ -174,6 +175,12 @@ insert_string_bat(BAT *b, BAT *n, BAT *s, bool force)
 					 * hash table */
 					memset(b->tvheap->base, 0,
 					       GDK_STRHASHSIZE);
+				} else if (STRDICTcopy(b->tvheap, n->tvheap) != GDK_SUCCEED) {
+					/* b's heap is an exact copy
+					 * of n's, so it can have a
+					 * copy of n's dictionary, but
+					 * it can also do without */
+					GDKclrerr();
 				}
 			}
 		}
@@ -313,7 +320,7 @@ insert_string_bat(BAT *b, BAT *n, BAT *s, bool force)
 		b->tvarsized = true;
 		b->ttype = TYPE_str;
 	} else if (b->tvheap->free < n->tvheap->free / 2 ||
-		   GDK_ELIMDOUBLES(b->tvheap)) {
+		   GDK_ELIMALL(b->tvheap)) {
 		/* if b's string heap is much smaller than n's string
 		 * heap, don't bother checking whether n's string
 		 * values occur in b's string heap; also, if b is
@@ -454,6 +461,7 @@ append_varsized_bat(BAT *b, BAT *n, BAT *s)
 		/* if b and n use the same vheap, we only need to copy
 		 * the offsets from n to b */
 		HASHdestroy(b);	/* not maintaining, so destroy it */
+		BHASHdestroy(b);
 		if (cand == NULL) {
 			/* fast memcpy since we copy a consecutive
 			 * chunk of memory */
@@ -599,7 +607,9 @@ BATappend(BAT *b, BAT *n, BAT *s, bool force)
 	b->batDirtydesc = true;
 
 	IMPSdestroy(b);		/* imprints do not support updates yet */
+	BHASHdestroy(b);
 	OIDXdestroy(b);
+	CANDMASKdestroy(b);
 	PROPdestroy(b);
 	if (b->thash == (Hash *) 1 || BATcount(b) == 0 ||
 	    (b->thash && ((size_t *) b->thash->heap.base)[0] & (1 << 24))) {
@@ -1308,6 +1318,253 @@ do_sort(void *restrict h, void *restrict t, const void *restrict base,
 	return GDK_SUCCEED;
 }
 
+/* Parallel sort of fixed size values (and the accompanying oids).
+ * The values are cut into nthreads consecutive slices which are
+ * sorted by separate threads using do_sort, after which pairs of
+ * adjacent runs are merged, again in parallel, until a single run
+ * remains.  When two values compare equal, the merge takes the one
+ * from the left run, so if the slices are sorted stably, the result
+ * is the stable sort order of the whole, i.e. exactly what the
+ * serial stable sort produces. */
+#define SORT_PAR_MIN	((size_t) 1 << 16) /* min nr of values per thread */
+
+struct sortpar {
+	char *h, *t;		/* sort: slice; merge: destination */
+	const char *h0, *t0;	/* merge: left run */
+	const char *h1, *t1;	/* merge: right run */
+	size_t n, n0, n1;
+	int hs, ts, tpe;
+	bool reverse, stable, merge, failed;
+	MT_Id tid;
+	bool started;
+};
+
+/* less than or equal, taking the direction of the sort into account;
+ * nil is the smallest value */
+#define SORTLE(a, b)	(sp->reverse ? (a) >= (b) : (a) <= (b))
+#define SORTLEflt(a, b)							\
+	(sp->reverse ?							\
+	 is_flt_nil(b) || (!is_flt_nil(a) && (a) >= (b)) :		\
+	 is_flt_nil(a) || (!is_flt_nil(b) && (a) <= (b)))
+#define SORTLEdbl(a, b)							\
+	(sp->reverse ?							\
+	 is_dbl_nil(b) || (!is_dbl_nil(a) && (a) >= (b)) :		\
+	 is_dbl_nil(a) || (!is_dbl_nil(b) && (a) <= (b)))
+
+#define SORT_MERGE(TYPE, LE)						\
+	do {								\
+		const TYPE *restrict v0 = (const TYPE *) sp->h0;	\
+		const TYPE *restrict v1 = (const TYPE *) sp->h1;	\
+		TYPE *restrict v = (TYPE *) sp->h;			\
+		while (i0 < sp->n0 && i1 < sp->n1) {			\
+			if (LE(v0[i0], v1[i1])) {			\
+				if (o)					\
+					o[i] = o0[i0];			\
+				v[i++] = v0[i0++];			\
+			} else {					\
+				if (o)					\
+					o[i] = o1[i1];			\
+				v[i++] = v1[i1++];			\
+			}						\
+		}							\
+	} while (0)
+
+static void
+SORTparworker(void *arg)
+{
+	struct sortpar *sp = arg;
+	const oid *restrict o0, *restrict o1;
+	oid *restrict o;
+	size_t i = 0, i0 = 0, i1 = 0;
+
+	if (!sp->merge) {
+		sp->failed = do_sort(sp->h, sp->t, NULL, sp->n, sp->hs, sp->ts,
+				     sp->tpe, sp->reverse, sp->stable) != GDK_SUCCEED;
+		return;
+	}
+	o0 = (const oid *) sp->t0;
+	o1 = (const oid *) sp->t1;
+	o = (oid *) sp->t;
+	switch (ATOMbasetype(sp->tpe)) {
+	case TYPE_bte:
+		SORT_MERGE(bte, SORTLE);
+		break;
+	case TYPE_sht:
+		SORT_MERGE(sht, SORTLE);
+		break;
+	case TYPE_int:
+		SORT_MERGE(int, SORTLE);
+		break;
+	case TYPE_lng:
+		SORT_MERGE(lng, SORTLE);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		SORT_MERGE(hge, SORTLE);
+		break;
+#endif
+	case TYPE_flt:
+		SORT_MERGE(flt, SORTLEflt);
+		break;
+	case TYPE_dbl:
+		SORT_MERGE(dbl, SORTLEdbl);
+		break;
+	default:
+		assert(0);
+	}
+	/* copy what remains of either run */
+	if (i0 < sp->n0) {
+		memcpy(sp->h + i * sp->hs, sp->h0 + i0 * sp->hs,
+		       (sp->n0 - i0) * sp->hs);
+		if (o)
+			memcpy(o + i, o0 + i0, (sp->n0 - i0) * sizeof(oid));
+	} else if (i1 < sp->n1) {
+		memcpy(sp->h + i * sp->hs, sp->h1 + i1 * sp->hs,
+		       (sp->n1 - i1) * sp->hs);
+		if (o)
+			memcpy(o + i, o1 + i1, (sp->n1 - i1) * sizeof(oid));
+	}
+}
+
+/* run the first n tasks, the calling thread doing the first */
+static void
+SORTparrun(struct sortpar *sp, int n)
+{
+	int i;
+
+	for (i = 1; i < n; i++)
+		sp[i].started = MT_create_thread(&sp[i].tid, SORTparworker,
+						 &sp[i], MT_THR_JOINABLE) == 0;
+	SORTparworker(&sp[0]);
+	for (i = 1; i < n; i++) {
+		if (sp[i].started)
+			MT_join_thread(sp[i].tid);
+		else
+			SORTparworker(&sp[i]); /* couldn't start thread */
+	}
+}
+
+/* like do_sort, but use up to nthreads threads for large inputs of
+ * fixed size values; ts is either 0 (no oids) or sizeof(oid) */
+static gdk_return
+do_sort_par(void *restrict h, void *restrict t, const void *restrict base,
+	    size_t n, int hs, int ts, int tpe, bool reverse, bool stable,
+	    int nthreads)
+{
+	struct sortpar *sp;
+	size_t *bounds;
+	char *hbuf, *tbuf = NULL;
+	char *hsrc, *tsrc, *hdst, *tdst;
+	int i, j, nruns;
+
+	if ((size_t) nthreads > n / SORT_PAR_MIN)
+		nthreads = (int) (n / SORT_PAR_MIN);
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		if (base == NULL && !ATOMvarsized(tpe) &&
+		    hs == ATOMsize(ATOMbasetype(tpe)) &&
+		    (ts == 0 || ts == (int) sizeof(oid)))
+			break;
+		/* fall through */
+	default:
+		nthreads = 1;
+		break;
+	}
+	if (nthreads <= 1)
+		return do_sort(h, t, base, n, hs, ts, tpe, reverse, stable);
+
+	sp = GDKzalloc(nthreads * sizeof(struct sortpar));
+	bounds = GDKmalloc((nthreads + 1) * sizeof(size_t));
+	hbuf = GDKmalloc(n * hs);
+	if (ts)
+		tbuf = GDKmalloc(n * ts);
+	if (sp == NULL || bounds == NULL || hbuf == NULL || (ts && tbuf == NULL)) {
+		GDKfree(sp);
+		GDKfree(bounds);
+		GDKfree(hbuf);
+		GDKfree(tbuf);
+		return GDK_FAIL;
+	}
+
+	/* sort the slices in place */
+	for (i = 0; i <= nthreads; i++)
+		bounds[i] = (size_t) ((ulng) n * i / nthreads);
+	for (i = 0; i < nthreads; i++) {
+		sp[i] = (struct sortpar) {
+			.h = (char *) h + bounds[i] * hs,
+			.t = ts ? (char *) t + bounds[i] * ts : NULL,
+			.n = bounds[i + 1] - bounds[i],
+			.hs = hs,
+			.ts = ts,
+			.tpe = tpe,
+			.reverse = reverse,
+			.stable = stable,
+		};
+	}
+	SORTparrun(sp, nthreads);
+	for (i = 0; i < nthreads; i++) {
+		if (sp[i].failed) {
+			GDKfree(sp);
+			GDKfree(bounds);
+			GDKfree(hbuf);
+			GDKfree(tbuf);
+			return GDK_FAIL;
+		}
+	}
+
+	/* merge pairs of adjacent runs, flipping between the input
+	 * and the buffers; a run without a partner is copied along */
+	hsrc = h;
+	tsrc = t;
+	hdst = hbuf;
+	tdst = tbuf;
+	for (nruns = nthreads; nruns > 1; nruns = (nruns + 1) / 2) {
+		for (i = j = 0; i < nruns; i += 2, j++) {
+			size_t hi = i + 1 < nruns ? bounds[i + 2] : bounds[i + 1];
+			sp[j] = (struct sortpar) {
+				.merge = true,
+				.h0 = hsrc + bounds[i] * hs,
+				.t0 = ts ? tsrc + bounds[i] * ts : NULL,
+				.n0 = bounds[i + 1] - bounds[i],
+				.h1 = hsrc + bounds[i + 1] * hs,
+				.t1 = ts ? tsrc + bounds[i + 1] * ts : NULL,
+				.n1 = hi - bounds[i + 1],
+				.h = hdst + bounds[i] * hs,
+				.t = ts ? tdst + bounds[i] * ts : NULL,
+				.hs = hs,
+				.ts = ts,
+				.tpe = tpe,
+				.reverse = reverse,
+			};
+			bounds[j] = bounds[i];
+		}
+		bounds[j] = n;
+		SORTparrun(sp, j);
+		hsrc = hdst;
+		tsrc = tdst;
+		hdst = hdst == hbuf ? h : hbuf;
+		tdst = tdst == tbuf ? t : tbuf;
+	}
+	if (hsrc != h) {
+		memcpy(h, hsrc, n * hs);
+		if (ts)
+			memcpy(t, tsrc, n * ts);
+	}
+	GDKfree(sp);
+	GDKfree(bounds);
+	GDKfree(hbuf);
+	GDKfree(tbuf);
+	return GDK_SUCCEED;
+}
+
 /* Sort the bat b according to both o and g.  The stable and reverse
  * parameters indicate whether the sort should be stable or descending
  * respectively.  The parameter b is required, o and g are optional
@@ -1342,10 +1599,24 @@ do_sort(void *restrict h, void *restrict t, const void *restrict base,
  *	BATsort(&col2s, &ord2, &grp2, col2, ord1, grp1, false, false);
  *	BATsort(&col3s,  NULL,  NULL, col3, ord2, grp2, false, false);
  * Note that the "reverse" parameter can be different for each call.
+ *
+ * BATsortthreads is BATsort with an explicit upper bound on the
+ * number of threads that are used to sort large columns of fixed
+ * size numeric values when no groups are given.  The result is
+ * independent of the number of threads used.
  */
 gdk_return
 BATsort(BAT **sorted, BAT **order, BAT **groups,
 	   BAT *b, BAT *o, BAT *g, bool reverse, bool stable)
+{
+	return BATsortthreads(sorted, order, groups, b, o, g, reverse, stable,
+			      GDKnr_threads);
+}
+
+gdk_return
+BATsortthreads(BAT **sorted, BAT **order, BAT **groups,
+	       BAT *b, BAT *o, BAT *g, bool reverse, bool stable,
+	       int nthreads)
 {
 	BAT *bn = NULL, *on = NULL, *gn = NULL, *pb = NULL;
 	oid *restrict grps, *restrict ords, prev;
@@ -1491,7 +1762,7 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 				goto error;
 			bn->tsorted = true;
 			if (groups) {
-				if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true) != GDK_SUCCEED)
+				if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true, GDKnr_threads) != GDK_SUCCEED)
 					goto error;
 				if (sorted &&
 				    (*groups)->tkey &&
@@ -1680,11 +1951,11 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 		}
 		if (!(reverse ? bn->trevsorted : bn->tsorted) &&
 		    (BATmaterialize(bn) != GDK_SUCCEED ||
-		     do_sort(Tloc(bn, 0),
-			     ords,
-			     bn->tvheap ? bn->tvheap->base : NULL,
-			     BATcount(bn), Tsize(bn), ords ? sizeof(oid) : 0,
-			     bn->ttype, reverse, stable) != GDK_SUCCEED)) {
+		     do_sort_par(Tloc(bn, 0),
+				 ords,
+				 bn->tvheap ? bn->tvheap->base : NULL,
+				 BATcount(bn), Tsize(bn), ords ? sizeof(oid) : 0,
+				 bn->ttype, reverse, stable, nthreads) != GDK_SUCCEED)) {
 			if (m != NULL) {
 				HEAPfree(m, true);
 				GDKfree(m);
@@ -1716,7 +1987,7 @@ BATsort(BAT **sorted, BAT **order, BAT **groups,
 	bn->tnorevsorted = 0;
 	bn->tnokey[0] = bn->tnokey[1] = 0;
 	if (groups) {
-		if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true) != GDK_SUCCEED)
+		if (BATgroup_internal(groups, NULL, NULL, bn, NULL, g, NULL, NULL, true, GDKnr_threads) != GDK_SUCCEED)
 			goto error;
 		if ((*groups)->tkey &&
 		    (g == NULL || (g->tsorted && g->trevsorted))) {
@@ -2251,3 +2522,122 @@ BATintersectcand(BAT *a, BAT *b)
 	bn->tnonil = true;
 	return virtualize(bn);
 }
+
+/* Compressed candidate lists.
+ *
+ * A candidate list with many candidates that are close together
+ * (mid-selectivity filters) is cheaper to carry around as a bitmap
+ * than as an array of oids: at a density of 1/16 the bitmap is a
+ * quarter of the size of the oids, and when every other value
+ * qualifies it is a 128th.  BATcandcompress replaces the tail heap of
+ * the candidate list s by such a bitmap (a CandMask) if that is worth
+ * it; the BAT otherwise remains a normal (non-dense) candidate list.
+ * Code that understands the mask (BATselect and BATproject on fixed
+ * size types) iterates over the bits, everybody else gets the oids
+ * back through BATcandmaterialize, which is done automatically by
+ * BATdescriptor.  Note that s must not be used by code that looks at
+ * the tail heap directly after it has been compressed. */
+#define CANDMASK_MINCOUNT	4096
+#define CANDMASK_SPARSE		16	/* at least one in so many bits set */
+
+void
+BATcandcompress(BAT *s)
+{
+	CandMask *m;
+	const oid *restrict o;
+	oid first;
+	BUN i, n, nbits, nwords;
+
+	if (s == NULL || s->ttype != TYPE_oid || s->tmask != NULL ||
+	    isVIEW(s) || s->batSharecnt > 0 ||
+	    (n = BATcount(s)) < CANDMASK_MINCOUNT)
+		return;
+	assert(s->tsorted);
+	assert(s->tkey);
+	o = (const oid *) Tloc(s, 0);
+	first = o[0];
+	nbits = (BUN) (o[n - 1] - first + 1);
+	if (nbits / CANDMASK_SPARSE > n)
+		return;
+	nwords = (nbits + 63) / 64;
+	if ((m = GDKmalloc(sizeof(CandMask) + nwords * sizeof(uint64_t))) == NULL) {
+		/* not fatal, we just don't compress */
+		GDKclrerr();
+		return;
+	}
+	m->first = first;
+	m->nbits = nbits;
+	m->materialized = false;
+	m->bits = (uint64_t *) (m + 1);
+	memset(m->bits, 0, nwords * sizeof(uint64_t));
+	for (i = 0; i < n; i++) {
+		BUN b = (BUN) (o[i] - first);
+		m->bits[b >> 6] |= (uint64_t) 1 << (b & 63);
+	}
+	ALGODEBUG fprintf(stderr, "#BATcandcompress(s=" ALGOBATFMT "): "
+			  "mask of " BUNFMT " bits\n", ALGOBATPAR(s), nbits);
+	HEAPfree(&s->theap, true);
+	s->theap.storage = s->theap.newstorage = STORE_MEM;
+	s->theap.size = 0;
+	s->theap.free = 0;
+	s->batCapacity = 0;
+	s->tmask = m;
+}
+
+/* make sure the tail heap of a compressed candidate list contains the
+ * oids; the mask is kept so that it can still be used */
+gdk_return
+BATcandmaterialize(BAT *s)
+{
+	CandMask *m;
+	struct candmaskiter ci;
+	oid *restrict o;
+	BUN i, n;
+	gdk_return rc = GDK_SUCCEED;
+
+	if (s == NULL || (m = s->tmask) == NULL || m->materialized)
+		return GDK_SUCCEED;
+	MT_lock_set(&GDKhashLock(s->batCacheid));
+	if (!m->materialized) {
+		n = BATcount(s);
+		if (HEAPalloc(&s->theap, n, sizeof(oid)) != GDK_SUCCEED) {
+			rc = GDK_FAIL;
+		} else {
+			o = (oid *) s->theap.base;
+			candmask_init(&ci, m, m->first);
+			for (i = 0; i < n; i++)
+				o[i] = candmask_next(&ci);
+			s->theap.free = n * sizeof(oid);
+			s->theap.dirty = true;
+			s->batCapacity = (BUN) (s->theap.size >> s->tshift);
+			m->materialized = true;
+			ALGODEBUG fprintf(stderr, "#BATcandmaterialize(s="
+					  ALGOBATFMT ")\n", ALGOBATPAR(s));
+		}
+	}
+	MT_lock_unset(&GDKhashLock(s->batCacheid));
+	return rc;
+}
+
+/* the candidate list is about to be changed: keep the oids, lose the
+ * mask */
+void
+CANDMASKdestroy(BAT *b)
+{
+	if (b && b->tmask) {
+		if (BATcandmaterialize(b) != GDK_SUCCEED)
+			return;
+		CANDMASKfree(b);
+	}
+}
+
+void
+CANDMASKfree(BAT *b)
+{
+	if (b && b->tmask) {
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		GDKfree(b->tmask);
+		b->tmask = NULL;
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+	}
+}
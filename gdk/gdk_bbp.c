@@ -24,7 +24,10 @@
  *
  * @item persistence
  * The BBP is made persistent by saving it to the dictionary file
- * called @emph{BBP.dir} in the database.
+ * called @emph{BBP.dir} in the database.  Subcommits record the
+ * entries of the BATs they commit in @emph{BBP.dlt}, which overrides
+ * BBP.dir, until that file is merged into a new BBP.dir (see
+ * BBPdir_delta).
  *
  * When the number of BATs rises, having all files in one directory
  * becomes a bottleneck.  The BBP therefore implements a scheme that
@@ -117,7 +120,8 @@ static void BBPuncacheit(bat bid, bool unloaddesc);
 static gdk_return BBPprepare(bool subcommit);
 static BAT *getBBPdescriptor(bat i, bool lock);
 static gdk_return BBPbackup(BAT *b, bool subcommit);
-static gdk_return BBPdir(int cnt, bat *subcommit);
+static gdk_return BBPdir(int cnt, bat *subcommit, ulng *hashes);
+static void BBPmanager(void *dummy);
 
 #ifdef HAVE_HGE
 /* start out by saying we have no hge, but as soon as we've seen one,
@@ -244,6 +248,18 @@ static volatile MT_Id locked_by = 0;
 static int BBPunloadCnt = 0;
 static MT_Lock GDKunloadLock MT_LOCK_INITIALIZER("GDKunloadLock");
 
+/* The BBP manager thread advances the BBP clock once every
+ * BBPMANAGER_INTERVAL milliseconds, and halves the heat of all BATs
+ * once every BBP_HEATDECAY ticks.  BBPfix stamps the BAT with the
+ * clock and increments its heat, so the heat of a BAT is roughly the
+ * number of times it was used recently. */
+#define BBPMANAGER_INTERVAL	1000
+#define BBP_HEATDECAY		8
+#define BBP_MAXHEAT		(1U << 30)
+/* BATs with at most this heat are cold */
+#define BBP_COLDHEAT		2
+static volatile unsigned BBPclock = 0;
+
 void
 BBPlock(void)
 {
@@ -377,6 +393,25 @@ BBPextend(int idx, bool buildhash)
 	return GDK_SUCCEED;
 }
 
+static bool file_exists(int farmid, const char *dir, const char *name, const char *ext);
+
+/* move BBP.dlt from srcdir to dstdir, if it is there */
+static gdk_return
+move_dlt(int farmid, const char *srcdir, const char *dstdir)
+{
+	if (!file_exists(farmid, srcdir, "BBP", "dlt"))
+		return GDK_SUCCEED;
+	return GDKmove(farmid, srcdir, "BBP", "dlt", dstdir, "BBP", "dlt");
+}
+
+/* BBP.dlt is backed up together with, and before, BBP.dir (see
+ * BBPprepare), so it must be restored before BBP.dir */
+static gdk_return
+recover_dlt(int farmid)
+{
+	return move_dlt(farmid, BAKDIR, BATDIR);
+}
+
 static gdk_return
 recover_dir(int farmid, bool direxists)
 {
@@ -1014,15 +1049,126 @@ vheapinit(BAT *b, const char *buf, int hashash, bat bid, const char *filename)
 	return n;
 }
 
+/*
+ * BBP.dlt has the same entries as BBP.dir, preceded by a header of
+ * two lines: the version and the BBPsize at the time it was written.
+ * Its entries replace those of BBP.dir with the same BAT id; an entry
+ * "-<id>" means that the BAT is no longer persistent.  Both files are
+ * sorted on BAT id, so the combination is read with a merge.  An
+ * empty BBP.dlt is the same as none.
+ */
+typedef struct {
+	FILE *dir, *dlt;	/* positioned after their headers */
+	int dirbid, dltbid;	/* id of buffered entry, 0 at end */
+	bool removed;		/* return "-<id>" entries of BBP.dlt */
+	char dirbuf[4096];
+	char dltbuf[4096];
+} bbpdirstream;
+
+static int
+BBPdir_read(FILE *fp, char *buf, size_t len)
+{
+	int bid;
+
+	if (fp == NULL || fgets(buf, (int) len, fp) == NULL)
+		return 0;
+	if (sscanf(buf, "%d", &bid) != 1 || bid == 0)
+		GDKfatal("BBPdir: invalid entry in BBP.dir or BBP.dlt\n%s", buf);
+	return bid;
+}
+
 static void
-BBPreadEntries(FILE *fp, unsigned bbpversion)
+BBPdir_open(bbpdirstream *s, FILE *dir, FILE *dlt, bool removed)
+{
+	s->dir = dir;
+	s->dlt = dlt;
+	s->removed = removed;
+	s->dirbid = BBPdir_read(dir, s->dirbuf, sizeof(s->dirbuf));
+	s->dltbid = BBPdir_read(dlt, s->dltbuf, sizeof(s->dltbuf));
+}
+
+/* copy the next entry into buf and return its BAT id, or return 0 at
+ * the end; the id of a "-<id>" entry is negative */
+static int
+BBPdir_next(bbpdirstream *s, char *buf, size_t len)
+{
+	int bid;
+
+	for (;;) {
+		if (s->dltbid != 0 &&
+		    (s->dirbid == 0 || abs(s->dltbid) <= s->dirbid)) {
+			bid = s->dltbid;
+			if (abs(bid) == s->dirbid) {
+				/* skip the entry it replaces */
+				s->dirbid = BBPdir_read(s->dir, s->dirbuf,
+							sizeof(s->dirbuf));
+			}
+			snprintf(buf, len, "%s", s->dltbuf);
+			s->dltbid = BBPdir_read(s->dlt, s->dltbuf,
+						sizeof(s->dltbuf));
+			if (bid > 0 || s->removed)
+				return bid;
+		} else if (s->dirbid != 0) {
+			bid = s->dirbid;
+			snprintf(buf, len, "%s", s->dirbuf);
+			s->dirbid = BBPdir_read(s->dir, s->dirbuf,
+						sizeof(s->dirbuf));
+			return bid;
+		} else {
+			return 0;
+		}
+	}
+}
+
+/* open dir/BBP.dlt and read its header; return NULL if there is no
+ * (or an empty) BBP.dlt, else set *n to the BBPsize in the header */
+static FILE *
+BBPdelta_open(const char *dir, int *n)
+{
+	FILE *fp;
+	char buf[BUFSIZ];
+	unsigned version;
+
+	if (!file_exists(0, dir, "BBP", "dlt"))
+		return NULL;
+	if ((fp = GDKfileopen(0, dir, "BBP", "dlt", "r")) == NULL)
+		GDKfatal("BBPdir: cannot open %s%cBBP.dlt", dir, DIR_SEP);
+	if (fgets(buf, sizeof(buf), fp) == NULL) {
+		fclose(fp);
+		return NULL;
+	}
+	if (sscanf(buf, "BBP.dlt, GDKversion %u\n", &version) != 1 ||
+	    version != GDKLIBRARY ||
+	    fgets(buf, sizeof(buf), fp) == NULL ||
+	    sscanf(buf, "BBPsize=%d", n) != 1)
+		GDKfatal("BBPdir: invalid header in %s%cBBP.dlt", dir, DIR_SEP);
+	return fp;
+}
+
+/* hash value (FNV-1a) of a BBP.dir entry; BBP_dirhash(i) is that of
+ * the committed entry of bat i, or 0 if there is none, so that a
+ * subcommit only needs to write the entries that changed */
+static ulng
+BBPentryhash(const char *s)
+{
+	ulng h = UINT64_C(14695981039346656037);
+
+	while (*s) {
+		h ^= (unsigned char) *s++;
+		h *= UINT64_C(1099511628211);
+	}
+	return h == 0 ? 1 : h;
+}
+
+static void
+BBPreadEntries(bbpdirstream *bs, unsigned bbpversion)
 {
 	bat bid = 0;
 	char buf[4096];
 	BAT *bn;
 
 	/* read the BBP.dir and insert the BATs into the BBP */
-	while (fgets(buf, sizeof(buf), fp) != NULL) {
+	while (BBPdir_next(bs, buf, sizeof(buf)) != 0) {
 		uint64_t batid;
 		uint16_t status;
 		char headname[129];
@@ -1039,6 +1185,7 @@ BBPreadEntries(FILE *fp, unsigned bbpversion)
 		uint16_t map_head = 0, map_tail = 0, map_hheap = 0, map_theap = 0;
 #endif
 		int Thashash;
+		ulng dirhash;
 
 		if ((s = strchr(buf, '\r')) != NULL) {
 			/* convert \r\n into just \n */
@@ -1047,6 +1194,7 @@ BBPreadEntries(FILE *fp, unsigned bbpversion)
 			*s++ = '\n';
 			*s = 0;
 		}
+		dirhash = BBPentryhash(buf);
 
 		if (bbpversion <= GDKLIBRARY_HEADED ?
 		    sscanf(buf,
@@ -1133,6 +1281,7 @@ BBPreadEntries(FILE *fp, unsigned bbpversion)
 			options = buf + nread + 1;
 
 		BBP_desc(bid) = bn;
+		BBP_dirhash(bid) = dirhash;
 		BBP_status(bid) = BBPEXISTING;	/* do we need other status bits? */
 		if ((s = strchr(headname, '~')) != NULL && s == headname) {
 			snprintf(logical, sizeof(logical), "tmp_%o", (unsigned) bid);
@@ -1297,11 +1446,13 @@ BBPresetfarms(void)
 void
 BBPinit(void)
 {
-	FILE *fp = NULL;
+	FILE *fp = NULL, *dfp;
+	bbpdirstream bs;
 	struct stat st;
 	unsigned bbpversion;
 	str bbpdirstr, backupbbpdirstr;
 	int i;
+	MT_Id pid;
 
 	if(!(bbpdirstr = GDKfilepath(0, BATDIR, "BBP", "dir")))
 		GDKfatal("BBPinit: GDKmalloc failed\n");
@@ -1328,6 +1479,9 @@ BBPinit(void)
 	if (BBPrecover_subdir() != GDK_SUCCEED)
 		GDKfatal("BBPinit: cannot properly recover_subdir process %s. Please check whether your disk is full or write-protected", SUBDIR);
 
+	if (recover_dlt(0) != GDK_SUCCEED)
+		goto bailout;
+
 	/* try to obtain a BBP.dir from bakdir */
 	if (stat(backupbbpdirstr, &st) == 0) {
 		/* backup exists; *must* use it */
@@ -1342,7 +1496,7 @@ BBPinit(void)
 			/* no BBP.bak (nor BBP.dir or BACKUP/BBP.dir):
 			 * create a new one */
 			IODEBUG fprintf(stderr, "#BBPdir: initializing BBP.\n");	/* BBPdir instead of BBPinit for backward compatibility of error messages */
-			if (BBPdir(0, NULL) != GDK_SUCCEED)
+			if (BBPdir(0, NULL, NULL) != GDK_SUCCEED)
 				goto bailout;
 		} else if (GDKmove(0, BATDIR, "BBP", "bak", BATDIR, "BBP", "dir") == GDK_SUCCEED)
 			IODEBUG fprintf(stderr, "#BBPinit: reverting to dir saved in BBP.bak.\n");
@@ -1359,12 +1513,22 @@ BBPinit(void)
 	BBP_dirty = true;
 
 	bbpversion = BBPheader(fp);
+	if ((dfp = BBPdelta_open(BATDIR, &i)) != NULL) {
+		if (bbpversion != GDKLIBRARY)
+			GDKfatal("BBPinit: BBP.dlt found next to BBP.dir of an older version");
+		i = (int) (i * BATMARGIN);
+		if (i > (bat) ATOMIC_GET(BBPsize, BBPsizeLock))
+			ATOMIC_SET(BBPsize, i, BBPsizeLock);
+	}
 
 	BBPextend(0, false);		/* allocate BBP records */
 	ATOMIC_SET(BBPsize, 1, BBPsizeLock);
 
-	BBPreadEntries(fp, bbpversion);
+	BBPdir_open(&bs, fp, dfp, false);
+	BBPreadEntries(&bs, bbpversion);
 	fclose(fp);
+	if (dfp)
+		fclose(dfp);
 
 	if (BBPinithash(0) != GDK_SUCCEED)
 		GDKfatal("BBPinit: BBPinithash failed");
@@ -1404,6 +1568,12 @@ BBPinit(void)
 		TMcommit();
 	GDKfree(bbpdirstr);
 	GDKfree(backupbbpdirstr);
+
+	/* start the thread that keeps an eye on memory usage */
+	if (MT_create_thread(&pid, BBPmanager, NULL, MT_THR_JOINABLE) < 0)
+		GDKerror("BBPinit: could not start BBP manager thread\n");
+	else
+		GDKregister(pid);
 	return;
 
       bailout:
@@ -1488,9 +1658,10 @@ BBPexit(void)
  * reclaimed as well.
  */
 static inline int
-heap_entry(FILE *fp, BAT *b)
+heap_entry(char *buf, size_t len, BAT *b)
 {
-	return fprintf(fp, " %s %d %d %d " BUNFMT " " BUNFMT " " BUNFMT " "
+	return snprintf(buf, len,
+		       " %s %d %d %d " BUNFMT " " BUNFMT " " BUNFMT " "
 		       BUNFMT " " OIDFMT " %zu %zu %d",
 		       b->ttype >= 0 ? BATatoms[b->ttype].name : ATOMunknown_name(b->ttype),
 		       b->twidth,
@@ -1512,17 +1683,21 @@ heap_entry(FILE *fp, BAT *b)
 }
 
 static inline int
-vheap_entry(FILE *fp, Heap *h)
+vheap_entry(char *buf, size_t len, Heap *h)
 {
 	if (h == NULL)
 		return 0;
-	return fprintf(fp, " %zu %zu %d",
+	return snprintf(buf, len, " %zu %zu %d",
 		       h->free, h->size, (int) h->newstorage);
 }
 
-static gdk_return
-new_bbpentry(FILE *fp, bat i, const char *prefix)
+/* format the BBP.dir entry of bat i in buf; return its length, or -1
+ * if it doesn't fit */
+static int
+BBPentry(char *buf, size_t len, bat i)
 {
+	int n, m;
+
 #ifndef NDEBUG
 	assert(i > 0);
 	assert(i < (bat) ATOMIC_GET(BBPsize, BBPsizeLock));
@@ -1537,22 +1712,50 @@ new_bbpentry(FILE *fp, bat i, const char *prefix)
 	}
 #endif
 
-	if (fprintf(fp, "%s%zd %u %s %s %d " BUNFMT " "
-		    BUNFMT " " OIDFMT, prefix,
-		    /* BAT info */
-		    (ssize_t) i,
-		    BBP_status(i) & BBPPERSISTENT,
-		    BBP_logical(i),
-		    BBP_physical(i),
-		    BBP_desc(i)->batRestricted << 1,
-		    BBP_desc(i)->batCount,
-		    BBP_desc(i)->batCapacity,
-		    BBP_desc(i)->hseqbase) < 0 ||
-	    heap_entry(fp, BBP_desc(i)) < 0 ||
-	    vheap_entry(fp, BBP_desc(i)->tvheap) < 0 ||
-	    (BBP_options(i) &&
-	     fprintf(fp, " %s", BBP_options(i)) < 0) ||
-	    fprintf(fp, "\n") < 0) {
+	n = snprintf(buf, len, "%zd %u %s %s %d " BUNFMT " "
+		     BUNFMT " " OIDFMT,
+		     /* BAT info */
+		     (ssize_t) i,
+		     BBP_status(i) & BBPPERSISTENT,
+		     BBP_logical(i),
+		     BBP_physical(i),
+		     BBP_desc(i)->batRestricted << 1,
+		     BBP_desc(i)->batCount,
+		     BBP_desc(i)->batCapacity,
+		     BBP_desc(i)->hseqbase);
+	if (n < 0 || (size_t) n >= len)
+		return -1;
+	m = heap_entry(buf + n, len - n, BBP_desc(i));
+	if (m < 0 || (size_t) (n += m) >= len)
+		return -1;
+	m = vheap_entry(buf + n, len - n, BBP_desc(i)->tvheap);
+	if (m < 0 || (size_t) (n += m) >= len)
+		return -1;
+	if (BBP_options(i)) {
+		m = snprintf(buf + n, len - n, " %s", BBP_options(i));
+		if (m < 0 || (size_t) (n += m) >= len)
+			return -1;
+	}
+	m = snprintf(buf + n, len - n, "\n");
+	if (m < 0 || (size_t) (n += m) >= len)
+		return -1;
+	return n;
+}
+
+/* write the entry of bat i to fp, and if hash is not NULL, set *hash
+ * to its hash value */
+static gdk_return
+new_bbpentry(FILE *fp, bat i, const char *prefix, ulng *hash)
+{
+	char buf[4096];
+
+	if (BBPentry(buf, sizeof(buf), i) < 0) {
+		GDKerror("new_bbpentry: BBP.dir entry of bat %d too long\n", (int) i);
+		return GDK_FAIL;
+	}
+	if (hash)
+		*hash = BBPentryhash(buf);
+	if (fprintf(fp, "%s%s", prefix, buf) < 0) {
 		GDKsyserror("new_bbpentry: Writing BBP.dir entry failed\n");
 		return GDK_FAIL;
 	}
@@ -1577,12 +1780,29 @@ BBPdir_header(FILE *f, int n)
 }
 
 static gdk_return
-BBPdir_subcommit(int cnt, bat *subcommit)
+BBPdelta_header(FILE *f, int n)
 {
-	FILE *obbpf, *nbbpf;
+	if (fprintf(f, "BBP.dlt, GDKversion %u\nBBPsize=%d\n",
+		    GDKLIBRARY, n) < 0 ||
+	    ferror(f)) {
+		GDKsyserror("BBPdelta_header: Writing BBP.dlt header failed\n");
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+/* write a new BBP.dir that consists of the entries of the backed up
+ * BBP.dir and BBP.dlt in bakdir, with those of the subcommitted bats
+ * replaced; hashes[j] is set to the hash value of the new entry of
+ * subcommit[j] */
+static gdk_return
+BBPdir_subcommit(int cnt, bat *subcommit, ulng *hashes, const char *bakdir)
+{
+	FILE *obbpf, *dbbpf, *nbbpf = NULL;
+	bbpdirstream bs;
 	bat j = 1;
-	char buf[3000];
-	int n;
+	char buf[4096];
+	int n, dn;
 
 #ifndef NDEBUG
 	assert(subcommit != NULL);
@@ -1590,17 +1810,10 @@ BBPdir_subcommit(int cnt, bat *subcommit)
 		assert(subcommit[n - 1] < subcommit[n]);
 #endif
 
-	if ((nbbpf = GDKfilelocate(0, "BBP", "w", "dir")) == NULL)
-		return GDK_FAIL;
-
-	n = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
-
 	/* we need to copy the backup BBP.dir to the new, but
 	 * replacing the entries for the subcommitted bats */
-	if ((obbpf = GDKfileopen(0, SUBDIR, "BBP", "dir", "r")) == NULL) {
-		if ((obbpf = GDKfileopen(0, BAKDIR, "BBP", "dir", "r")) == NULL)
-			GDKfatal("BBPdir: subcommit attempted without backup BBP.dir.");
-	}
+	if ((obbpf = GDKfileopen(0, bakdir, "BBP", "dir", "r")) == NULL)
+		GDKfatal("BBPdir: subcommit attempted without backup BBP.dir.");
 	/* read first three lines */
 	if (fgets(buf, sizeof(buf), obbpf) == NULL || /* BBP.dir, GDKversion %d */
 	    fgets(buf, sizeof(buf), obbpf) == NULL || /* SIZEOF_SIZE_T SIZEOF_OID SIZEOF_MAX_INT */
@@ -1608,55 +1821,58 @@ BBPdir_subcommit(int cnt, bat *subcommit)
 		GDKfatal("BBPdir: subcommit attempted with invalid backup BBP.dir.");
 	/* third line contains BBPsize */
 	sscanf(buf, "BBPsize=%d", &n);
+	if ((dbbpf = BBPdelta_open(bakdir, &dn)) != NULL && n < dn)
+		n = dn;
 	if (n < (bat) ATOMIC_GET(BBPsize, BBPsizeLock))
 		n = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
 
 	if (GDKdebug & (IOMASK | THRDMASK))
 		fprintf(stderr, "#BBPdir: writing BBP.dir (%d bats).\n", n);
 
-	if (BBPdir_header(nbbpf, n) != GDK_SUCCEED) {
+	/* the BBP.dlt merged into the new BBP.dir must go, and the
+	 * BBP.dir we're replacing may be a link to the backup */
+	if (GDKunlink(0, BATDIR, "BBP", "dlt") != GDK_SUCCEED ||
+	    GDKunlink(0, BATDIR, "BBP", "dir") != GDK_SUCCEED ||
+	    (nbbpf = GDKfilelocate(0, "BBP", "w", "dir")) == NULL ||
+	    BBPdir_header(nbbpf, n) != GDK_SUCCEED) {
 		goto bailout;
 	}
-	n = 0;
+	BBPdir_open(&bs, obbpf, dbbpf, false);
+	n = BBPdir_next(&bs, buf, sizeof(buf));
 	for (;;) {
 		/* but for subcommits, all except the bats in the list
 		 * retain their existing mode */
-		if (n == 0 && obbpf != NULL) {
-			if (fgets(buf, sizeof(buf), obbpf) == NULL) {
-				fclose(obbpf);
-				obbpf = NULL;
-			} else if (sscanf(buf, "%d", &n) != 1 || n <= 0)
-				GDKfatal("BBPdir: subcommit attempted with invalid backup BBP.dir.");
-			/* at this point, obbpf == NULL, or n > 0 */
-		}
-		if (j == cnt && n == 0) {
-			assert(obbpf == NULL);
+		if (j == cnt && n == 0)
 			break;
-		}
-		if (j < cnt && (n == 0 || subcommit[j] <= n || obbpf == NULL)) {
+		if (j < cnt && (n == 0 || subcommit[j] <= n)) {
 			bat i = subcommit[j];
 			/* BBP.dir consists of all persistent bats only */
+			hashes[j] = 0;
 			if (BBP_status(i) & BBPPERSISTENT) {
-				if (new_bbpentry(nbbpf, i, "") != GDK_SUCCEED) {
+				if (new_bbpentry(nbbpf, i, "", &hashes[j]) != GDK_SUCCEED) {
 					goto bailout;
 				}
-				IODEBUG new_bbpentry(stderr, i, "#");
+				IODEBUG new_bbpentry(stderr, i, "#", NULL);
 			}
-			if (i == n)
-				n = 0;	/* read new entry (i.e. skip this one from old BBP.dir */
-			do
-				/* go to next, skipping duplicates */
-				j++;
-			while (j < cnt && subcommit[j] == i);
+			if (i == n)	/* skip this one from old BBP.dir */
+				n = BBPdir_next(&bs, buf, sizeof(buf));
+			/* go to next, skipping duplicates */
+			while (++j < cnt && subcommit[j] == i)
+				hashes[j] = hashes[j - 1];
 		} else {
 			if (fprintf(nbbpf, "%s", buf) < 0) {
 				GDKsyserror("BBPdir_subcommit: Copying BBP.dir entry failed\n");
 				goto bailout;
 			}
 			IODEBUG fprintf(stderr, "#%s", buf);
-			n = 0;
+			n = BBPdir_next(&bs, buf, sizeof(buf));
 		}
 	}
+	fclose(obbpf);
+	obbpf = NULL;
+	if (dbbpf)
+		fclose(dbbpf);
+	dbbpf = NULL;
 
 	if (fflush(nbbpf) == EOF ||
 	    (!(GDKdebug & NOSYNCMASK)
@@ -1673,8 +1889,176 @@ BBPdir_subcommit(int cnt, bat *subcommit)
 	}
 	if (fclose(nbbpf) == EOF) {
 		GDKsyserror("BBPdir_subcommit: Closing BBP.dir file failed\n");
+		nbbpf = NULL;
+		goto bailout;
+	}
+
+	IODEBUG fprintf(stderr, "#BBPdir end\n");
+
+	return GDK_SUCCEED;
+
+      bailout:
+	if (obbpf != NULL)
+		fclose(obbpf);
+	if (dbbpf != NULL)
+		fclose(dbbpf);
+	if (nbbpf != NULL)
+		fclose(nbbpf);
+	return GDK_FAIL;
+}
+
+/*
+ * Rewriting BBP.dir costs time proportional to the number of
+ * persistent bats, whereas a subcommit (and the SQL store only does
+ * subcommits) usually changes only a few of them.  So a subcommit
+ * normally leaves BBP.dir alone: it puts it back by linking it to the
+ * backed up file, and writes the entries of the subcommitted bats in
+ * BBP.dlt instead, merged with those of the backed up BBP.dlt.  The
+ * cost is then proportional to the number of bats changed since
+ * BBP.dir was last written.  When BBP.dlt becomes larger than
+ * 1/BBPDELTA_FRACTION of BBP.dir, the next subcommit merges it into
+ * a new BBP.dir (BBPdir_subcommit).  A full commit always writes a
+ * new BBP.dir.
+ */
+#define BBPDELTA_FRACTION	4
+
+static bool
+BBPdir_usedelta(const char *bakdir)
+{
+#ifdef NATIVE_WIN32
+	/* we need hard links */
+	(void) bakdir;
+	return false;
+#else
+	struct stat dst, dlt;
+	char *path;
+	int ret;
+
+	if ((path = GDKfilepath(0, bakdir, "BBP", "dir")) == NULL) {
+		GDKclrerr();
+		return false;
+	}
+	ret = stat(path, &dst);
+	GDKfree(path);
+	if (ret < 0)
+		return false;
+	if ((path = GDKfilepath(0, bakdir, "BBP", "dlt")) == NULL) {
+		GDKclrerr();
+		return false;
+	}
+	if (stat(path, &dlt) < 0)
+		dlt.st_size = 0;
+	GDKfree(path);
+	return dlt.st_size < dst.st_size / BBPDELTA_FRACTION;
+#endif
+}
+
+#ifndef NATIVE_WIN32
+/* like BBPdir_subcommit, but write BBP.dlt; entries that didn't
+ * change since they were last committed are left out */
+static gdk_return
+BBPdir_delta(int cnt, bat *subcommit, ulng *hashes, const char *bakdir)
+{
+	FILE *obbpf, *nbbpf = NULL;
+	bbpdirstream bs;
+	char *src, *dst = NULL;
+	bat j = 1;
+	char buf[4096], entry[4096];
+	int n = 0, nchanged = 0;
+
+	/* the backup of BBP.dir is also the new BBP.dir; the link
+	 * leaves the backup in place for BBPrecover */
+	if ((src = GDKfilepath(0, bakdir, "BBP", "dir")) == NULL ||
+	    (dst = GDKfilepath(0, BATDIR, "BBP", "dir")) == NULL) {
+		GDKfree(src);
+		return GDK_FAIL;
+	}
+	if (GDKunlink(0, BATDIR, "BBP", "dir") != GDK_SUCCEED ||
+	    link(src, dst) < 0) {
+		GDKsyserror("BBPdir_delta: cannot link %s to %s\n", dst, src);
+		GDKfree(src);
+		GDKfree(dst);
+		return GDK_FAIL;
+	}
+	IODEBUG fprintf(stderr, "#link %s %s\n", src, dst);
+	GDKfree(src);
+	GDKfree(dst);
+
+	obbpf = BBPdelta_open(bakdir, &n);
+	if (n < (bat) ATOMIC_GET(BBPsize, BBPsizeLock))
+		n = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
+
+	if ((nbbpf = GDKfilelocate(0, "BBP", "w", "dlt")) == NULL ||
+	    BBPdelta_header(nbbpf, n) != GDK_SUCCEED)
+		goto bailout;
+	BBPdir_open(&bs, NULL, obbpf, true);
+	n = BBPdir_next(&bs, buf, sizeof(buf));
+	for (;;) {
+		if (j == cnt && n == 0)
+			break;
+		if (j < cnt && (n == 0 || subcommit[j] <= abs(n))) {
+			bat i = subcommit[j];
+			/* an old entry of i in BBP.dlt is always replaced
+			 * (perhaps by the same), otherwise only a
+			 * changed entry needs to be written */
+			if (BBP_status(i) & BBPPERSISTENT) {
+				if (BBPentry(entry, sizeof(entry), i) < 0) {
+					GDKerror("BBPdir_delta: BBP.dir entry of bat %d too long\n", (int) i);
+					goto bailout;
+				}
+				hashes[j] = BBPentryhash(entry);
+				if (hashes[j] != BBP_dirhash(i) || i == abs(n)) {
+					if (fprintf(nbbpf, "%s", entry) < 0) {
+						GDKsyserror("BBPdir_delta: Writing BBP.dlt entry failed\n");
+						goto bailout;
+					}
+					IODEBUG fprintf(stderr, "#%s", entry);
+					nchanged++;
+				}
+			} else {
+				hashes[j] = 0;
+				if (BBP_dirhash(i) != 0 || i == abs(n)) {
+					if (fprintf(nbbpf, "-%d\n", (int) i) < 0) {
+						GDKsyserror("BBPdir_delta: Writing BBP.dlt entry failed\n");
+						goto bailout;
+					}
+					nchanged++;
+				}
+			}
+			if (i == abs(n))	/* replaces the old entry */
+				n = BBPdir_next(&bs, buf, sizeof(buf));
+			while (++j < cnt && subcommit[j] == i)
+				hashes[j] = hashes[j - 1];
+		} else {
+			if (fprintf(nbbpf, "%s", buf) < 0) {
+				GDKsyserror("BBPdir_delta: Copying BBP.dlt entry failed\n");
+				goto bailout;
+			}
+			n = BBPdir_next(&bs, buf, sizeof(buf));
+		}
+	}
+	if (obbpf)
+		fclose(obbpf);
+	obbpf = NULL;
+
+	if (GDKdebug & (IOMASK | THRDMASK))
+		fprintf(stderr, "#BBPdir: wrote BBP.dlt (%d of %d bats changed).\n", nchanged, cnt - 1);
+
+	if (fflush(nbbpf) == EOF ||
+	    (!(GDKdebug & NOSYNCMASK)
+#if defined(HAVE_FDATASYNC)
+	     && fdatasync(fileno(nbbpf)) < 0
+#elif defined(HAVE_FSYNC)
+	     && fsync(fileno(nbbpf)) < 0
+#endif
+		    )) {
+		GDKsyserror("BBPdir_delta: Syncing BBP.dlt file failed\n");
 		goto bailout;
 	}
+	if (fclose(nbbpf) == EOF) {
+		GDKsyserror("BBPdir_delta: Closing BBP.dlt file failed\n");
+		return GDK_FAIL;
+	}
 
 	IODEBUG fprintf(stderr, "#BBPdir end\n");
 
@@ -1687,20 +2071,36 @@ BBPdir_subcommit(int cnt, bat *subcommit)
 		fclose(nbbpf);
 	return GDK_FAIL;
 }
+#endif
 
+/* write BBP.dir (or BBP.dlt) with the entries of the bats in
+ * subcommit, or of all bats; if hashes is not NULL, set hashes[idx]
+ * to the hash value of the new entry of subcommit[idx] (or bat idx) */
 gdk_return
-BBPdir(int cnt, bat *subcommit)
+BBPdir(int cnt, bat *subcommit, ulng *hashes)
 {
 	FILE *fp;
 	bat i;
 
-	if (subcommit)
-		return BBPdir_subcommit(cnt, subcommit);
+	if (subcommit) {
+		const char *bakdir = file_exists(0, SUBDIR, "BBP", "dir") ? SUBDIR : BAKDIR;
+
+#ifndef NATIVE_WIN32
+		assert(hashes != NULL);
+		if (BBPdir_usedelta(bakdir))
+			return BBPdir_delta(cnt, subcommit, hashes, bakdir);
+#endif
+		return BBPdir_subcommit(cnt, subcommit, hashes, bakdir);
+	}
 
 	if (GDKdebug & (IOMASK | THRDMASK))
 		fprintf(stderr, "#BBPdir: writing BBP.dir (%d bats).\n", (int) (bat) ATOMIC_GET(BBPsize, BBPsizeLock));
-	if ((fp = GDKfilelocate(0, "BBP", "w", "dir")) == NULL) {
-		goto bailout;
+	/* a full BBP.dir replaces any BBP.dlt, and the BBP.dir we're
+	 * replacing may be a link to the backup */
+	if (GDKunlink(0, BATDIR, "BBP", "dlt") != GDK_SUCCEED ||
+	    GDKunlink(0, BATDIR, "BBP", "dir") != GDK_SUCCEED ||
+	    (fp = GDKfilelocate(0, "BBP", "w", "dir")) == NULL) {
+		return GDK_FAIL;
 	}
 
 	if (BBPdir_header(fp, (bat) ATOMIC_GET(BBPsize, BBPsizeLock)) != GDK_SUCCEED) {
@@ -1710,12 +2110,16 @@ BBPdir(int cnt, bat *subcommit)
 	for (i = 1; i < (bat) ATOMIC_GET(BBPsize, BBPsizeLock); i++) {
 		/* write the entry
 		 * BBP.dir consists of all persistent bats */
+		ulng h = 0;
+
 		if (BBP_status(i) & BBPPERSISTENT) {
-			if (new_bbpentry(fp, i, "") != GDK_SUCCEED) {
+			if (new_bbpentry(fp, i, "", &h) != GDK_SUCCEED) {
 				goto bailout;
 			}
-			IODEBUG new_bbpentry(stderr, i, "#");
+			IODEBUG new_bbpentry(stderr, i, "#", NULL);
 		}
+		if (hashes && i < cnt)
+			hashes[i] = h;
 	}
 
 	if (fflush(fp) == EOF ||
@@ -1827,6 +2231,19 @@ BBPdump(void)
 				vm += HEAPvmsize(&b->thash->heap);
 			}
 		}
+		if (b->tbhash && b->tbhash != (BHash *) 1) {
+			fprintf(stderr,
+				" Tbhash=[%zu,%zu]",
+				HEAPmemsize(&b->tbhash->heap),
+				HEAPvmsize(&b->tbhash->heap));
+			if (BBP_logical(i) && BBP_logical(i)[0] == '.') {
+				cmem += HEAPmemsize(&b->tbhash->heap);
+				cvm += HEAPvmsize(&b->tbhash->heap);
+			} else {
+				mem += HEAPmemsize(&b->tbhash->heap);
+				vm += HEAPvmsize(&b->tbhash->heap);
+			}
+		}
 		fprintf(stderr, " role: %s, persistence: %s\n",
 			b->batRole == PERSISTENT ? "persistent" : "transient",
 			b->batPersistence == PERSISTENT ? "persistent" : "transient");
@@ -2054,6 +2471,8 @@ BBPinsert(BAT *bn)
 	BBP_desc(i) = NULL;
 	BBP_refs(i) = 1;	/* new bats have 1 pin */
 	BBP_lrefs(i) = 0;	/* ie. no logical refs */
+	BBP_heat(i) = 1;	/* the creator fixed it */
+	BBP_lastused(i) = BBPclock;
 
 #ifdef HAVE_HGE
 	if (bn->ttype == TYPE_hge)
@@ -2374,6 +2793,10 @@ incref(bat i, bool logical, bool lock)
 		assert(tp >= 0);
 		tvp = b->tvheap == 0 || b->tvheap->parentid == i ? 0 : b->tvheap->parentid;
 		refs = ++BBP_refs(i);
+		/* keep track of how hot the BAT is (see BBPtrim) */
+		BBP_lastused(i) = BBPclock;
+		if (BBP_heat(i) < BBP_MAXHEAT)
+			BBP_heat(i)++;
 		if (refs == 1 && (tp || tvp)) {
 			/* If this is a view, we must load the parent
 			 * BATs, but we must do that outside of the
@@ -2516,7 +2939,12 @@ decref(bat i, bool logical, bool releaseShare, bool lock, const char *func)
 	if (lock)
 		MT_lock_unset(&GDKswapLock(i));
 
-	if (swap && b != NULL) {
+	if (swap && b == NULL) {
+		/* a transient BAT that was unloaded by BBPtrim: only
+		 * its image on disk is left */
+		assert(BBP_lrefs(i) == 0);
+		BBPdestroy(BBP_desc(i));
+	} else if (swap) {
 		if (BBP_lrefs(i) == 0 && (BBP_status(i) & BBPDELETED) == 0) {
 			/* free memory (if loaded) and delete from
 			 * disk (if transient but saved) */
@@ -2809,6 +3237,246 @@ BBPfree(BAT *b, const char *calledFrom)
 	return ret;
 }
 
+/*
+ * @- Memory pressure
+ * BBPtrim unloads loaded BATs that are not in use (no physical
+ * references) until the memory in use by the server has dropped to
+ * target bytes.  Only transient BATs, that are kept alive by a
+ * logical reference (e.g. a MAL variable), and clean persistent BATs
+ * are considered.  Dirty transient BATs are saved to disk first, from
+ * where they are loaded again on their next BBPfix; when they are
+ * released for the last time without having been loaded, only their
+ * image on disk is deleted (see decref).  The coldest BATs, i.e. the
+ * ones with the lowest heat (see incref), are unloaded first, and of
+ * BATs that are equally cold, the ones that were used longest ago.
+ * Small BATs are left alone, since unloading them hardly helps.
+ *
+ * BBPtrim returns the number of bytes freed.  It is called by the BBP
+ * manager thread when the server uses more than GDK_mem_maxsize
+ * bytes, unless trimming was switched off (see the gdk_vmtrim
+ * option).
+ */
+struct trimcand {
+	bat bid;
+	unsigned heat;
+	unsigned lastused;
+	size_t size;
+};
+
+static int
+trimcmp(const void *p1, const void *p2)
+{
+	const struct trimcand *c1 = p1, *c2 = p2;
+
+	if (c1->heat != c2->heat)
+		return c1->heat < c2->heat ? -1 : 1;
+	/* the clock may have wrapped around: compare distances */
+	if (c1->lastused != c2->lastused)
+		return (int) (c1->lastused - c2->lastused) < 0 ? -1 : 1;
+	return 0;
+}
+
+/* can BAT i be unloaded by BBPtrim?  if so, return its size, else 0;
+ * call with the swap lock of i held */
+static size_t
+trimmable(bat i)
+{
+	BAT *b = BBP_cache(i);
+	size_t size;
+
+	if (b == NULL ||
+	    BBP_lrefs(i) == 0 ||
+	    !BBPtrimmable(b) ||
+	    b->batSharecnt > 0 ||
+	    (BBP_status(i) & (BBPDELETED | BBPNEW)) ||
+	    ((BBP_status(i) & BBPEXISTING) && BATdirty(b)) ||
+	    BATatoms[b->ttype].atomUnfix != NULL ||
+	    b->theap.storage == STORE_CMEM ||
+	    b->theap.storage == STORE_NOWN ||
+	    b->theap.storage == STORE_MMAPABS)
+		return 0;
+	size = b->theap.size;
+	if (b->tvheap)
+		size += b->tvheap->size;
+	return size >= GDK_mmap_pagesize ? size : 0;
+}
+
+size_t
+BBPtrim(size_t target)
+{
+	bat i, size = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
+	struct trimcand *cands;
+	int ncand = 0, n;
+	size_t freed = 0;
+	lng t0 = 0;
+	MT_Lock *trimlock = &GDKtrimLock(threadmask(MT_getpid()));
+
+	if (GDKvm_cursize() <= target)
+		return 0;
+	BATDEBUG t0 = GDKusec();
+	if ((cands = GDKmalloc(size * sizeof(struct trimcand))) == NULL) {
+		GDKclrerr();
+		return 0;
+	}
+	/* prevent (sub)commits while we are busy */
+	MT_lock_set(trimlock);
+	for (i = 1; i < size; i++) {
+		size_t sz;
+
+		MT_lock_set(&GDKswapLock(i));
+		if ((sz = trimmable(i)) > 0) {
+			cands[ncand].bid = i;
+			cands[ncand].heat = BBP_heat(i);
+			cands[ncand].lastused = BBP_lastused(i);
+			cands[ncand].size = sz;
+			ncand++;
+		}
+		MT_lock_unset(&GDKswapLock(i));
+	}
+	qsort(cands, ncand, sizeof(struct trimcand), trimcmp);
+	for (n = 0; n < ncand && GDKvm_cursize() > target; n++) {
+		BAT *b;
+
+		i = cands[n].bid;
+		/* things may have changed since we looked */
+		MT_lock_set(&GDKswapLock(i));
+		if (trimmable(i) == 0) {
+			MT_lock_unset(&GDKswapLock(i));
+			continue;
+		}
+		b = BBP_cache(i);
+		BBP_status_on(i, BBPUNLOADING, "BBPtrim");
+		MT_lock_unset(&GDKswapLock(i));
+		BATDEBUG fprintf(stderr, "#BBPtrim: unload %s (heat %u, "
+				 "%zu bytes)\n", BATgetId(b), cands[n].heat,
+				 cands[n].size);
+		BBP_unload_inc(i, "BBPtrim");
+		if (BBPfree(b, "BBPtrim") == GDK_SUCCEED)
+			freed += cands[n].size;
+		else
+			GDKclrerr();
+	}
+	MT_lock_unset(trimlock);
+	GDKfree(cands);
+	BATDEBUG fprintf(stderr, "#BBPtrim: freed %zu bytes of %d candidates "
+			 "(" LLFMT " usec)\n", freed, ncand, GDKusec() - t0);
+	return freed;
+}
+
+/* The BBP manager runs in the background.  It advances the BBP clock,
+ * lets the heat of all BATs decay, and when the server uses more
+ * memory than it is supposed to, it unloads the coldest BATs until
+ * there is some room again. */
+static void
+BBPmanager(void *dummy)
+{
+	(void) dummy;
+
+	for (;;) {
+		int t;
+
+		for (t = 0; t < BBPMANAGER_INTERVAL; t += 100) {
+			MT_sleep_ms(100);
+			if (GDKexiting())
+				return;
+		}
+		if (++BBPclock % BBP_HEATDECAY == 0) {
+			bat i, size = (bat) ATOMIC_GET(BBPsize, BBPsizeLock);
+
+			for (i = 1; i < size; i++)
+				BBP_heat(i) >>= 1;
+		}
+		if (GDK_vm_trim && GDKvm_cursize() > GDK_mem_maxsize)
+			(void) BBPtrim(GDK_mem_maxsize / 4 * 3);
+	}
+}
+
+/* Tell the operating system how an operator is going to access the
+ * memory of BAT b: sequentially (MMAP_SEQUENTIAL), in random order
+ * (MMAP_WILLNEED: read it all in now), or not anymore
+ * (MMAP_DONTNEED).  Only memory mapped heaps are advised.  Pages that
+ * we don't need anymore are only given up for large BATs that are
+ * cold, and only if they are mapped shared, so that they can be read
+ * back from their file.  This way a large scan doesn't push hot BATs
+ * out of memory. */
+static void
+HEAPadvise(const Heap *h, int advice)
+{
+	size_t off, len;
+
+	if (h->base == NULL ||
+	    (h->storage != STORE_MMAP && h->storage != STORE_PRIV) ||
+	    (advice == MMAP_DONTNEED && h->storage != STORE_MMAP))
+		return;
+	/* madvise needs a page aligned address */
+	off = (size_t) h->base & (MT_pagesize() - 1);
+	len = MIN(h->free, h->size) + off;
+	if (len > off)
+		(void) MT_madvise(h->base - off, len, advice);
+}
+
+void
+BATadvise(BAT *b, int advice)
+{
+	bat bid = VIEWtparent(b) ? VIEWtparent(b) : b->batCacheid;
+
+	if (advice == MMAP_DONTNEED &&
+	    (BBP_heat(bid) > BBP_COLDHEAT ||
+	     b->theap.size < GDK_mmap_minsize_transient))
+		return;
+	if (b->ttype != TYPE_void)
+		HEAPadvise(&b->theap, advice);
+	/* strings are not accessed in sequence */
+	if (b->tvheap && advice != MMAP_SEQUENTIAL)
+		HEAPadvise(b->tvheap, advice);
+}
+
+/* Start reading BAT i into memory in the background, so that the
+ * thread that uses it later doesn't have to wait for the disk.  If the
+ * BAT is not loaded, the OS is asked to read its heap files into the
+ * file system cache, from where loading them is cheap.  If it is
+ * loaded, its memory mapped heaps are read in (see BATadvise). */
+void
+BBPprefetch(bat i)
+{
+	char nme[sizeof(BBP_physical(i))];
+	int tfarm = -1, vfarm = -1;
+	bool loaded;
+	BAT *b;
+
+	if (!BBPcheck(i, "BBPprefetch"))
+		return;
+	MT_lock_set(&GDKswapLock(i));
+	if ((b = BBP_desc(i)) == NULL ||
+	    (BBP_status(i) & BBPWAITING) ||
+	    isVIEW(b)) {
+		MT_lock_unset(&GDKswapLock(i));
+		return;
+	}
+	loaded = BBP_cache(i) != NULL;
+	if (!loaded) {
+		strcpy(nme, BBP_physical(i));
+		if (b->ttype != TYPE_void)
+			tfarm = b->theap.farmid;
+		if (b->tvheap)
+			vfarm = b->tvheap->farmid;
+	}
+	MT_lock_unset(&GDKswapLock(i));
+
+	if (loaded) {
+		if (BBPfix(i) > 0) {
+			if ((b = BBP_cache(i)) != NULL)
+				BATadvise(b, MMAP_WILLNEED);
+			BBPunfix(i);
+		}
+		return;
+	}
+	if (tfarm >= 0)
+		GDKprefetch(tfarm, nme, "tail");
+	if (vfarm >= 0)
+		GDKprefetch(vfarm, nme, "theap");
+}
+
 /*
  * BBPquickdesc loads a BAT descriptor without loading the entire BAT,
  * of which the result be used only for a *limited* number of
@@ -3036,8 +3704,23 @@ BBPprepare(bool subcommit)
 		IODEBUG fprintf(stderr, "#mkdir %s = %d\n", subdirpath, (int) ret);
 	}
 	if (ret == GDK_SUCCEED && backup_dir != set) {
-		/* a valid backup dir *must* at least contain BBP.dir */
-		if ((ret = GDKmove(0, backup_dir ? BAKDIR : BATDIR, "BBP", "dir", subcommit ? SUBDIR : BAKDIR, "BBP", "dir")) == GDK_SUCCEED) {
+		const char *srcdir = backup_dir ? BAKDIR : BATDIR;
+		const char *dstdir = subcommit ? SUBDIR : BAKDIR;
+
+		/* a valid backup dir *must* at least contain BBP.dir;
+		 * it also gets a BBP.dlt, an empty one if there is
+		 * none, so that restoring the backup also undoes the
+		 * writing of a BBP.dlt (see BBPdir_delta) */
+		ret = move_dlt(0, srcdir, dstdir);
+		if (ret == GDK_SUCCEED &&
+		    !file_exists(0, dstdir, "BBP", "dlt")) {
+			FILE *fp = GDKfileopen(0, dstdir, "BBP", "dlt", "w");
+
+			if (fp == NULL || fclose(fp) == EOF)
+				ret = GDK_FAIL;
+		}
+		if (ret == GDK_SUCCEED &&
+		    (ret = GDKmove(0, srcdir, "BBP", "dir", dstdir, "BBP", "dir")) == GDK_SUCCEED) {
 			backup_dir = set;
 		}
 	}
@@ -3179,7 +3862,89 @@ fail:
  * back all backed up files; this is done by BBPrecover().
  *
  * The BBP.dir is also moved into the BAKDIR.
+ *
+ * The bats are saved by up to GDKnr_threads threads, so that the
+ * writes (and especially the syncs) of different bats overlap.  Each
+ * thread repeatedly takes the next bat from the list; they all stop
+ * after the first failure.
  */
+struct syncpar {
+	BAT **bats;
+	int nbats;
+	int next;
+	bool failed;
+	MT_Lock lock;
+};
+
+static void
+BBPsyncworker(void *arg)
+{
+	struct syncpar *sp = arg;
+	BAT *b;
+
+	for (;;) {
+		MT_lock_set(&sp->lock);
+		if (sp->failed || sp->next == sp->nbats) {
+			MT_lock_unset(&sp->lock);
+			return;
+		}
+		b = sp->bats[sp->next++];
+		MT_lock_unset(&sp->lock);
+		if (BATsave(b) != GDK_SUCCEED) {
+			MT_lock_set(&sp->lock);
+			sp->failed = true;
+			MT_lock_unset(&sp->lock);
+			return;
+		}
+	}
+}
+
+static gdk_return
+BBPsavebats(BAT **bats, int nbats)
+{
+	struct syncpar sp;
+	MT_Id *tids = NULL;
+	bool *started = NULL;
+	int i, nthreads = GDKnr_threads;
+
+	if (nthreads > nbats)
+		nthreads = nbats;
+	if (nthreads > 1) {
+		tids = GDKmalloc(nthreads * sizeof(MT_Id));
+		started = GDKzalloc(nthreads * sizeof(bool));
+		if (tids == NULL || started == NULL) {
+			GDKfree(tids);
+			GDKfree(started);
+			GDKclrerr();	/* we can do without */
+			nthreads = 1;
+		}
+	}
+	if (nthreads <= 1) {
+		for (i = 0; i < nbats; i++)
+			if (BATsave(bats[i]) != GDK_SUCCEED)
+				return GDK_FAIL;
+		return GDK_SUCCEED;
+	}
+	PERFDEBUG fprintf(stderr, "#BBPsync: saving %d bats with %d threads\n",
+			  nbats, nthreads);
+	sp.bats = bats;
+	sp.nbats = nbats;
+	sp.next = 0;
+	sp.failed = false;
+	MT_lock_init(&sp.lock, "BBPsync");
+	for (i = 1; i < nthreads; i++)
+		started[i] = MT_create_thread(&tids[i], BBPsyncworker, &sp,
+					      MT_THR_JOINABLE) == 0;
+	BBPsyncworker(&sp);
+	for (i = 1; i < nthreads; i++)
+		if (started[i])
+			MT_join_thread(tids[i]);
+	MT_lock_destroy(&sp.lock);
+	GDKfree(tids);
+	GDKfree(started);
+	return sp.failed ? GDK_FAIL : GDK_SUCCEED;
+}
+
 gdk_return
 BBPsync(int cnt, bat *subcommit)
 {
@@ -3187,6 +3952,7 @@ BBPsync(int cnt, bat *subcommit)
 	bool bbpdirty = false;
 	int t0 = 0, t1 = 0;
 	str bakdir, deldir;
+	ulng *hashes = NULL;
 
 	if(!(bakdir = GDKfilepath(0, NULL, subcommit ? SUBDIR : BAKDIR, NULL)))
 		return GDK_FAIL;
@@ -3233,29 +3999,44 @@ BBPsync(int cnt, bat *subcommit)
 
 	/* PHASE 2: save the repository */
 	if (ret == GDK_SUCCEED) {
-		int idx = 0;
+		int idx = 0, nbats = 0;
+		BAT **bats;
 
-		while (++idx < cnt) {
-			bat i = subcommit ? subcommit[idx] : idx;
-
-			if (BBP_status(i) & BBPPERSISTENT) {
-				BAT *b = dirty_bat(&i, subcommit != NULL);
-				if (i <= 0)
-					break;
-				if (b != NULL && BATsave(b) != GDK_SUCCEED)
-					break;	/* write error */
+		if ((bats = GDKmalloc(cnt * sizeof(BAT *))) == NULL)
+			ret = GDK_FAIL;
+		else {
+			while (++idx < cnt) {
+				bat i = subcommit ? subcommit[idx] : idx;
+
+				if (BBP_status(i) & BBPPERSISTENT) {
+					BAT *b = dirty_bat(&i, subcommit != NULL);
+					if (i <= 0)
+						break;
+					/* BATsave skips clean bats,
+					 * but refuses views */
+					if (b != NULL &&
+					    (BATdirty(b) || isVIEW(b)))
+						bats[nbats++] = b;
+				}
 			}
+			if (idx < cnt ||
+			    BBPsavebats(bats, nbats) != GDK_SUCCEED)
+				ret = GDK_FAIL;	/* write error */
+			GDKfree(bats);
 		}
-		if (idx < cnt)
-			ret = GDK_FAIL;
 	}
 
 	PERFDEBUG fprintf(stderr, "#BBPsync (write time %d)\n", (t0 = GDKms()) - t1);
 
 	if (ret == GDK_SUCCEED) {
 		if (bbpdirty) {
-			ret = BBPdir(cnt, subcommit);
-		} else if (backup_dir && GDKmove(0, (backup_dir == 1) ? BAKDIR : SUBDIR, "BBP", "dir", BATDIR, "BBP", "dir") != GDK_SUCCEED) {
+			if ((hashes = GDKmalloc(cnt * sizeof(ulng))) == NULL)
+				ret = GDK_FAIL;
+			else
+				ret = BBPdir(cnt, subcommit, hashes);
+		} else if (backup_dir &&
+			   (GDKmove(0, (backup_dir == 1) ? BAKDIR : SUBDIR, "BBP", "dir", BATDIR, "BBP", "dir") != GDK_SUCCEED ||
+			    move_dlt(0, (backup_dir == 1) ? BAKDIR : SUBDIR, BATDIR) != GDK_SUCCEED)) {
 			ret = GDK_FAIL;	/* tried a cheap way to get BBP.dir; but it failed */
 		} else {
 			/* commit might still fail; we must remember
@@ -3288,6 +4069,13 @@ BBPsync(int cnt, bat *subcommit)
 
 		/* AFTERMATH */
 		if (ret == GDK_SUCCEED) {
+			if (hashes) {
+				/* the new entries are committed */
+				int idx;
+
+				for (idx = 1; idx < cnt; idx++)
+					BBP_dirhash(subcommit ? subcommit[idx] : idx) = hashes[idx];
+			}
 			BBP_dirty = false;
 			backup_files = subcommit ? (backup_files - backup_subdir) : 0;
 			backup_dir = backup_subdir = 0;
@@ -3301,6 +4089,7 @@ BBPsync(int cnt, bat *subcommit)
 		}
 	}
 	PERFDEBUG fprintf(stderr, "#BBPsync (ready time %d)\n", (t0 = GDKms()) - t1);
+	GDKfree(hashes);
 	GDKfree(bakdir);
 	GDKfree(deldir);
 	return ret;
@@ -3444,6 +4233,8 @@ BBPrecover(int farmid)
 		} else if (strcmp(dent->d_name, "BBP.dir") == 0) {
 			dirseen = true;
 			continue;
+		} else if (strcmp(dent->d_name, "BBP.dlt") == 0) {
+			continue;	/* see below */
 		}
 		if (q == NULL)
 			q = dent->d_name + strlen(dent->d_name);
@@ -3469,6 +4260,8 @@ BBPrecover(int farmid)
 		}
 	}
 	closedir(dirp);
+	if (ret == GDK_SUCCEED)
+		ret = recover_dlt(farmid);
 	if (dirseen && ret == GDK_SUCCEED) {	/* we have a saved BBP.dir; it should be moved back!! */
 		struct stat st;
 		char *fn;
@@ -3649,6 +4442,9 @@ BBPdiskscan(const char *parent, size_t baseoff)
 			} else if (strncmp(p + 1, "theap", 5) == 0) {
 				BAT *b = getdesc(bid);
 				delete = (b == NULL || !b->tvheap || b->batCopiedtodisk == 0);
+			} else if (strncmp(p + 1, "tdict", 5) == 0) {
+				BAT *b = getdesc(bid);
+				delete = (b == NULL || !b->tvheap || b->batCopiedtodisk == 0);
 			} else if (strncmp(p + 1, "thash", 5) == 0) {
 #ifdef PERSISTENTHASH
 				BAT *b = getdesc(bid);
@@ -3657,6 +4453,15 @@ BBPdiskscan(const char *parent, size_t baseoff)
 					b->thash = (Hash *) 1;
 #else
 				delete = true;
+#endif
+			} else if (strncmp(p + 1, "tbhash", 6) == 0) {
+#ifdef PERSISTENTHASH
+				BAT *b = getdesc(bid);
+				delete = b == NULL;
+				if (!delete)
+					b->tbhash = (BHash *) 1;
+#else
+				delete = true;
 #endif
 			} else if (strncmp(p + 1, "timprints", 9) == 0) {
 				BAT *b = getdesc(bid);
@@ -79,6 +79,8 @@ gdk_export int BBPretain(bat b);
 gdk_export int BBPrelease(bat b);
 gdk_export void BBPkeepref(bat i);
 gdk_export void BBPshare(bat b);
+gdk_export size_t BBPtrim(size_t target);
+gdk_export void BBPprefetch(bat i);
 
 #define BBPtmpcheck(s)	(strncmp(s, "tmp_", 4) == 0)
 
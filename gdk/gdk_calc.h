@@ -129,6 +129,7 @@ gdk_export BAT *BATgroupmin(BAT *b, BAT *g, BAT *e, BAT *s, int tp, bool skip_ni
 gdk_export BAT *BATgroupmax(BAT *b, BAT *g, BAT *e, BAT *s, int tp, bool skip_nils, bool abort_on_error);
 gdk_export BAT *BATgroupmedian(BAT *b, BAT *g, BAT *e, BAT *s, int tp, bool skip_nils, bool abort_on_error);
 gdk_export BAT *BATgroupquantile(BAT *b, BAT *g, BAT *e, BAT *s, int tp, double quantile, bool skip_nils, bool abort_on_error);
+gdk_export gdk_return BATgroupaggrs(BAT **sump, int sumtp, BAT **cntp, BAT **minp, BAT **maxp, BAT **avgp, BAT *b, BAT *g, BAT *e, BAT *s, bool skip_nils, bool abort_on_error);
 
 /* helper function for grouped aggregates */
 gdk_export const char *BATgroupaggrinit(
@@ -20,6 +20,8 @@
 		cand = candend = NULL;					\
 		if (s) {						\
 			assert(BATttype(s) == TYPE_oid);		\
+			assert((s)->tmask == NULL ||			\
+			       (s)->tmask->materialized);		\
 			if (BATcount(s) == 0) {				\
 				start = end = 0;			\
 			} else {					\
@@ -57,3 +59,98 @@
 			}						\
 		}							\
 	} while (0)
+
+/* Iterate over a compressed candidate list (see CandMask in gdk.h).
+ * candmask_init positions the iterator at the first candidate that is
+ * not smaller than lo, each call to candmask_next returns the next
+ * candidate.  The caller must not ask for more candidates than there
+ * are, use candmask_count to find out how many there are in a range. */
+struct candmaskiter {
+	const uint64_t *bits;	/* the bitmap */
+	oid first;		/* oid of the first bit */
+	BUN word;		/* index of the current word */
+	uint64_t cur;		/* bits of the current word still to do */
+};
+
+#ifdef __GNUC__
+#define candmask_ctz(x)		__builtin_ctzll(x)
+#define candmask_pop(x)		__builtin_popcountll(x)
+#else
+static inline int
+candmask_ctz(uint64_t x)
+{
+	int n = 0;
+
+	assert(x != 0);
+	while ((x & 0xFFFFFFFF) == 0) {
+		x >>= 32;
+		n += 32;
+	}
+	while ((x & 1) == 0) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+}
+
+static inline int
+candmask_pop(uint64_t x)
+{
+	/* divide and conquer implementation */
+	x = (x & 0x5555555555555555) + ((x >>  1) & 0x5555555555555555);
+	x = (x & 0x3333333333333333) + ((x >>  2) & 0x3333333333333333);
+	x = (x & 0x0F0F0F0F0F0F0F0F) + ((x >>  4) & 0x0F0F0F0F0F0F0F0F);
+	x = (x & 0x00FF00FF00FF00FF) + ((x >>  8) & 0x00FF00FF00FF00FF);
+	x = (x & 0x0000FFFF0000FFFF) + ((x >> 16) & 0x0000FFFF0000FFFF);
+	x = (x & 0x00000000FFFFFFFF) + ((x >> 32) & 0x00000000FFFFFFFF);
+	return (int) x;
+}
+#endif
+
+static inline void
+candmask_init(struct candmaskiter *ci, const CandMask *m, oid lo)
+{
+	BUN i = lo <= m->first ? 0 : (BUN) (lo - m->first);
+
+	ci->bits = m->bits;
+	ci->first = m->first;
+	ci->word = i >> 6;
+	ci->cur = i < m->nbits ? m->bits[ci->word] & (~(uint64_t) 0 << (i & 63)) : 0;
+}
+
+static inline oid
+candmask_next(struct candmaskiter *ci)
+{
+	oid o;
+
+	while (ci->cur == 0)
+		ci->cur = ci->bits[++ci->word];
+	o = ci->first + (ci->word << 6) + candmask_ctz(ci->cur);
+	ci->cur &= ci->cur - 1;
+	return o;
+}
+
+/* the number of candidates in the range [lo, hi) */
+static inline BUN
+candmask_count(const CandMask *m, oid lo, oid hi)
+{
+	BUN l, h, w, wl, wh, n;
+	uint64_t ml, mh;
+
+	if (hi <= m->first)
+		return 0;
+	l = lo <= m->first ? 0 : (BUN) (lo - m->first);
+	h = hi - m->first < m->nbits ? (BUN) (hi - m->first) : m->nbits;
+	if (l >= h)
+		return 0;
+	wl = l >> 6;
+	wh = (h - 1) >> 6;
+	ml = ~(uint64_t) 0 << (l & 63);
+	mh = ~(uint64_t) 0 >> (63 - ((h - 1) & 63));
+	if (wl == wh)
+		return (BUN) candmask_pop(m->bits[wl] & ml & mh);
+	n = (BUN) candmask_pop(m->bits[wl] & ml);
+	for (w = wl + 1; w < wh; w++)
+		n += (BUN) candmask_pop(m->bits[w]);
+	return n + (BUN) candmask_pop(m->bits[wh] & mh);
+}
@@ -0,0 +1,723 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2018 MonetDB B.V.
+ */
+
+/*
+ * Compression of persistent tail heaps.
+ *
+ * With the gdk_compress option set, the tail heap of a persistent
+ * BAT of an integer type (bte, sht, int, lng, and the types that are
+ * stored as one of those) is written to disk in compressed form when
+ * that saves at least a quarter of the space.  The heap is cut into
+ * blocks of COMP_BLOCKSIZE values, and each block is encoded with
+ * whichever of the following lightweight encodings is smallest for
+ * that block:
+ *
+ * COMP_RAW	the values as they are;
+ * COMP_FOR	frame of reference: the difference with the smallest
+ *		value of the block, bit packed;
+ * COMP_DELTA	the difference with the previous value, as frame of
+ *		reference relative to the smallest difference;
+ * COMP_RLE	run length encoding: run values and run lengths;
+ * COMP_DICT	a dictionary of the distinct values of the block and
+ *		the bit packed index in the dictionary of each value.
+ *
+ * The file starts with a CompHeader, which is followed by the blocks.
+ * Each block consists of a CompBlock and the encoded values, which
+ * are padded to a multiple of 8 bytes.  All arithmetic on the values
+ * is done modulo 2^64, so the encodings are lossless for any value,
+ * including nil.
+ *
+ * Only heaps that are saved by writing the whole file are compressed,
+ * i.e. heaps in malloced memory and copy-on-write memory mapped heaps
+ * (which are saved in a .new file).  Shared memory mapped heaps are
+ * saved by syncing the memory map, so their files stay uncompressed.
+ * A compressed file can be recognized because it is smaller than the
+ * heap and starts with COMP_MAGIC.  It is decompressed in one go when
+ * the BAT is loaded into a malloced heap, and the smallest and
+ * largest non-nil value of each block, which are recorded in the
+ * CompBlock, become the zone map of the BAT, so that range selects
+ * and the minimum and maximum can skip blocks without looking at the
+ * values again.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define COMP_MAGIC	"MonetCmp"
+#define COMP_VERSION	1
+#define COMP_BLOCKSHIFT	12	/* log2 of the number of values per block */
+#define COMP_BLOCKSIZE	((BUN) 1 << COMP_BLOCKSHIFT)
+#define COMP_MAXDICT	256	/* maximum dictionary size */
+
+enum {
+	COMP_RAW,
+	COMP_FOR,
+	COMP_DELTA,
+	COMP_RLE,
+	COMP_DICT,
+};
+
+typedef struct {
+	char magic[8];		/* COMP_MAGIC */
+	unsigned int version;	/* COMP_VERSION */
+	unsigned int width;	/* width of the values */
+	ulng free;		/* size of the decompressed heap */
+	ulng nblocks;		/* number of blocks */
+} CompHeader;
+
+typedef struct {
+	lng min, max;		/* smallest and largest non-nil value */
+	lng ref;		/* reference value of the encoding */
+	lng aux;		/* DELTA: smallest difference;
+				 * RLE: number of runs;
+				 * DICT: number of entries */
+	unsigned int nbytes;	/* size of the encoded values */
+	unsigned char enc;	/* encoding */
+	unsigned char bits;	/* bits per packed value */
+	unsigned short filler;
+} CompBlock;
+
+/* round up to a multiple of 8 bytes */
+#define COMP_ROUND(n)	(((n) + 7) & ~(size_t) 7)
+/* size of n bit packed values of the given number of bits */
+#define COMP_PACKED(n, bits)	((((size_t) (n) * (bits) + 63) / 64) * 8)
+
+static bool
+COMPsupported(int tpe)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+		return !ATOMvarsized(tpe);
+	default:
+		return false;
+	}
+}
+
+/* the number of bits needed to represent x */
+static int
+COMPbits(ulng x)
+{
+	int bits = 0;
+
+	while (x != 0) {
+		bits++;
+		x >>= 1;
+	}
+	return bits;
+}
+
+/* the nil value of values of the given width as lng */
+static lng
+COMPnil(int width)
+{
+	return width == 8 ? lng_nil : -((lng) 1 << (width * 8 - 1));
+}
+
+static void
+COMPget(lng *restrict dst, const void *src, BUN n, int width)
+{
+	BUN i;
+
+	switch (width) {
+	case 1:
+		for (i = 0; i < n; i++)
+			dst[i] = ((const bte *) src)[i];
+		break;
+	case 2:
+		for (i = 0; i < n; i++)
+			dst[i] = ((const sht *) src)[i];
+		break;
+	case 4:
+		for (i = 0; i < n; i++)
+			dst[i] = ((const int *) src)[i];
+		break;
+	default:
+		memcpy(dst, src, n * sizeof(lng));
+		break;
+	}
+}
+
+static void
+COMPput(void *dst, const lng *restrict src, BUN n, int width)
+{
+	BUN i;
+
+	switch (width) {
+	case 1:
+		for (i = 0; i < n; i++)
+			((bte *) dst)[i] = (bte) src[i];
+		break;
+	case 2:
+		for (i = 0; i < n; i++)
+			((sht *) dst)[i] = (sht) src[i];
+		break;
+	case 4:
+		for (i = 0; i < n; i++)
+			((int *) dst)[i] = (int) src[i];
+		break;
+	default:
+		memcpy(dst, src, n * sizeof(lng));
+		break;
+	}
+}
+
+/* bit pack src[i] - ref using 1 <= bits < 64 bits per value */
+static void
+COMPpack(ulng *restrict dst, const lng *restrict src, BUN n, int bits, lng ref)
+{
+	BUN i;
+
+	memset(dst, 0, COMP_PACKED(n, bits));
+	for (i = 0; i < n; i++) {
+		ulng x = (ulng) src[i] - (ulng) ref;
+		size_t off = (size_t) i * bits;
+		int s = (int) (off & 63);
+
+		dst[off >> 6] |= x << s;
+		if (s + bits > 64)
+			dst[(off >> 6) + 1] |= x >> (64 - s);
+	}
+}
+
+static void
+COMPunpack(lng *restrict dst, const ulng *restrict src, BUN n, int bits, lng ref)
+{
+	const ulng mask = ((ulng) 1 << bits) - 1;
+	BUN i;
+
+	for (i = 0; i < n; i++) {
+		size_t off = (size_t) i * bits;
+		int s = (int) (off & 63);
+		ulng x = src[off >> 6] >> s;
+
+		if (s + bits > 64)
+			x |= src[(off >> 6) + 1] << (64 - s);
+		dst[i] = (lng) ((ulng) ref + (x & mask));
+	}
+}
+
+static int
+COMPcmp(const void *a, const void *b)
+{
+	lng x = *(const lng *) a, y = *(const lng *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* encode the n values in v into blk and dst, which has room for the
+ * raw values; tmp is scratch space for 2 * COMP_BLOCKSIZE values */
+static void
+COMPencodeblock(CompBlock *blk, void *dst, const lng *restrict v, BUN n,
+		int width, lng *restrict tmp)
+{
+	const lng nil = COMPnil(width);
+	lng lo, hi, dlo = 0, dhi = 0;
+	BUN i, nruns = 1, ndict = 0;
+	size_t sz, best;
+	int forbits, deltabits = 0, dictbits = 0;
+
+	assert(n > 0 && n <= COMP_BLOCKSIZE);
+	/* the zone map uses the largest and smallest value of the
+	 * domain for blocks without non-nil values */
+	blk->min = ~nil;
+	blk->max = nil + 1;
+	lo = hi = v[0];
+	for (i = 0; i < n; i++) {
+		if (v[i] != nil) {
+			if (v[i] < blk->min)
+				blk->min = v[i];
+			if (v[i] > blk->max)
+				blk->max = v[i];
+		}
+		if (v[i] < lo)
+			lo = v[i];
+		if (v[i] > hi)
+			hi = v[i];
+		if (i > 0) {
+			lng d = (lng) ((ulng) v[i] - (ulng) v[i - 1]);
+
+			if (i == 1 || d < dlo)
+				dlo = d;
+			if (i == 1 || d > dhi)
+				dhi = d;
+			nruns += v[i] != v[i - 1];
+		}
+	}
+	forbits = COMPbits((ulng) hi - (ulng) lo);
+	if (n > 1)
+		deltabits = COMPbits((ulng) dhi - (ulng) dlo);
+	if (forbits > 4) {
+		/* a dictionary may need fewer bits than FOR */
+		memcpy(tmp, v, n * sizeof(lng));
+		qsort(tmp, n, sizeof(lng), COMPcmp);
+		for (i = 0; i < n && ndict <= COMP_MAXDICT; i++)
+			if (i == 0 || tmp[i] != tmp[ndict - 1])
+				tmp[ndict++] = tmp[i];
+		dictbits = COMPbits(ndict - 1);
+	}
+
+	/* pick the smallest encoding */
+	blk->enc = COMP_RAW;
+	blk->bits = 0;
+	blk->ref = blk->aux = 0;
+	best = COMP_ROUND(n * width);
+	if (forbits < width * 8 && (sz = COMP_PACKED(n, forbits)) < best) {
+		blk->enc = COMP_FOR;
+		blk->bits = (unsigned char) forbits;
+		best = sz;
+	}
+	if (n > 1 && deltabits < width * 8 &&
+	    (sz = COMP_PACKED(n - 1, deltabits)) < best) {
+		blk->enc = COMP_DELTA;
+		blk->bits = (unsigned char) deltabits;
+		best = sz;
+	}
+	if ((sz = COMP_ROUND(nruns * width) + COMP_ROUND(nruns * sizeof(unsigned short))) < best) {
+		blk->enc = COMP_RLE;
+		blk->bits = 0;
+		best = sz;
+	}
+	if (ndict > 0 && ndict <= COMP_MAXDICT &&
+	    (sz = COMP_ROUND(ndict * width) + COMP_PACKED(n, dictbits)) < best) {
+		blk->enc = COMP_DICT;
+		blk->bits = (unsigned char) dictbits;
+		best = sz;
+	}
+	blk->nbytes = (unsigned int) best;
+
+	switch (blk->enc) {
+	case COMP_RAW:
+		memset(dst, 0, best);
+		COMPput(dst, v, n, width);
+		break;
+	case COMP_FOR:
+		blk->ref = lo;
+		if (forbits > 0)
+			COMPpack(dst, v, n, forbits, lo);
+		break;
+	case COMP_DELTA:
+		blk->ref = v[0];
+		blk->aux = dlo;
+		for (i = 1; i < n; i++)
+			tmp[i - 1] = (lng) ((ulng) v[i] - (ulng) v[i - 1]);
+		if (deltabits > 0)
+			COMPpack(dst, tmp, n - 1, deltabits, dlo);
+		break;
+	case COMP_RLE: {
+		unsigned short *lens;
+		BUN r = 0;
+
+		blk->aux = (lng) nruns;
+		tmp[0] = v[0];
+		lens = (unsigned short *) ((char *) dst + COMP_ROUND(nruns * width));
+		memset(dst, 0, best);
+		lens[0] = 1;
+		for (i = 1; i < n; i++) {
+			if (v[i] == tmp[r]) {
+				lens[r]++;
+			} else {
+				tmp[++r] = v[i];
+				lens[r] = 1;
+			}
+		}
+		assert(r + 1 == nruns);
+		COMPput(dst, tmp, nruns, width);
+		break;
+	}
+	case COMP_DICT: {
+		ulng *packed = (ulng *) ((char *) dst + COMP_ROUND(ndict * width));
+		lng *idx = tmp + COMP_BLOCKSIZE;
+
+		blk->aux = (lng) ndict;
+		memset(dst, 0, COMP_ROUND(ndict * width));
+		COMPput(dst, tmp, ndict, width);
+		if (dictbits > 0) {
+			/* the dictionary is sorted: binary search */
+			for (i = 0; i < n; i++) {
+				BUN l = 0, h = ndict;
+
+				while (h - l > 1) {
+					BUN m = (l + h) / 2;
+					if (tmp[m] <= v[i])
+						l = m;
+					else
+						h = m;
+				}
+				idx[i] = (lng) l;
+			}
+			COMPpack(packed, idx, n, dictbits, 0);
+		}
+		break;
+	}
+	}
+}
+
+static gdk_return
+COMPdecodeblock(const CompBlock *blk, const void *src, size_t avail,
+		lng *restrict v, BUN n, int width)
+{
+	BUN i;
+
+	if (blk->nbytes > avail || blk->bits >= 64)
+		return GDK_FAIL;
+	switch (blk->enc) {
+	case COMP_RAW:
+		if (blk->nbytes < n * width)
+			return GDK_FAIL;
+		COMPget(v, src, n, width);
+		break;
+	case COMP_FOR:
+		if (blk->nbytes < COMP_PACKED(n, blk->bits))
+			return GDK_FAIL;
+		if (blk->bits == 0) {
+			for (i = 0; i < n; i++)
+				v[i] = blk->ref;
+		} else {
+			COMPunpack(v, src, n, blk->bits, blk->ref);
+		}
+		break;
+	case COMP_DELTA:
+		if (n < 2 || blk->nbytes < COMP_PACKED(n - 1, blk->bits))
+			return GDK_FAIL;
+		if (blk->bits == 0) {
+			for (i = 1; i < n; i++)
+				v[i] = blk->aux;
+		} else {
+			COMPunpack(v + 1, src, n - 1, blk->bits, blk->aux);
+		}
+		v[0] = blk->ref;
+		for (i = 1; i < n; i++)
+			v[i] = (lng) ((ulng) v[i - 1] + (ulng) v[i]);
+		break;
+	case COMP_RLE: {
+		BUN nruns = (BUN) blk->aux, r, j;
+		const unsigned short *lens;
+
+		if (blk->aux <= 0 || blk->aux > (lng) n ||
+		    blk->nbytes < COMP_ROUND(nruns * width) + nruns * sizeof(unsigned short))
+			return GDK_FAIL;
+		lens = (const unsigned short *) ((const char *) src + COMP_ROUND(nruns * width));
+		/* the run values go to the end of v, so that we can
+		 * expand them in place */
+		COMPget(v + n - nruns, src, nruns, width);
+		for (r = 0, i = 0; r < nruns; r++) {
+			lng x = v[n - nruns + r];
+
+			if (lens[r] == 0 || lens[r] > n - i)
+				return GDK_FAIL;
+			for (j = lens[r]; j > 0; j--)
+				v[i++] = x;
+		}
+		if (i != n)
+			return GDK_FAIL;
+		break;
+	}
+	case COMP_DICT: {
+		BUN ndict = (BUN) blk->aux;
+		lng dict[COMP_MAXDICT];
+
+		if (blk->aux <= 0 || blk->aux > COMP_MAXDICT ||
+		    blk->nbytes < COMP_ROUND(ndict * width) + COMP_PACKED(n, blk->bits))
+			return GDK_FAIL;
+		COMPget(dict, src, ndict, width);
+		if (blk->bits == 0) {
+			for (i = 0; i < n; i++)
+				v[i] = dict[0];
+			break;
+		}
+		COMPunpack(v, (const ulng *) ((const char *) src + COMP_ROUND(ndict * width)), n, blk->bits, 0);
+		for (i = 0; i < n; i++) {
+			if ((ulng) v[i] >= ndict)
+				return GDK_FAIL;
+			v[i] = dict[v[i]];
+		}
+		break;
+	}
+	default:
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+/* Compress the contents of heap h, which contains values of type
+ * tpe.  If it is worth it, *imgp is set to a malloced buffer with the
+ * compressed image, and *lenp to its size, otherwise *imgp is set to
+ * NULL. */
+gdk_return
+HEAPcompress(const Heap *h, int tpe, void **imgp, size_t *lenp)
+{
+	int width = ATOMsize(tpe);
+	BUN cnt, nblocks, blk;
+	size_t limit, len;
+	char *img;
+	lng *v, *tmp;
+	CompHeader *hdr;
+	lng t0 = 0;
+
+	*imgp = NULL;
+	*lenp = 0;
+	if (!COMPsupported(tpe) || h->base == NULL ||
+	    h->free < COMP_BLOCKSIZE || h->free % width != 0)
+		return GDK_SUCCEED;
+	HEAPDEBUG t0 = GDKusec();
+	cnt = (BUN) (h->free / width);
+	nblocks = (cnt + COMP_BLOCKSIZE - 1) >> COMP_BLOCKSHIFT;
+	/* give up as soon as the image exceeds this size */
+	limit = h->free - h->free / 4;
+	img = GDKmalloc(limit + sizeof(CompBlock) + COMP_BLOCKSIZE * sizeof(lng));
+	v = GDKmalloc(3 * COMP_BLOCKSIZE * sizeof(lng));
+	if (img == NULL || v == NULL) {
+		GDKfree(img);
+		GDKfree(v);
+		return GDK_FAIL;
+	}
+	tmp = v + COMP_BLOCKSIZE;
+	hdr = (CompHeader *) img;
+	memset(hdr, 0, sizeof(CompHeader));
+	memcpy(hdr->magic, COMP_MAGIC, sizeof(hdr->magic));
+	hdr->version = COMP_VERSION;
+	hdr->width = (unsigned int) width;
+	hdr->free = (ulng) h->free;
+	hdr->nblocks = (ulng) nblocks;
+	len = sizeof(CompHeader);
+	for (blk = 0; blk < nblocks && len <= limit; blk++) {
+		BUN p = blk << COMP_BLOCKSHIFT;
+		BUN n = MIN(cnt - p, COMP_BLOCKSIZE);
+		CompBlock *b = (CompBlock *) (img + len);
+
+		memset(b, 0, sizeof(CompBlock));
+		COMPget(v, h->base + p * width, n, width);
+		COMPencodeblock(b, b + 1, v, n, width, tmp);
+		len += sizeof(CompBlock) + b->nbytes;
+	}
+	GDKfree(v);
+	if (len > limit) {
+		GDKfree(img);
+		HEAPDEBUG fprintf(stderr, "#HEAPcompress(%s): not compressible\n",
+				  h->filename);
+		return GDK_SUCCEED;
+	}
+	HEAPDEBUG fprintf(stderr, "#HEAPcompress(%s): %zu bytes to %zu bytes "
+			  "(" LLFMT " usec)\n", h->filename, h->free, len,
+			  GDKusec() - t0);
+	*imgp = img;
+	*lenp = len;
+	return GDK_SUCCEED;
+}
+
+/* check whether img (of size len) is a compressed image of a heap of
+ * h->free bytes with values of type tpe */
+static bool
+COMPcheck(const Heap *h, int tpe, const void *img, size_t len)
+{
+	const CompHeader *hdr = img;
+	int width = ATOMsize(tpe);
+
+	return len >= sizeof(CompHeader) &&
+		memcmp(hdr->magic, COMP_MAGIC, sizeof(hdr->magic)) == 0 &&
+		hdr->version == COMP_VERSION &&
+		hdr->width == (unsigned int) width &&
+		hdr->free == (ulng) h->free &&
+		hdr->nblocks == (h->free / width + COMP_BLOCKSIZE - 1) >> COMP_BLOCKSHIFT;
+}
+
+/* Decompress the image img of size len into heap h, whose free field
+ * must have been set to the size of the decompressed heap.  The heap
+ * is allocated in memory. */
+gdk_return
+HEAPdecompress(Heap *h, int tpe, const void *img, size_t len)
+{
+	int width = ATOMsize(tpe);
+	BUN cnt, nblocks, blk;
+	size_t pos;
+	lng *v;
+	lng t0 = 0;
+
+	if (!COMPsupported(tpe) || !COMPcheck(h, tpe, img, len)) {
+		GDKerror("HEAPdecompress: not a compressed heap\n");
+		return GDK_FAIL;
+	}
+	HEAPDEBUG t0 = GDKusec();
+	cnt = (BUN) (h->free / width);
+	nblocks = (BUN) ((const CompHeader *) img)->nblocks;
+	if (h->size < h->free)
+		h->size = h->free;
+	if ((v = GDKmalloc(COMP_BLOCKSIZE * sizeof(lng))) == NULL)
+		return GDK_FAIL;
+	if ((h->base = GDKmalloc(h->size)) == NULL) {
+		GDKfree(v);
+		return GDK_FAIL;
+	}
+	pos = sizeof(CompHeader);
+	for (blk = 0; blk < nblocks; blk++) {
+		BUN p = blk << COMP_BLOCKSHIFT;
+		BUN n = MIN(cnt - p, COMP_BLOCKSIZE);
+		const CompBlock *b = (const CompBlock *) ((const char *) img + pos);
+
+		if (pos + sizeof(CompBlock) > len ||
+		    COMPdecodeblock(b, b + 1, len - pos - sizeof(CompBlock),
+				    v, n, width) != GDK_SUCCEED)
+			break;
+		COMPput(h->base + p * width, v, n, width);
+		pos += sizeof(CompBlock) + b->nbytes;
+	}
+	GDKfree(v);
+	if (blk < nblocks || pos != len) {
+		GDKfree(h->base);
+		h->base = NULL;
+		GDKerror("HEAPdecompress: corrupt compressed heap %s\n",
+			 h->filename);
+		return GDK_FAIL;
+	}
+	h->storage = h->newstorage = STORE_MEM;
+	h->dirty = false;
+	HEAPDEBUG fprintf(stderr, "#HEAPdecompress(%s): %zu bytes to %zu bytes "
+			  "(" LLFMT " usec)\n", h->filename, len, h->free,
+			  GDKusec() - t0);
+	return GDK_SUCCEED;
+}
+
+/* Save the tail heap of b as nme.tail, compressed if possible.  This
+ * replaces HEAPsave(&b->theap, nme, "tail") in BATsave. */
+gdk_return
+COMPsave(BAT *b, const char *nme)
+{
+	Heap *h = &b->theap;
+	const char *ext;
+	void *img;
+	size_t len;
+	gdk_return rc;
+
+	if (GDK_compress == 0 || !COMPsupported(b->ttype))
+		return HEAPsave(h, nme, "tail");
+	if (h->storage == STORE_MEM)
+		ext = "tail";
+	else if (h->newstorage == STORE_PRIV)
+		ext = "tail.new";	/* see HEAPsave_intern */
+	else
+		return HEAPsave(h, nme, "tail");
+	if (HEAPcompress(h, b->ttype, &img, &len) != GDK_SUCCEED) {
+		/* we can do without */
+		GDKclrerr();
+		return HEAPsave(h, nme, "tail");
+	}
+	if (img == NULL)
+		return HEAPsave(h, nme, "tail");
+	HEAPDEBUG fprintf(stderr, "#COMPsave(%s.%s,free=%zu,compressed=%zu)\n",
+			  nme, ext, h->free, len);
+	rc = GDKsave(h->farmid, nme, ext, img, len, STORE_MEM, true);
+	GDKfree(img);
+	return rc;
+}
+
+/* seed the zone map of b with the block minima and maxima of the
+ * compressed image img */
+#define COMPzone(TYPE)							\
+	do {								\
+		TYPE *restrict mn = zm->min, *restrict mx = zm->max;	\
+		for (blk = 0; blk < zm->nblocks; blk++) {		\
+			const CompBlock *cb = (const CompBlock *) (img + pos); \
+			mn[blk] = (TYPE) cb->min;			\
+			mx[blk] = (TYPE) cb->max;			\
+			pos += sizeof(CompBlock) + cb->nbytes;		\
+		}							\
+	} while (false)
+
+static void
+COMPzonemap(BAT *b, const char *img)
+{
+	Zonemap *zm;
+	size_t pos = sizeof(CompHeader);
+	BUN blk;
+
+	if ((zm = ZONEnew(b, COMP_BLOCKSHIFT)) == NULL) {
+		GDKclrerr();	/* we can do without */
+		return;
+	}
+	switch (ATOMsize(b->ttype)) {
+	case 1:
+		COMPzone(bte);
+		break;
+	case 2:
+		COMPzone(sht);
+		break;
+	case 4:
+		COMPzone(int);
+		break;
+	default:
+		COMPzone(lng);
+		break;
+	}
+}
+
+/* If the tail heap file of b is compressed, load it into memory and
+ * seed the zone map of b.  On success, b->theap.base is NULL if the
+ * file is not compressed, in which case it should be loaded with
+ * HEAPload. */
+gdk_return
+COMPload(BAT *b, const char *nme)
+{
+	Heap *h = &b->theap;
+	CompHeader hdr;
+	struct stat st;
+	char *img;
+	size_t len, i;
+	int fd;
+
+	h->base = NULL;
+	if (!COMPsupported(b->ttype) || h->free < COMP_BLOCKSIZE)
+		return GDK_SUCCEED;
+	/* a .new file takes precedence (see HEAPload_intern) */
+	if ((fd = GDKfdlocate(h->farmid, nme, "rb", "tail.new")) >= 0) {
+		close(fd);
+		if (GDKmove(h->farmid, BATDIR, nme, "tail.new", BATDIR, nme, "tail") != GDK_SUCCEED)
+			return GDK_FAIL;
+	}
+	if ((fd = GDKfdlocate(h->farmid, nme, "rb", "tail")) < 0) {
+		GDKclrerr();	/* HEAPload will complain */
+		return GDK_SUCCEED;
+	}
+	if (fstat(fd, &st) != 0 ||
+	    st.st_size >= (off_t) h->free ||
+	    read(fd, &hdr, sizeof(hdr)) != (ssize_t) sizeof(hdr) ||
+	    !COMPcheck(h, b->ttype, &hdr, sizeof(hdr))) {
+		/* not a compressed heap */
+		close(fd);
+		return GDK_SUCCEED;
+	}
+	len = (size_t) st.st_size;
+	if ((img = GDKmalloc(len)) == NULL) {
+		close(fd);
+		return GDK_FAIL;
+	}
+	memcpy(img, &hdr, sizeof(hdr));
+	for (i = sizeof(hdr); i < len; ) {
+		ssize_t n = read(fd, img + i, MIN(len - i, (size_t) 1 << 30));
+
+		if (n <= 0)
+			break;
+		i += (size_t) n;
+	}
+	close(fd);
+	if (i < len) {
+		GDKfree(img);
+		GDKerror("COMPload: cannot read %s.tail\n", nme);
+		return GDK_FAIL;
+	}
+	if (HEAPdecompress(h, b->ttype, img, len) != GDK_SUCCEED) {
+		GDKfree(img);
+		return GDK_FAIL;
+	}
+	COMPzonemap(b, img);
+	GDKfree(img);
+	return GDK_SUCCEED;
+}
@@ -98,6 +98,8 @@ BATundo(BAT *b)
 		int (*tunfix) (const void *) = BATatoms[b->ttype].atomUnfix;
 		void (*tatmdel) (Heap *, var_t *) = BATatoms[b->ttype].atomDel;
 
+		BHASHdestroy(b);
+		ZONEdestroy(b);
 		if (tunfix || tatmdel || b->thash) {
 			HASHdestroy(b);
 			for (p = bunfirst; p <= bunlast; p++, i++) {
@@ -895,3 +895,298 @@ BATfirstn(BAT **topn, BAT **gids, BAT *b, BAT *s, BAT *g, BUN n, bool asc, bool
 	}
 	return BATfirstn_grouped_with_groups(topn, gids, b, s, g, n, asc, distinct);
 }
+
+/* BATfirstnkeys selects the n rows that come first when the table
+ * consisting of the nkeys aligned columns bats[0], ..., bats[nkeys-1]
+ * is sorted on all those columns at once, with bats[0] the major key
+ * and bats[i] sorted in ascending order if asc[i] is set, else in
+ * descending order.  The optional candidate list s restricts the rows
+ * that are considered.  As with BATfirstn without gids, exactly N
+ * oids are returned (N being the smallest of n and the number of
+ * candidates), so if there are ties that take us past N, a subset of
+ * them is returned.
+ *
+ * Unlike a cascade of BATfirstn calls, which scans the input once
+ * for each key, this uses a single heap of oids ordered on all keys.
+ * If the input is large compared to n, it is split into slices that
+ * are processed in parallel, and the resulting candidates are merged
+ * with one more pass of the same algorithm. */
+
+struct firstnkey {
+	int tpe;		/* base type of the column */
+	bool asc;		/* sort direction */
+	const void *vals;	/* values of fixed size column */
+	oid seqbase;		/* seqbase of void column */
+	BATiter bi;		/* for variable sized column */
+	int (*cmp)(const void *, const void *);
+};
+
+#define CMPfix(TYPE)							\
+	do {								\
+		TYPE v1 = ((const TYPE *) k->vals)[p1];			\
+		TYPE v2 = ((const TYPE *) k->vals)[p2];			\
+		c = (v1 > v2) - (v1 < v2);				\
+	} while (0)
+/* nil sorts before everything else */
+#define CMPflt(TYPE)							\
+	do {								\
+		TYPE v1 = ((const TYPE *) k->vals)[p1];			\
+		TYPE v2 = ((const TYPE *) k->vals)[p2];			\
+		if (is_##TYPE##_nil(v1))				\
+			c = -!is_##TYPE##_nil(v2);			\
+		else if (is_##TYPE##_nil(v2))				\
+			c = 1;						\
+		else							\
+			c = (v1 > v2) - (v1 < v2);			\
+	} while (0)
+
+/* compare the rows at positions p1 and p2 on all keys */
+static inline int
+firstn_keycmp(const struct firstnkey *k, int nkeys, BUN p1, BUN p2)
+{
+	int i, c;
+
+	for (i = 0; i < nkeys; i++, k++) {
+		switch (k->tpe) {
+		case TYPE_void:
+			c = is_oid_nil(k->seqbase) ? 0 : (p1 > p2) - (p1 < p2);
+			break;
+		case TYPE_bte:
+			CMPfix(bte);
+			break;
+		case TYPE_sht:
+			CMPfix(sht);
+			break;
+		case TYPE_int:
+			CMPfix(int);
+			break;
+		case TYPE_lng:
+			CMPfix(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			CMPfix(hge);
+			break;
+#endif
+		case TYPE_flt:
+			CMPflt(flt);
+			break;
+		case TYPE_dbl:
+			CMPflt(dbl);
+			break;
+		default:
+			c = (*k->cmp)(BUNtail(k->bi, p1), BUNtail(k->bi, p2));
+			break;
+		}
+		if (c != 0)
+			return k->asc ? c : -c;
+	}
+	return 0;
+}
+
+#define LTkeys(p1, p2)	(firstn_keycmp(keys, nkeys,			\
+				       oids[p1] - hseqbase,		\
+				       oids[p2] - hseqbase) < 0)
+
+/* Fill oids with the first n of the cnt rows given by the candidates
+ * cand (if not NULL) or positions start, start+1, ... of the input.
+ * cnt must be at least n.  The resulting oids are sorted. */
+static void
+firstnkeys_heap(const struct firstnkey *keys, int nkeys, oid hseqbase,
+		oid *restrict oids, BUN n,
+		const oid *cand, BUN start, BUN cnt)
+{
+	BUN i;
+	/* variables used in heapify/siftup macros */
+	oid item;
+	BUN pos, childpos;
+
+	assert(cnt >= n);
+	if (n == 0)
+		return;
+	if (cand) {
+		for (i = 0; i < n; i++)
+			oids[i] = cand[i];
+	} else {
+		for (i = 0; i < n; i++)
+			oids[i] = start + i + hseqbase;
+	}
+	if (cnt > n) {
+		heapify(LTkeys, SWAP1);
+		for (i = n; i < cnt; i++) {
+			oid o = cand ? cand[i] : start + i + hseqbase;
+
+			if (firstn_keycmp(keys, nkeys, o - hseqbase,
+					  oids[0] - hseqbase) < 0) {
+				oids[0] = o;
+				siftup(LTkeys, 0, SWAP1);
+			}
+		}
+	}
+	GDKqsort(oids, NULL, NULL, (size_t) n, sizeof(oid), 0, TYPE_oid);
+}
+
+/* minimum number of rows per thread, and minimum ratio between that
+ * and n, for the parallel version */
+#define FIRSTN_PAR_MIN		((BUN) 1 << 18)
+#define FIRSTN_PAR_RATIO	16
+
+struct firstnpar {
+	const struct firstnkey *keys;
+	int nkeys;
+	oid hseqbase;
+	oid *oids;		/* result slice */
+	BUN n;			/* number of results */
+	const oid *cand;	/* candidates of this slice, or NULL */
+	BUN start, cnt;		/* rows of this slice */
+	MT_Id tid;
+	bool started;
+};
+
+static void
+FIRSTNparworker(void *arg)
+{
+	struct firstnpar *fp = arg;
+
+	firstnkeys_heap(fp->keys, fp->nkeys, fp->hseqbase, fp->oids, fp->n,
+			fp->cand, fp->start, fp->cnt);
+}
+
+gdk_return
+BATfirstnkeys(BAT **topn, BAT **bats, const bool *asc, int nkeys, BAT *s, BUN n)
+{
+	BAT *b, *bn;
+	BUN start, end, cnt;
+	const oid *cand, *candend;
+	struct firstnkey *keys;
+	oid *oids;
+	int i, nthreads;
+	lng t0 = 0;
+
+	assert(topn != NULL);
+	assert(nkeys > 0);
+	ALGODEBUG t0 = GDKusec();
+
+	b = bats[0];
+	for (i = 1; i < nkeys; i++) {
+		if (BATcount(bats[i]) != BATcount(b) ||
+		    bats[i]->hseqbase != b->hseqbase) {
+			GDKerror("BATfirstnkeys: key columns must be aligned.\n");
+			return GDK_FAIL;
+		}
+	}
+	if (nkeys == 1)
+		return BATfirstn(topn, NULL, b, s, NULL, n, asc[0], false);
+
+	CANDINIT(b, s, start, end, cnt, cand, candend);
+	if (cand)
+		cnt = (BUN) (candend - cand);
+	if (n == 0 || cnt == 0) {
+		/* trivial: empty result */
+		*topn = BATdense(0, 0, 0);
+		return *topn ? GDK_SUCCEED : GDK_FAIL;
+	}
+	if (n >= cnt) {
+		/* trivial: return all candidates */
+		if (cand)
+			*topn = BATslice(s,
+					 (BUN) (cand - (const oid *) Tloc(s, 0)),
+					 (BUN) (candend - (const oid *) Tloc(s, 0)));
+		else
+			*topn = BATdense(0, start + b->hseqbase, cnt);
+		return *topn ? GDK_SUCCEED : GDK_FAIL;
+	}
+
+	keys = GDKmalloc(nkeys * sizeof(struct firstnkey));
+	if (keys == NULL)
+		return GDK_FAIL;
+	for (i = 0; i < nkeys; i++) {
+		keys[i].tpe = ATOMbasetype(bats[i]->ttype);
+		keys[i].asc = asc[i];
+		keys[i].vals = bats[i]->ttype == TYPE_void ? NULL : Tloc(bats[i], 0);
+		keys[i].seqbase = bats[i]->tseqbase;
+		keys[i].bi = bat_iterator(bats[i]);
+		keys[i].cmp = ATOMcompare(bats[i]->ttype);
+	}
+
+	nthreads = GDKnr_threads;
+	if ((BUN) nthreads > cnt / FIRSTN_PAR_MIN)
+		nthreads = (int) (cnt / FIRSTN_PAR_MIN);
+	if ((BUN) nthreads > cnt / (n * FIRSTN_PAR_RATIO))
+		nthreads = (int) (cnt / (n * FIRSTN_PAR_RATIO));
+	if (nthreads < 1)
+		nthreads = 1;
+
+	bn = COLnew(0, TYPE_oid, n, TRANSIENT);
+	if (bn == NULL) {
+		GDKfree(keys);
+		return GDK_FAIL;
+	}
+	oids = (oid *) Tloc(bn, 0);
+	if (nthreads == 1) {
+		firstnkeys_heap(keys, nkeys, b->hseqbase, oids, n,
+				cand, start, cnt);
+	} else {
+		struct firstnpar *fp;
+		oid *poids;
+		BUN lo, sz;
+
+		fp = GDKzalloc(nthreads * sizeof(struct firstnpar));
+		poids = GDKmalloc(nthreads * n * sizeof(oid));
+		if (fp == NULL || poids == NULL) {
+			GDKfree(fp);
+			GDKfree(poids);
+			GDKfree(keys);
+			BBPreclaim(bn);
+			return GDK_FAIL;
+		}
+		/* each slice results in its first n rows; the slices
+		 * are in order, so the concatenation of the results is
+		 * sorted */
+		for (i = 0, lo = 0; i < nthreads; i++, lo += sz) {
+			sz = cnt / nthreads + ((BUN) i < cnt % nthreads);
+			fp[i].keys = keys;
+			fp[i].nkeys = nkeys;
+			fp[i].hseqbase = b->hseqbase;
+			fp[i].oids = poids + i * n;
+			fp[i].n = n;
+			fp[i].cand = cand ? cand + lo : NULL;
+			fp[i].start = start + lo;
+			fp[i].cnt = sz;
+		}
+		for (i = 1; i < nthreads; i++)
+			fp[i].started = MT_create_thread(&fp[i].tid,
+							 FIRSTNparworker,
+							 &fp[i],
+							 MT_THR_JOINABLE) == 0;
+		FIRSTNparworker(&fp[0]);
+		for (i = 1; i < nthreads; i++) {
+			if (fp[i].started)
+				MT_join_thread(fp[i].tid);
+			else
+				FIRSTNparworker(&fp[i]); /* couldn't start thread */
+		}
+		/* merge: the first n of the candidates found per slice */
+		firstnkeys_heap(keys, nkeys, b->hseqbase, oids, n,
+				poids, 0, nthreads * n);
+		GDKfree(fp);
+		GDKfree(poids);
+	}
+	GDKfree(keys);
+
+	BATsetcount(bn, n);
+	bn->tsorted = true;
+	bn->trevsorted = n <= 1;
+	bn->tkey = true;
+	bn->tseqbase = n <= 1 ? oids[0] : oid_nil;
+	bn->tnil = false;
+	bn->tnonil = true;
+	ALGODEBUG fprintf(stderr, "#BATfirstnkeys(" ALGOBATFMT ",nkeys=%d,"
+			  "s=" ALGOOPTBATFMT ",n=" BUNFMT "): %d thread%s "
+			  "(" LLFMT " usec)\n",
+			  ALGOBATPAR(b), nkeys, ALGOOPTBATPAR(s), n,
+			  nthreads, nthreads == 1 ? "" : "s",
+			  GDKusec() - t0);
+	*topn = bn;
+	return GDK_SUCCEED;
+}
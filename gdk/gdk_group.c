@@ -40,7 +40,7 @@
  * is always created.  In other words, the groups argument may not be
  * NULL, but the extents and histo arguments may be NULL.
  *
- * There are six different implementations of the grouping code.
+ * There are seven different implementations of the grouping code.
  *
  * If it can be trivially determined that all groups are singletons,
  * we can produce the outputs trivially.
@@ -58,7 +58,14 @@
  *
  * If a hash table already exists on b, we can make use of it.
  *
- * Otherwise we build a partial hash table on the fly.
+ * Otherwise we build a partial hash table on the fly.  If the input
+ * is large, consists of fixed size values and appears to have many
+ * distinct values, we do this with multiple threads: the rows are
+ * radix-partitioned on a hash of the value (and old group), each
+ * thread groups the rows of its own partitions using a private hash
+ * table, and the partial groupings are merged by numbering the groups
+ * in order of their first occurrence.  The result is exactly the same
+ * as that of the serial code.
  *
  * A decision should be made on the order in which grouping occurs.
  * Let |b| have << different values than |g| then the linked lists
@@ -489,9 +496,440 @@ pop(oid x)
 	)
 
 
+/*
+ * Parallel grouping.
+ *
+ * The rows are processed in five phases, each of which is executed
+ * by all threads at the same time.  In the first two phases, the
+ * rows are partitioned on the top bits of a hash of the value (and
+ * old group): each thread counts and then scatters the rows of its
+ * own range of rows, so that within a partition the rows are in
+ * ascending order.  In the third phase each thread groups the rows of
+ * its partitions using a private hash table, and records for each row
+ * the slot of its group (the partition's offset plus the local group
+ * number), marking the rows that start a new group.  Since all rows
+ * of a group are in the same partition, the groups are now known, and
+ * we only need to number them in order of their first occurrence to
+ * get the same group ids as the serial code: the fourth phase counts
+ * the first occurrences in each thread's range of rows, and the fifth
+ * hands out the group ids and translates the slots.
+ *
+ * The positions array is reused: in the grouping phase the slot of a
+ * group holds the row of its first occurrence, and in the last phase
+ * it holds the group id.
+ *
+ * Values are compared by their bit patterns, which for floating point
+ * values differs from the serial code only in the treatment of NaNs
+ * other than nil.
+ */
+#define GROUP_PAR_MIN	((BUN) 1 << 18) /* min nr of rows per thread */
+#define GROUP_PAR_PART	((BUN) 1 << 16) /* target nr of rows per partition */
+#define GROUP_PAR_MAXBITS	10 /* max fan-out of the partitioning */
+#define GROUP_PAR_SAMPLE	512 /* nr of rows to estimate the nr of groups */
+#define GROUP_PAR_FIRST	((oid) 1 << (8 * SIZEOF_OID - 1)) /* first occurrence */
+#define GROUP_PAR_NIL	(~(BUN) 0) /* end of hash chain (all bits set) */
+
+struct grppar {
+	const void *vals;	/* the values (position 0) */
+	int width;		/* width of the values */
+	const oid *cand;	/* candidate list, or NULL */
+	BUN start;		/* position of row 0 if no candidate list */
+	oid hseqbase;		/* of the input BAT */
+	const oid *grps;	/* old groups, or NULL */
+	BUN lo, hi;		/* rows counted/scattered/numbered */
+	int pbits;		/* log2 of the number of partitions */
+	int nthreads;
+	int id;			/* this thread's partitions: id + k*nthreads */
+	int phase;		/* see above */
+	BUN *cnts;		/* per partition counts/offsets into pos */
+	BUN *pos;		/* rows grouped by partition */
+	const BUN *bounds;	/* partition boundaries in pos */
+	BUN *bkts, *lnks;	/* private hash table of the grouping phase */
+	oid *ngrps;		/* output: group ids */
+	lng *lcnts;		/* per slot group sizes, or NULL */
+	BUN nfirst;		/* nr of first occurrences/next group id */
+	oid *exts;		/* output: extents, or NULL */
+	lng *hcnts;		/* output: histogram, or NULL */
+	bool sorted;		/* whether the group ids in [lo,hi) ascend */
+	MT_Id tid;
+	bool started;
+};
+
+#define GRPparpos(gp, r)	((gp)->cand ? (gp)->cand[r] - (gp)->hseqbase : (gp)->start + (r))
+
+static inline ulng
+GRPparhash(const struct grppar *gp, BUN r)
+{
+	BUN p = GRPparpos(gp, r);
+	ulng v;
+
+	switch (gp->width) {
+	case 1:
+		v = ((const unsigned char *) gp->vals)[p];
+		break;
+	case 2:
+		v = ((const unsigned short *) gp->vals)[p];
+		break;
+	case 4:
+		v = ((const unsigned int *) gp->vals)[p];
+		break;
+	case 8:
+		v = ((const ulng *) gp->vals)[p];
+		break;
+#ifdef HAVE_HGE
+	case 16:
+		v = (ulng) ((const uhge *) gp->vals)[p] ^
+			(ulng) (((const uhge *) gp->vals)[p] >> 64);
+		break;
+#endif
+	default:
+		assert(0);
+		v = 0;
+	}
+	if (gp->grps)
+		v ^= (ulng) gp->grps[r] * UINT64_C(0xC2B2AE3D27D4EB4F);
+	return v * UINT64_C(0x9E3779B97F4A7C15);
+}
+
+static inline bool
+GRPparequal(const struct grppar *gp, BUN r1, BUN r2)
+{
+	BUN p1 = GRPparpos(gp, r1), p2 = GRPparpos(gp, r2);
+
+	if (gp->grps && gp->grps[r1] != gp->grps[r2])
+		return false;
+	switch (gp->width) {
+	case 1:
+		return ((const bte *) gp->vals)[p1] == ((const bte *) gp->vals)[p2];
+	case 2:
+		return ((const sht *) gp->vals)[p1] == ((const sht *) gp->vals)[p2];
+	case 4:
+		return ((const int *) gp->vals)[p1] == ((const int *) gp->vals)[p2];
+	case 8:
+		return ((const lng *) gp->vals)[p1] == ((const lng *) gp->vals)[p2];
+#ifdef HAVE_HGE
+	case 16:
+		return ((const hge *) gp->vals)[p1] == ((const hge *) gp->vals)[p2];
+#endif
+	default:
+		assert(0);
+		return false;
+	}
+}
+
+static void
+GRPparworker(void *arg)
+{
+	struct grppar *gp = arg;
+	BUN *restrict cnts = gp->cnts;
+	BUN *restrict pos = gp->pos;
+	oid *restrict ngrps = gp->ngrps;
+	int pshift = 64 - gp->pbits;
+	BUN r, i, j, k, off, n;
+
+	switch (gp->phase) {
+	case 0:
+		for (r = gp->lo; r < gp->hi; r++)
+			cnts[GRPparhash(gp, r) >> pshift]++;
+		break;
+	case 1:
+		for (r = gp->lo; r < gp->hi; r++)
+			pos[cnts[GRPparhash(gp, r) >> pshift]++] = r;
+		break;
+	case 2:
+		for (k = (BUN) gp->id; k < ((BUN) 1 << gp->pbits); k += gp->nthreads) {
+			int lbits;
+			BUN lmask, nloc = 0;
+
+			off = gp->bounds[k];
+			n = gp->bounds[k + 1] - off;
+			if (n == 0)
+				continue;
+			for (lbits = 1; ((BUN) 1 << lbits) < n; lbits++)
+				;
+			if (lbits > pshift)
+				lbits = pshift;
+			lmask = ((BUN) 1 << lbits) - 1;
+			memset(gp->bkts, 0xFF, ((size_t) lmask + 1) * sizeof(BUN));
+			for (i = off; i < off + n; i++) {
+				BUN bkt;
+
+				r = pos[i];
+				bkt = (BUN) (GRPparhash(gp, r) >> (pshift - lbits)) & lmask;
+				for (j = gp->bkts[bkt];
+				     j != GROUP_PAR_NIL;
+				     j = gp->lnks[j]) {
+					/* slot off+j holds the first
+					 * row of local group j */
+					if (GRPparequal(gp, pos[off + j], r))
+						break;
+				}
+				if (j == GROUP_PAR_NIL) {
+					/* new group; off + nloc <= i, so
+					 * we only overwrite rows we've
+					 * already done */
+					j = nloc++;
+					pos[off + j] = r;
+					gp->lnks[j] = gp->bkts[bkt];
+					gp->bkts[bkt] = j;
+					ngrps[r] = (off + j) | GROUP_PAR_FIRST;
+					if (gp->lcnts)
+						gp->lcnts[off + j] = 1;
+				} else {
+					ngrps[r] = off + j;
+					if (gp->lcnts)
+						gp->lcnts[off + j]++;
+				}
+			}
+		}
+		break;
+	case 3:
+		for (r = gp->lo; r < gp->hi; r++)
+			gp->nfirst += (ngrps[r] & GROUP_PAR_FIRST) != 0;
+		break;
+	case 4:
+		/* number the groups in order of first occurrence, and
+		 * tell the slot of each group its id */
+		for (r = gp->lo; r < gp->hi; r++) {
+			if (ngrps[r] & GROUP_PAR_FIRST) {
+				i = ngrps[r] &= ~GROUP_PAR_FIRST;
+				j = gp->nfirst++;
+				pos[i] = j;
+				if (gp->exts)
+					gp->exts[j] = gp->hseqbase + GRPparpos(gp, r);
+				if (gp->hcnts)
+					gp->hcnts[j] = gp->lcnts[i];
+			}
+		}
+		break;
+	case 5:
+		gp->sorted = true;
+		for (r = gp->lo; r < gp->hi; r++) {
+			ngrps[r] = pos[ngrps[r]];
+			if (r > gp->lo && ngrps[r] < ngrps[r - 1])
+				gp->sorted = false;
+		}
+		break;
+	}
+}
+
+/* run one phase on all threads, the calling thread being the first */
+static void
+GRPparrun(struct grppar *gp, int phase)
+{
+	int i, nthreads = gp[0].nthreads;
+
+	for (i = 0; i < nthreads; i++)
+		gp[i].phase = phase;
+	for (i = 1; i < nthreads; i++)
+		gp[i].started = MT_create_thread(&gp[i].tid, GRPparworker,
+						 &gp[i], MT_THR_JOINABLE) == 0;
+	GRPparworker(&gp[0]);
+	for (i = 1; i < nthreads; i++) {
+		if (gp[i].started)
+			MT_join_thread(gp[i].tid);
+		else
+			GRPparworker(&gp[i]); /* couldn't start thread */
+	}
+}
+
+static void
+GRPparfree(struct grppar *gp)
+{
+	int i;
+
+	for (i = 0; i < gp[0].nthreads; i++) {
+		GDKfree(gp[i].bkts);
+		GDKfree(gp[i].lnks);
+	}
+	GDKfree(gp[0].cnts);
+	GDKfree(gp[0].pos);
+	GDKfree((BUN *) gp[0].bounds);
+	GDKfree(gp[0].lcnts);
+	GDKfree(gp);
+}
+
+/* Group the cnt rows (positions start + r, or cand[r] - hseqbase)
+ * of b, whose values are of the fixed size type t, within the old
+ * groups grps (if not NULL), using at most nthreads threads.  This
+ * runs the phases up to and including the counting of the groups,
+ * and returns the state for GRPparfinish, with the number of groups
+ * in *ngrpp.  Returns NULL if the parallel algorithm is not suitable
+ * or the scratch space couldn't be allocated; ngrps may then have
+ * been overwritten, but nothing else has been touched. */
+static struct grppar *
+GRPparstart(BAT *b, int t, const oid *cand, BUN start, BUN cnt,
+	    const oid *grps, oid *ngrps, bool histo, int nthreads,
+	    BUN *ngrpp)
+{
+	struct grppar *gp;
+	BUN *cnts, *pos, *bounds;
+	lng *lcnts = NULL;
+	ulng seen[2 * GROUP_PAR_SAMPLE];
+	BUN i, j, sum, maxpart, ndistinct = 0;
+	int pbits, k, nparts;
+	struct grppar tmp = {
+		.vals = Tloc(b, 0),
+		.width = ATOMsize(t),
+		.cand = cand,
+		.start = start,
+		.hseqbase = b->hseqbase,
+		.grps = grps,
+	};
+
+	switch (t) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		break;
+	default:
+		return NULL;
+	}
+	if ((BUN) nthreads > cnt / GROUP_PAR_MIN)
+		nthreads = (int) (cnt / GROUP_PAR_MIN);
+	if (nthreads <= 1)
+		return NULL;
+
+	/* with few groups the serial code is fast enough and the
+	 * partitions would be badly skewed, so estimate the number
+	 * of groups from the number of distinct hash values in a
+	 * sample of the rows */
+	memset(seen, 0, sizeof(seen));
+	for (i = 0; i < GROUP_PAR_SAMPLE; i++) {
+		ulng h = GRPparhash(&tmp, i * (cnt / GROUP_PAR_SAMPLE)) | 1;
+
+		for (j = h >> 40; seen[j % (2 * GROUP_PAR_SAMPLE)] != 0; j++)
+			if (seen[j % (2 * GROUP_PAR_SAMPLE)] == h)
+				break;
+		if (seen[j % (2 * GROUP_PAR_SAMPLE)] == 0) {
+			seen[j % (2 * GROUP_PAR_SAMPLE)] = h;
+			ndistinct++;
+		}
+	}
+	if (ndistinct < GROUP_PAR_SAMPLE / 2)
+		return NULL;
+
+	/* a few partitions per thread to balance the load, and more
+	 * to keep the private hash tables small */
+	for (pbits = 1;
+	     pbits < GROUP_PAR_MAXBITS &&
+		     ((1 << pbits) < 4 * nthreads ||
+		      (cnt >> pbits) > GROUP_PAR_PART);
+	     pbits++)
+		;
+	nparts = 1 << pbits;
+
+	gp = GDKzalloc(nthreads * sizeof(*gp));
+	cnts = GDKzalloc((size_t) nthreads * nparts * sizeof(BUN));
+	bounds = GDKmalloc((nparts + 1) * sizeof(BUN));
+	pos = GDKmalloc(cnt * sizeof(BUN));
+	if (histo)
+		lcnts = GDKmalloc(cnt * sizeof(lng));
+	if (gp == NULL || cnts == NULL || bounds == NULL || pos == NULL ||
+	    (histo && lcnts == NULL)) {
+		GDKfree(gp);
+		GDKfree(cnts);
+		GDKfree(bounds);
+		GDKfree(pos);
+		GDKfree(lcnts);
+		GDKclrerr();
+		return NULL;
+	}
+	for (k = 0; k < nthreads; k++) {
+		gp[k] = tmp;
+		gp[k].lo = cnt / nthreads * k;
+		gp[k].hi = k == nthreads - 1 ? cnt : cnt / nthreads * (k + 1);
+		gp[k].pbits = pbits;
+		gp[k].nthreads = nthreads;
+		gp[k].id = k;
+		gp[k].cnts = cnts + (size_t) k * nparts;
+		gp[k].pos = pos;
+		gp[k].bounds = bounds;
+		gp[k].ngrps = ngrps;
+		gp[k].lcnts = lcnts;
+	}
+	GRPparrun(gp, 0);
+	/* turn the counts into offsets: partition by partition, and
+	 * within a partition thread by thread (i.e. row order) */
+	for (sum = 0, maxpart = 0, k = 0; k < nparts; k++) {
+		bounds[k] = sum;
+		for (j = 0; j < (BUN) nthreads; j++) {
+			BUN n = gp[j].cnts[k];
+			gp[j].cnts[k] = sum;
+			sum += n;
+		}
+		if (sum - bounds[k] > maxpart)
+			maxpart = sum - bounds[k];
+	}
+	bounds[nparts] = sum;
+	assert(sum == cnt);
+	/* the private hash tables: one bucket per row of the largest
+	 * partition, rounded up to a power of two, and one link per
+	 * row */
+	for (i = 2; i < maxpart; i <<= 1)
+		;
+	for (k = 0; k < nthreads; k++) {
+		gp[k].bkts = GDKmalloc(i * sizeof(BUN));
+		gp[k].lnks = GDKmalloc(maxpart * sizeof(BUN));
+		if (gp[k].bkts == NULL || gp[k].lnks == NULL) {
+			GRPparfree(gp);
+			GDKclrerr();
+			return NULL;
+		}
+	}
+	GRPparrun(gp, 1);
+	GRPparrun(gp, 2);
+	for (k = 0; k < nthreads; k++) {
+		GDKfree(gp[k].bkts);
+		GDKfree(gp[k].lnks);
+		gp[k].bkts = gp[k].lnks = NULL;
+	}
+	GRPparrun(gp, 3);
+	for (sum = 0, k = 0; k < nthreads; k++) {
+		BUN n = gp[k].nfirst;
+		gp[k].nfirst = sum;
+		sum += n;
+	}
+	*ngrpp = sum;
+	return gp;
+}
+
+/* Finish the parallel grouping started by GRPparstart: fill in the
+ * group ids, and the extents and histogram if requested, which must
+ * have room for all groups.  Returns whether the group ids are
+ * sorted.  The state is freed. */
+static bool
+GRPparfinish(struct grppar *gp, oid *exts, lng *cnts)
+{
+	int k, nthreads = gp[0].nthreads;
+	bool sorted = true;
+
+	for (k = 0; k < nthreads; k++) {
+		gp[k].exts = exts;
+		gp[k].hcnts = cnts;
+	}
+	GRPparrun(gp, 4);
+	GRPparrun(gp, 5);
+	for (k = 0; k < nthreads; k++) {
+		sorted &= gp[k].sorted;
+		if (k > 0 && gp[k].lo < gp[k].hi &&
+		    gp[k].ngrps[gp[k].lo] < gp[k].ngrps[gp[k].lo - 1])
+			sorted = false;
+	}
+	GRPparfree(gp);
+	return sorted;
+}
+
 gdk_return
 BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
-		  BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted)
+		  BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted,
+		  int nthreads)
 {
 	BAT *gn = NULL, *en = NULL, *hn = NULL;
 	int t;
@@ -512,6 +950,7 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	const oid *restrict cand, *candend;
 	oid maxgrp = oid_nil;	/* maximum value of g BAT (if subgrouping) */
 	PROPrec *prop;
+	struct grppar *gp;
 
 	if (b == NULL) {
 		GDKerror("BATgroup: b must exist\n");
@@ -738,7 +1177,7 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 	/* for strings we can use the offset instead of the actual
 	 * string values if we know that the strings in the string
 	 * heap are unique */
-	if (t == TYPE_str && GDK_ELIMDOUBLES(b->tvheap)) {
+	if (t == TYPE_str && GDK_ELIMALL(b->tvheap)) {
 		switch (b->twidth) {
 		case 1:
 			t = TYPE_bte;
@@ -1030,6 +1469,37 @@ BATgroup_internal(BAT **groups, BAT **extents, BAT **histo,
 			GRP_use_existing_hash_table_any();
 			break;
 		}
+	} else if (nthreads > 1 && cnt >= 2 * GROUP_PAR_MIN &&
+		   (gp = GRPparstart(b, t, cand, start, cnt, grps, ngrps,
+				     histo != NULL, nthreads, &r)) != NULL) {
+		/* large input with many groups: build partial hash
+		 * tables on the partitions of the input in parallel */
+		ALGODEBUG fprintf(stderr, "#BATgroup(b=%s#" BUNFMT "[%s],"
+				  "s=%s#" BUNFMT ","
+				  "g=%s#" BUNFMT ","
+				  "e=%s#" BUNFMT ","
+				  "h=%s#" BUNFMT ",subsorted=%d): "
+				  "create partial hash tables in parallel "
+				  "(%d threads)\n",
+				  BATgetId(b), BATcount(b), ATOMname(b->ttype),
+				  s ? BATgetId(s) : "NULL", s ? BATcount(s) : 0,
+				  g ? BATgetId(g) : "NULL", g ? BATcount(g) : 0,
+				  e ? BATgetId(e) : "NULL", e ? BATcount(e) : 0,
+				  h ? BATgetId(h) : "NULL", h ? BATcount(h) : 0,
+				  subsorted, gp[0].nthreads);
+		ngrp = (oid) r;
+		if (ngrp > maxgrps) {
+			if ((extents && BATextend(en, ngrp) != GDK_SUCCEED) ||
+			    (histo && BATextend(hn, ngrp) != GDK_SUCCEED)) {
+				GRPparfree(gp);
+				goto error;
+			}
+			if (extents)
+				exts = (oid *) Tloc(en, 0);
+			if (histo)
+				cnts = (lng *) Tloc(hn, 0);
+		}
+		gn->tsorted = GRPparfinish(gp, exts, cnts);
 	} else {
 		bool gc = g != NULL && (BATordered(g) || BATordered_rev(g));
 		const char *nme;
@@ -1209,5 +1679,14 @@ gdk_return
 BATgroup(BAT **groups, BAT **extents, BAT **histo,
 	 BAT *b, BAT *s, BAT *g, BAT *e, BAT *h)
 {
-	return BATgroup_internal(groups, extents, histo, b, s, g, e, h, false);
+	return BATgroup_internal(groups, extents, histo, b, s, g, e, h, false,
+				 GDKnr_threads);
+}
+
+gdk_return
+BATgroupthreads(BAT **groups, BAT **extents, BAT **histo,
+		BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, int nthreads)
+{
+	return BATgroup_internal(groups, extents, histo, b, s, g, e, h, false,
+				 nthreads);
 }
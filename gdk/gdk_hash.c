@@ -243,48 +243,72 @@ BATcheckhash(BAT *b)
 }
 
 #ifdef PERSISTENTHASH
+/* mark the hash heap hp as persisted and write it to disk; called
+ * with GDKhashLock held */
 static void
-BAThashsync(void *arg)
+HASHpersist(Heap *hp, const char *func, lng t0)
 {
-	BAT *b = arg;
 	int fd;
-	lng t0 = 0;
 	const char *failed = " failed";
 
-	ALGODEBUG t0 = GDKusec();
-
-	MT_lock_set(&GDKhashLock(b->batCacheid));
-	if (b->thash != NULL) {
-		Heap *hp = &b->thash->heap;
-		if (HEAPsave(hp, hp->filename, NULL) == GDK_SUCCEED) {
-			if (hp->storage == STORE_MEM) {
-				if ((fd = GDKfdlocate(hp->farmid, hp->filename, "rb+", NULL)) >= 0) {
-					((size_t *) hp->base)[0] |= (size_t) 1 << 24;
-					if (write(fd, hp->base, SIZEOF_SIZE_T) >= 0) {
-						failed = ""; /* not failed */
-						if (!(GDKdebug & NOSYNCMASK)) {
+	if (HEAPsave(hp, hp->filename, NULL) == GDK_SUCCEED) {
+		if (hp->storage == STORE_MEM) {
+			if ((fd = GDKfdlocate(hp->farmid, hp->filename, "rb+", NULL)) >= 0) {
+				((size_t *) hp->base)[0] |= (size_t) 1 << 24;
+				if (write(fd, hp->base, SIZEOF_SIZE_T) >= 0) {
+					failed = ""; /* not failed */
+					if (!(GDKdebug & NOSYNCMASK)) {
 #if defined(NATIVE_WIN32)
-							_commit(fd);
+						_commit(fd);
 #elif defined(HAVE_FDATASYNC)
-							fdatasync(fd);
+						fdatasync(fd);
 #elif defined(HAVE_FSYNC)
-							fsync(fd);
+						fsync(fd);
 #endif
-						}
-					} else {
-						perror("write hash");
 					}
-					close(fd);
+				} else {
+					perror("write hash");
 				}
-			} else {
-				((size_t *) hp->base)[0] |= (size_t) 1 << 24;
-				if (!(GDKdebug & NOSYNCMASK) &&
-				    MT_msync(hp->base, SIZEOF_SIZE_T) < 0)
-					((size_t *) hp->base)[0] &= ~((size_t) 1 << 24);
+				close(fd);
 			}
-			ALGODEBUG fprintf(stderr, "#BAThash: persisting hash %s (" LLFMT " usec)%s\n", hp->filename, GDKusec() - t0, failed);
+		} else {
+			((size_t *) hp->base)[0] |= (size_t) 1 << 24;
+			if (!(GDKdebug & NOSYNCMASK) &&
+			    MT_msync(hp->base, SIZEOF_SIZE_T) < 0)
+				((size_t *) hp->base)[0] &= ~((size_t) 1 << 24);
+			else
+				failed = "";
 		}
+		ALGODEBUG fprintf(stderr, "#%s: persisting hash %s (" LLFMT " usec)%s\n", func, hp->filename, GDKusec() - t0, failed);
 	}
+}
+
+static void
+BAThashsync(void *arg)
+{
+	BAT *b = arg;
+	lng t0 = 0;
+
+	ALGODEBUG t0 = GDKusec();
+
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->thash != NULL && b->thash != (Hash *) 1)
+		HASHpersist(&b->thash->heap, "BAThash", t0);
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	BBPunfix(b->batCacheid);
+}
+
+static void
+BATbhashsync(void *arg)
+{
+	BAT *b = arg;
+	lng t0 = 0;
+
+	ALGODEBUG t0 = GDKusec();
+
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tbhash != NULL && b->tbhash != (BHash *) 1)
+		HASHpersist(&b->tbhash->heap, "BATbhash", t0);
 	MT_lock_unset(&GDKhashLock(b->batCacheid));
 	BBPunfix(b->batCacheid);
 }
@@ -343,13 +367,240 @@ BAThashsync(void *arg)
 		}							\
 	} while (0)
 
+/*
+ * Parallel hash construction.
+ *
+ * The serial build inserts the positions in ascending order, so each
+ * bucket points at the last position with that hash value and each
+ * link points at the previous one.  We get the very same table with
+ * multiple threads by giving each thread its own range of buckets:
+ * first each thread counts, for its range of positions, how many
+ * values fall in each bucket range (partition), then it scatters its
+ * positions into one array ordered by partition (and, within a
+ * partition, by position), and finally each thread inserts the
+ * positions of its partitions in that order.  Since a thread is the
+ * only one to touch the buckets of its partitions and the links of
+ * the positions in them, no locking is needed.
+ */
+#define HASH_PAR_MIN	((BUN) 1 << 18) /* min nr of values per thread */
+
+struct hashpar {
+	BAT *b;
+	Hash *h;
+	int tpe;		/* base type of the values */
+	const void *vals;	/* fixed size values (position 0) */
+	BUN start;		/* BUN corresponding to position 0 */
+	BUN lo, hi;		/* positions counted/scattered by this thread */
+	int shift;		/* bucket >> shift is the partition */
+	int nparts;		/* number of partitions */
+	int nthreads;
+	int id;			/* this thread's partitions: id + k*nthreads */
+	int phase;		/* 0: count, 1: scatter, 2: insert */
+	BUN *cnts;		/* per partition counts/offsets into pos */
+	BUN *pos;		/* positions grouped by partition */
+	const BUN *bounds;	/* nparts+1 partition boundaries in pos */
+	BUN nslots;		/* number of buckets filled in phase 2 */
+	MT_Id tid;
+	bool started;
+};
+
+static inline BUN
+HASHparprobe(const struct hashpar *hp, BATiter *bi, BUN p)
+{
+	const Hash *h = hp->h;
+
+	switch (hp->tpe) {
+	case TYPE_bte:
+		return hash_bte(h, (const bte *) hp->vals + p);
+	case TYPE_sht:
+		return hash_sht(h, (const sht *) hp->vals + p);
+	case TYPE_int:
+		return hash_int(h, (const int *) hp->vals + p);
+	case TYPE_flt:
+		return hash_flt(h, (const flt *) hp->vals + p);
+	case TYPE_lng:
+		return hash_lng(h, (const lng *) hp->vals + p);
+	case TYPE_dbl:
+		return hash_dbl(h, (const dbl *) hp->vals + p);
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		return hash_hge(h, (const hge *) hp->vals + p);
+#endif
+	default:
+		return heap_hash_any(hp->b->tvheap, h, BUNtail(*bi, p + hp->start));
+	}
+}
+
+static void
+HASHparworker(void *arg)
+{
+	struct hashpar *hp = arg;
+	Hash *h = hp->h;
+	BATiter bi = bat_iterator(hp->b);
+	BUN *restrict cnts = hp->cnts;
+	BUN *restrict pos = hp->pos;
+	BUN p, c, i, hget, hnil = HASHnil(h);
+	int k;
+
+	switch (hp->phase) {
+	case 0:
+		for (p = hp->lo; p < hp->hi; p++)
+			cnts[HASHparprobe(hp, &bi, p) >> hp->shift]++;
+		break;
+	case 1:
+		for (p = hp->lo; p < hp->hi; p++)
+			pos[cnts[HASHparprobe(hp, &bi, p) >> hp->shift]++] = p;
+		break;
+	case 2:
+		for (k = hp->id; k < hp->nparts; k += hp->nthreads) {
+			for (i = hp->bounds[k]; i < hp->bounds[k + 1]; i++) {
+				p = pos[i];
+				c = HASHparprobe(hp, &bi, p);
+				hget = HASHget(h, c);
+				hp->nslots += hget == hnil;
+				HASHputlink(h, p, hget);
+				HASHput(h, c, p);
+			}
+		}
+		break;
+	}
+}
+
+/* run one phase on all threads, the calling thread being the first */
+static void
+HASHparrun(struct hashpar *hp, int nthreads, int phase)
+{
+	int i;
+
+	for (i = 0; i < nthreads; i++)
+		hp[i].phase = phase;
+	for (i = 1; i < nthreads; i++)
+		hp[i].started = MT_create_thread(&hp[i].tid, HASHparworker,
+						 &hp[i], MT_THR_JOINABLE) == 0;
+	HASHparworker(&hp[0]);
+	for (i = 1; i < nthreads; i++) {
+		if (hp[i].started)
+			MT_join_thread(hp[i].tid);
+		else
+			HASHparworker(&hp[i]); /* couldn't start thread */
+	}
+}
+
+/* Insert positions [from,to) into the hash h on b using nthreads
+ * threads.  Returns the number of newly occupied buckets, or BUN_NONE
+ * if we couldn't allocate the scratch space, in which case h has not
+ * been touched. */
+static BUN
+HASHbuildpar(BAT *b, Hash *h, BUN start, BUN from, BUN to, int nthreads)
+{
+	struct hashpar *hp;
+	BUN *cnts, *pos, *bounds;
+	BUN nslots = 0, sum;
+	BUN hashsize = h->mask + 1;
+	int nparts, bits, shift, i, k;
+
+	assert((hashsize & h->mask) == 0); /* power of two */
+	if (from == to)
+		return 0;
+	for (bits = 0; ((BUN) 1 << bits) < hashsize; bits++)
+		;
+	/* a few partitions per thread to balance the load */
+	for (nparts = 1, shift = bits;
+	     nparts < 4 * nthreads && shift > 0;
+	     nparts <<= 1, shift--)
+		;
+	hp = GDKzalloc(nthreads * sizeof(*hp));
+	cnts = GDKzalloc((size_t) nthreads * nparts * sizeof(BUN));
+	bounds = GDKmalloc((nparts + 1) * sizeof(BUN));
+	pos = GDKmalloc((to - from) * sizeof(BUN));
+	if (hp == NULL || cnts == NULL || bounds == NULL || pos == NULL) {
+		GDKfree(hp);
+		GDKfree(cnts);
+		GDKfree(bounds);
+		GDKfree(pos);
+		GDKclrerr();
+		return BUN_NONE;
+	}
+	for (i = 0; i < nthreads; i++) {
+		hp[i].b = b;
+		hp[i].h = h;
+		hp[i].tpe = ATOMbasetype(b->ttype);
+		hp[i].vals = b->ttype == TYPE_void ? NULL : Tloc(b, start);
+		hp[i].start = start;
+		hp[i].lo = from + (to - from) / nthreads * i;
+		hp[i].hi = i == nthreads - 1 ? to : from + (to - from) / nthreads * (i + 1);
+		hp[i].shift = shift;
+		hp[i].nparts = nparts;
+		hp[i].nthreads = nthreads;
+		hp[i].id = i;
+		hp[i].cnts = cnts + (size_t) i * nparts;
+		hp[i].pos = pos - from;
+		hp[i].bounds = bounds;
+	}
+	HASHparrun(hp, nthreads, 0);
+	/* turn the counts into offsets: partition by partition, and
+	 * within a partition thread by thread (i.e. position order) */
+	for (sum = from, k = 0; k < nparts; k++) {
+		bounds[k] = sum;
+		for (i = 0; i < nthreads; i++) {
+			BUN n = hp[i].cnts[k];
+			hp[i].cnts[k] = sum;
+			sum += n;
+		}
+	}
+	bounds[nparts] = sum;
+	assert(sum == to);
+	HASHparrun(hp, nthreads, 1);
+	HASHparrun(hp, nthreads, 2);
+	for (i = 0; i < nthreads; i++)
+		nslots += hp[i].nslots;
+	GDKfree(hp);
+	GDKfree(cnts);
+	GDKfree(bounds);
+	GDKfree(pos);
+	return nslots;
+}
+
+/* Find the position at which the serial starthash would give up,
+ * i.e. the first occurrence of the (maxslots+1)'th distinct bucket
+ * among positions [0,cnt1). */
+static BUN
+HASHtrialabort(BAT *b, Hash *h, BUN start, BUN cnt1, BUN maxslots)
+{
+	struct hashpar hp;
+	BATiter bi = bat_iterator(b);
+	ulng *seen;
+	BUN p, c, n = 0;
+
+	hp.b = b;
+	hp.h = h;
+	hp.tpe = ATOMbasetype(b->ttype);
+	hp.vals = b->ttype == TYPE_void ? NULL : Tloc(b, start);
+	hp.start = start;
+	if ((seen = GDKzalloc(((h->mask >> 6) + 1) * sizeof(ulng))) == NULL) {
+		GDKclrerr();
+		return 0;	/* pretend we gave up immediately */
+	}
+	for (p = 0; p < cnt1; p++) {
+		c = HASHparprobe(&hp, &bi, p);
+		if ((seen[c >> 6] & ((ulng) 1 << (c & 63))) == 0) {
+			if (n == maxslots)
+				break;
+			seen[c >> 6] |= (ulng) 1 << (c & 63);
+			n++;
+		}
+	}
+	GDKfree(seen);
+	return p;
+}
+
 /*
  * The prime routine for the BAT layer is to create a new hash index.
  * Its argument is the element type and the maximum number of BUNs be
  * stored under the hash function.
  */
-Hash *
-BAThash_impl(BAT *b, BAT *s, const char *ext)
+static Hash *
+BAThash_build(BAT *b, BAT *s, const char *ext, int nthreads)
 {
 	lng t0 = 0;
 	unsigned int tpe = ATOMbasetype(b->ttype);
@@ -357,8 +608,9 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 	const oid *cand, *candend;
 	BUN mask, maxmask = 0;
 	BUN p, c;
-	BUN nslots;
+	BUN nslots, n;
 	BUN hnil, hget;
+	bool parfilled;
 	Hash *h = NULL;
 	const char *nme = BBP_physical(b->batCacheid);
 	BATiter bi = bat_iterator(b);
@@ -379,6 +631,13 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 
 	CANDINIT(b, s, start, end, cnt, cand, candend);
 	cnt = cand ? (BUN) (candend - cand) : end - start;
+	/* only go parallel if each thread gets enough work */
+	if (cand || nthreads <= 1)
+		nthreads = 1;
+	else if (cnt / HASH_PAR_MIN < (BUN) nthreads)
+		nthreads = (int) (cnt / HASH_PAR_MIN);
+	if (nthreads < 1)
+		nthreads = 1;
 
 	if ((h = GDKzalloc(sizeof(*h))) == NULL ||
 	    (h->heap.farmid = BBPselectfarm(b->batRole, b->ttype, hashheap)) < 0) {
@@ -420,6 +679,7 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 
 		nslots = 0;
 		p = 0;
+		parfilled = false;
 		HEAPfree(&h->heap, true);
 		/* create the hash structures */
 		if (HASHnew(h, ATOMtype(b->ttype), s ? cnt : BATcapacity(b),
@@ -431,7 +691,15 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 
 		hnil = HASHnil(h);
 
-		switch (tpe) {
+		if (nthreads > 1 && cnt1 > 0 &&
+		    (n = HASHbuildpar(b, h, start, 0, cnt1, nthreads)) != BUN_NONE) {
+			/* we filled all of the first cnt1 positions,
+			 * find out where the serial version would have
+			 * given up, if at all */
+			nslots = n;
+			parfilled = true;
+			p = nslots > maxslots ? HASHtrialabort(b, h, start, cnt1, maxslots) : cnt1;
+		} else switch (tpe) {
 		case TYPE_bte:
 			starthash(bte);
 			break;
@@ -499,7 +767,12 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 	}
 
 	/* finish the hashtable with the current mask */
-	switch (tpe) {
+	if (parfilled)
+		p = cnt1;
+	if (nthreads > 1 &&
+	    (n = HASHbuildpar(b, h, start, p, cnt, nthreads)) != BUN_NONE) {
+		nslots += n;
+	} else switch (tpe) {
 	case TYPE_bte:
 		finishhash(bte);
 		break;
@@ -558,14 +831,22 @@ BAThash_impl(BAT *b, BAT *s, const char *ext)
 		b->batDirtydesc = true;
 	}
 	ALGODEBUG {
-		fprintf(stderr, "#BAThash: hash construction " LLFMT " usec\n", GDKusec() - t0);
+		fprintf(stderr, "#BAThash: hash construction with %d thread%s " LLFMT " usec\n", nthreads, nthreads == 1 ? "" : "s", GDKusec() - t0);
 		HASHcollisions(b, h);
 	}
 	return h;
 }
 
+Hash *
+BAThash_impl(BAT *b, BAT *s, const char *ext)
+{
+	return BAThash_build(b, s, ext, GDKnr_threads);
+}
+
+/* create a hash on b if there isn't one yet, using at most nthreads
+ * threads */
 gdk_return
-BAThash(BAT *b)
+BAThashbuild(BAT *b, int nthreads)
 {
 	assert(b->batCacheid > 0);
 	if (BATcheckhash(b)) {
@@ -573,7 +854,7 @@ BAThash(BAT *b)
 	}
 	MT_lock_set(&GDKhashLock(b->batCacheid));
 	if (b->thash == NULL) {
-		if ((b->thash = BAThash_impl(b, NULL, "thash")) == NULL) {
+		if ((b->thash = BAThash_build(b, NULL, "thash", nthreads)) == NULL) {
 			MT_lock_unset(&GDKhashLock(b->batCacheid));
 			return GDK_FAIL;
 		}
@@ -594,6 +875,12 @@ BAThash(BAT *b)
 	return GDK_SUCCEED;
 }
 
+gdk_return
+BAThash(BAT *b)
+{
+	return BAThashbuild(b, GDKnr_threads);
+}
+
 /*
  * The entry on which a value hashes can be calculated with the
  * routine HASHprobe.
@@ -708,3 +995,300 @@ HASHgonebad(BAT *b, const void *v)
 	}
 	return false;		/* a-ok */
 }
+
+/*
+ * - Bucketized Hash Table
+ * The bucketized hash table is an open addressing table of 64 bit
+ * slots, see gdk_hash.h for the layout.  It is stored in its own heap
+ * (extension tbhash) with a header of BHASH_HEADER_SIZE size_t values
+ * in front of the slots: version, number of slots, number of position
+ * bits, and the number of BUNs covered.  Like the chained hash, it is
+ * persisted by a separate thread once created for an unchanged
+ * persistent BAT, and b->tbhash can be NULL, (BHash *) 1, or a valid
+ * pointer.
+ */
+
+#define BHASH_VERSION		1
+#define BHASH_HEADER_SIZE	8 /* nr of size_t fields in header */
+
+/* the finalizer of MurmurHash3: all bits of the input affect all
+ * bits of the output, so both the home slot (low bits) and the tag
+ * (high bits) are well distributed */
+static inline ulng
+BHASHmix(ulng x)
+{
+	x ^= x >> 33;
+	x *= UINT64_C(0xff51afd7ed558ccd);
+	x ^= x >> 33;
+	x *= UINT64_C(0xc4ceb9fe1a85ec53);
+	x ^= x >> 33;
+	return x;
+}
+
+#define bhash_bte(v)	BHASHmix((ulng) *(const unsigned char *) (v))
+#define bhash_sht(v)	BHASHmix((ulng) *(const unsigned short *) (v))
+#define bhash_int(v)	BHASHmix((ulng) *(const unsigned int *) (v))
+#define bhash_lng(v)	BHASHmix(*(const ulng *) (v))
+#ifdef HAVE_HGE
+#define bhash_hge(v)	BHASHmix(((const ulng *) (v))[0] ^		\
+				 BHASHmix(((const ulng *) (v))[1]))
+#endif
+#define bhash_flt(v)	bhash_int(v)
+#define bhash_dbl(v)	bhash_lng(v)
+
+ulng
+BHASHprobe(const BHash *h, const void *v)
+{
+	switch (ATOMbasetype(h->type)) {
+	case TYPE_bte:
+		return bhash_bte(v);
+	case TYPE_sht:
+		return bhash_sht(v);
+	case TYPE_int:
+	case TYPE_flt:
+		return bhash_int(v);
+	case TYPE_lng:
+	case TYPE_dbl:
+		return bhash_lng(v);
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		return bhash_hge(v);
+#endif
+	default:
+		return BHASHmix((ulng) ATOMhash(h->type, v));
+	}
+}
+
+static void
+BHASHinit(BHash *h)
+{
+	size_t *hdr = (size_t *) h->heap.base;
+
+	h->mask = (BUN) (hdr[1] - 1);
+	h->posbits = (int) hdr[2];
+	h->Slot = (ulng *) (h->heap.base + BHASH_HEADER_SIZE * SIZEOF_SIZE_T);
+}
+
+/* Return whether we have a bucketized hash on b, loading a persisted
+ * one from disk if needed (see BATcheckhash). */
+bool
+BATcheckbhash(BAT *b)
+{
+	bool ret;
+
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tbhash == (BHash *) 1) {
+		BHash *h;
+		const char *nme = BBP_physical(b->batCacheid);
+		int fd;
+
+		b->tbhash = NULL;
+		if ((h = GDKzalloc(sizeof(*h))) != NULL &&
+		    (h->heap.farmid = BBPselectfarm(b->batRole, b->ttype, hashheap)) >= 0) {
+			snprintf(h->heap.filename, sizeof(h->heap.filename),
+				 "%s.tbhash", nme);
+
+			/* check whether a persisted hash can be found */
+			if ((fd = GDKfdlocate(h->heap.farmid, nme, "rb+", "tbhash")) >= 0) {
+				size_t hdata[BHASH_HEADER_SIZE];
+				struct stat st;
+
+				if (read(fd, hdata, sizeof(hdata)) == sizeof(hdata) &&
+				    hdata[0] == (
+#ifdef PERSISTENTHASH
+					    ((size_t) 1 << 24) |
+#endif
+					    BHASH_VERSION) &&
+				    hdata[3] == (size_t) BATcount(b) &&
+				    fstat(fd, &st) == 0 &&
+				    st.st_size >= (off_t) (h->heap.size = h->heap.free = hdata[1] * sizeof(ulng) + BHASH_HEADER_SIZE * SIZEOF_SIZE_T) &&
+				    HEAPload(&h->heap, nme, "tbhash", false) == GDK_SUCCEED) {
+					close(fd);
+					h->type = ATOMtype(b->ttype);
+					BHASHinit(h);
+					h->heap.parentid = b->batCacheid;
+					h->heap.dirty = FALSE;
+					b->tbhash = h;
+					ALGODEBUG fprintf(stderr, "#BATcheckbhash: reusing persisted hash %s\n", BATgetId(b));
+					MT_lock_unset(&GDKhashLock(b->batCacheid));
+					return true;
+				}
+				close(fd);
+				/* unlink unusable file */
+				GDKunlink(h->heap.farmid, BATDIR, nme, "tbhash");
+			}
+		}
+		GDKfree(h);
+		GDKclrerr();	/* we're not currently interested in errors */
+	}
+	ret = b->tbhash != NULL;
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return ret;
+}
+
+#define bhashinsert(TYPE)						\
+	do {								\
+		const TYPE *restrict v = (const TYPE *) Tloc(b, 0);	\
+		for (p = 0; p < cnt; p++) {				\
+			x = bhash_##TYPE(v + p);			\
+			for (i = BHASHhome(h, x); slot[i]; i = (i + 1) & h->mask) \
+				;					\
+			slot[i] = (x & ~posmask) | (ulng) (p + 1);	\
+		}							\
+	} while (0)
+
+static BHash *
+BATbhash_impl(BAT *b)
+{
+	lng t0 = 0;
+	BHash *h;
+	BUN cnt = BATcount(b), nslots, p;
+	ulng x, i, posmask, *restrict slot;
+	size_t *hdr;
+	int posbits;
+	BATiter bi = bat_iterator(b);
+
+	ALGODEBUG t0 = GDKusec();
+	ALGODEBUG fprintf(stderr, "#BATbhash: create bucketized hash(" ALGOBATFMT ");\n",
+			  ALGOBATPAR(b));
+
+	/* keep the table at most half full, so that there is always
+	 * an empty slot to terminate a probe sequence */
+	for (nslots = 2 * BHASH_BUCKET; nslots < 2 * cnt; nslots <<= 1)
+		;
+	/* positions are stored plus one, zero means empty */
+	for (posbits = 1; ((BUN) 1 << posbits) <= cnt; posbits++)
+		;
+
+	if ((h = GDKzalloc(sizeof(*h))) == NULL ||
+	    (h->heap.farmid = BBPselectfarm(b->batRole, b->ttype, hashheap)) < 0) {
+		GDKfree(h);
+		return NULL;
+	}
+	h->heap.dirty = TRUE;
+	snprintf(h->heap.filename, sizeof(h->heap.filename), "%s.tbhash",
+		 BBP_physical(b->batCacheid));
+	if (HEAPalloc(&h->heap, nslots + BHASH_HEADER_SIZE * SIZEOF_SIZE_T / sizeof(ulng), sizeof(ulng)) != GDK_SUCCEED) {
+		GDKfree(h);
+		return NULL;
+	}
+	h->heap.free = nslots * sizeof(ulng) + BHASH_HEADER_SIZE * SIZEOF_SIZE_T;
+	hdr = (size_t *) h->heap.base;
+	memset(hdr, 0, h->heap.free);
+	hdr[0] = BHASH_VERSION;
+	hdr[1] = nslots;
+	hdr[2] = (size_t) posbits;
+	hdr[3] = cnt;
+	h->type = ATOMtype(b->ttype);
+	BHASHinit(h);
+	slot = h->Slot;
+	posmask = BHASHposmask(h);
+
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_bte:
+		bhashinsert(bte);
+		break;
+	case TYPE_sht:
+		bhashinsert(sht);
+		break;
+	case TYPE_int:
+		bhashinsert(int);
+		break;
+	case TYPE_flt:
+		bhashinsert(flt);
+		break;
+	case TYPE_lng:
+		bhashinsert(lng);
+		break;
+	case TYPE_dbl:
+		bhashinsert(dbl);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		bhashinsert(hge);
+		break;
+#endif
+	default:
+		for (p = 0; p < cnt; p++) {
+			x = BHASHprobe(h, BUNtail(bi, p));
+			for (i = BHASHhome(h, x); slot[i]; i = (i + 1) & h->mask)
+				;
+			slot[i] = (x & ~posmask) | (ulng) (p + 1);
+		}
+		break;
+	}
+	ALGODEBUG fprintf(stderr, "#BATbhash: hash construction (" BUNFMT " slots) " LLFMT " usec\n", nslots, GDKusec() - t0);
+	return h;
+}
+
+gdk_return
+BATbhash(BAT *b)
+{
+	assert(b->batCacheid > 0);
+	if (BATtvoid(b)) {
+		GDKerror("BATbhash: no bucketized hash on void column\n");
+		return GDK_FAIL;
+	}
+	if (BATcheckbhash(b))
+		return GDK_SUCCEED;
+	MT_lock_set(&GDKhashLock(b->batCacheid));
+	if (b->tbhash == NULL) {
+		if ((b->tbhash = BATbhash_impl(b)) == NULL) {
+			MT_lock_unset(&GDKhashLock(b->batCacheid));
+			return GDK_FAIL;
+		}
+#ifdef PERSISTENTHASH
+		if (BBP_status(b->batCacheid) & BBPEXISTING && !b->theap.dirty) {
+			MT_Id tid;
+			BBPfix(b->batCacheid);
+			if (MT_create_thread(&tid, BATbhashsync, b,
+					     MT_THR_DETACHED) < 0) {
+				/* couldn't start thread: clean up */
+				BBPunfix(b->batCacheid);
+			}
+		} else
+			ALGODEBUG fprintf(stderr, "#BATbhash: NOT persisting hash %d\n", b->batCacheid);
+#endif
+	}
+	MT_lock_unset(&GDKhashLock(b->batCacheid));
+	return GDK_SUCCEED;
+}
+
+void
+BHASHdestroy(BAT *b)
+{
+	if (b) {
+		BHash *hs;
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		hs = b->tbhash;
+		b->tbhash = NULL;
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		if (hs == (BHash *) 1) {
+			GDKunlink(BBPselectfarm(b->batRole, b->ttype, hashheap),
+				  BATDIR,
+				  BBP_physical(b->batCacheid),
+				  "tbhash");
+		} else if (hs) {
+			ALGODEBUG if (*(size_t *) hs->heap.base & (1 << 24))
+				fprintf(stderr, "#BHASHdestroy: removing persisted hash %d\n", b->batCacheid);
+			HEAPfree(&hs->heap, true);
+			GDKfree(hs);
+		}
+	}
+}
+
+void
+BHASHfree(BAT *b)
+{
+	if (b) {
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		if (b->tbhash && b->tbhash != (BHash *) 1) {
+			bool dirty = b->tbhash->heap.dirty;
+
+			HEAPfree(&b->tbhash->heap, dirty);
+			GDKfree(b->tbhash);
+			b->tbhash = dirty ? NULL : (BHash *) 1;
+		}
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+	}
+}
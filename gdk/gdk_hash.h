@@ -21,6 +21,8 @@
 gdk_export void HASHdestroy(BAT *b);
 gdk_export BUN HASHprobe(const Hash *h, const void *v);
 gdk_export BUN HASHlist(Hash *h, BUN i);
+gdk_export void BHASHdestroy(BAT *b);
+gdk_export ulng BHASHprobe(const BHash *h, const void *v);
 
 
 #define HASHnil(H)	(H)->nil
@@ -249,4 +251,36 @@ gdk_export BUN HASHlist(Hash *h, BUN i);
 		}							\
 	} while (0)
 
+/*
+ * @+ Bucketized hash indexing
+ *
+ * The bucketized hash is an open addressing alternative to the
+ * chained hash above.  Each slot is a 64 bit word that holds the BUN
+ * position (plus one, so that zero means empty) in its low posbits
+ * bits, and the corresponding high bits of the 64 bit hash value of
+ * the stored value as a tag.  A value's home is the first slot of the
+ * group of BHASH_BUCKET slots (one cache line) selected by the low
+ * bits of its hash, and from there we probe linearly until we hit an
+ * empty slot.  The table is at most half full, so probe sequences are
+ * short and, thanks to the tag, we hardly ever need to look at the
+ * column itself for a non-matching value.  Since the table is filled
+ * in BUN order, matches are produced in ascending BUN order.
+ */
+#define BHASH_BUCKET		8 /* slots per bucket (64 byte cache line) */
+#define BHASHposmask(h)		(((ulng) 1 << (h)->posbits) - 1)
+#define BHASHhome(h, x)		((x) & (h)->mask & ~(ulng) (BHASH_BUCKET - 1))
+
+/* loop over all BUNs hb in [lo,hi) whose value matches v; the caller
+ * needs a cmp variable like for HASHloop_bound */
+#define BHASHloop_bound(bi, h, hb, v, lo, hi)				\
+	for (ulng _bx = BHASHprobe((h), (v)), _bs,			\
+		     _bi = BHASHhome(h, _bx);				\
+	     (_bs = (h)->Slot[_bi]) != 0;				\
+	     _bi = (_bi + 1) & (h)->mask)				\
+		if (((_bs ^ _bx) & ~BHASHposmask(h)) == 0 &&		\
+		    ((hb) = (BUN) (_bs & BHASHposmask(h)) - 1) >= (lo) && \
+		    (hb) < (hi) &&					\
+		    (cmp == NULL ||					\
+		     (*cmp)((v), BUNtail(bi, (hb))) == 0))
+
 #endif /* _GDK_SEARCH_H_ */
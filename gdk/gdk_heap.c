@@ -557,6 +557,8 @@ HEAPcopy(Heap *dst, Heap *src)
 		dst->hashash = src->hashash;
 		dst->cleanhash = src->cleanhash;
 		dst->dirty = true;
+		if (STRDICTcopy(dst, src) != GDK_SUCCEED)
+			GDKclrerr();	/* the copy can do without */
 		return GDK_SUCCEED;
 	}
 	return GDK_FAIL;
@@ -567,6 +569,7 @@ HEAPcopy(Heap *dst, Heap *src)
 void
 HEAPfree(Heap *h, bool rmheap)
 {
+	STRDICTfree(h);
 	if (h->base) {
 		if (h->storage == STORE_MEM) {	/* plain memory */
 			HEAPDEBUG fprintf(stderr, "#HEAPfree %zu"
@@ -367,6 +367,7 @@ GDKbatread(char *src, BAT **bat, str *colname)
 		position += align(sizeof(Heap));
 		//[VHEAPDATA]
 		b->tvheap->base = (void *) (src + position);
+		b->tvheap->dict = NULL;
 		position += align(b->tvheap->size);
 	}
 	*bat = b;
@@ -99,6 +99,10 @@ joinparamcheck(BAT *l, BAT *r1, BAT *r2, BAT *sl, BAT *sr, const char *func)
 		GDKerror("%s: candidate lists must be unique.\n", func);
 		return GDK_FAIL;
 	}
+	/* the join algorithms need the candidates as oids */
+	if (BATcandmaterialize(sl) != GDK_SUCCEED ||
+	    BATcandmaterialize(sr) != GDK_SUCCEED)
+		return GDK_FAIL;
 	return GDK_SUCCEED;
 }
 
@@ -2486,6 +2490,15 @@ binsearchcand(const oid *cand, BUN lo, BUN hi, oid v)
 		    (cmp == NULL ||			\
 		     (*cmp)(v, BUNtail(bi, hb)) == 0))
 
+/* string version for when l and r share a string heap that contains
+ * each string only once: compare the offsets instead of the strings */
+#define HASHloop_bound_strelim(h, hb, v, lo, hi)			\
+	for (hb = HASHget(h, HASHprobe((h), v));			\
+	     hb != HASHnil(h);						\
+	     hb = HASHgetlink(h,hb))					\
+		if (hb >= (lo) && hb < (hi) &&				\
+		    VarHeapVal(rvals, hb, rwidth) == (size_t) ((v) - lvars))
+
 #define HASHloop_bound_TYPE(bi, h, hb, v, lo, hi, TYPE)			\
 	for (hb = HASHget(h, hash_##TYPE(h, v));			\
 	     hb != HASHnil(h);						\
@@ -2551,8 +2564,12 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 	oid lval = oid_nil;	/* hold value if l is dense */
 	const char *v = (const char *) &lval;
 	bool lskipped = false;	/* whether we skipped values in l */
-	Hash *restrict hsh;
+	Hash *restrict hsh = NULL;
+	BHash *restrict bhsh = NULL; /* use bucketized hash if set */
 	int t;
+	bool strelim = false;	/* compare string offsets */
+	const char *rvals = NULL;
+	int rwidth = 0;
 
 	ALGODEBUG fprintf(stderr, "#hashjoin(l=" ALGOBATFMT ","
 			  "r=" ALGOBATFMT ",sl=" ALGOOPTBATFMT ","
@@ -2619,7 +2636,14 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 	rseq += rstart;
 
 	if (sr) {
-		if (BATtdense(sr) &&
+		if (BATtdense(sr) && BATcheckbhash(r)) {
+			ALGODEBUG fprintf(stderr, "#hashjoin(%s): using "
+					  "existing bucketized hash with "
+					  "candidate list\n",
+					  BATgetId(r));
+			bhsh = r->tbhash;
+			sr = NULL;
+		} else if (BATtdense(sr) &&
 		    BATcheckhash(r) &&
 		    BATcount(r) / ((size_t *) r->thash->heap.base)[5] * lcnt < lcnt + rcnt) {
 			ALGODEBUG fprintf(stderr, "#hashjoin(%s): using "
@@ -2637,14 +2661,31 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 			if ((hsh = BAThash_impl(r, sr, ext)) == NULL)
 				goto bailout;
 		}
+	} else if (BATcheckbhash(r)) {
+		ALGODEBUG fprintf(stderr, "#hashjoin(%s): using "
+				  "bucketized hash\n", BATgetId(r));
+		bhsh = r->tbhash;
 	} else {
 		if (BAThash(r) != GDK_SUCCEED)
 			goto bailout;
 		hsh = r->thash;
 	}
+	/* r is probed in random order */
+	BATadvise(r, MMAP_WILLNEED);
 	ri = bat_iterator(r);
 	sri = bat_iterator(sr);
 	t = ATOMbasetype(r->ttype);
+	if (t == TYPE_str && lvars != NULL && sr == NULL && bhsh == NULL &&
+	    l->tvheap == r->tvheap && GDK_ELIMALL(l->tvheap)) {
+		/* both sides use the same string heap which contains
+		 * each string only once, so strings are equal if and
+		 * only if their offsets are */
+		ALGODEBUG fprintf(stderr, "#hashjoin(%s): comparing "
+				  "string offsets\n", BATgetId(l));
+		strelim = true;
+		rvals = (const char *) Tloc(r, 0);
+		rwidth = r->twidth;
+	}
 
 	if (lcand) {
 		while (lcand < lcandend) {
@@ -2673,6 +2714,28 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 					if (semi)
 						break;
 				}
+			} else if (bhsh) {
+				BHASHloop_bound(ri, bhsh, rb, v, rl, rh) {
+					ro = (oid) (rb - rl + rseq);
+					if (only_misses) {
+						nr++;
+						break;
+					}
+					HASHLOOPBODY();
+					if (semi)
+						break;
+				}
+			} else if (strelim) {
+				HASHloop_bound_strelim(hsh, rb, v, rl, rh) {
+					ro = (oid) (rb - rl + rseq);
+					if (only_misses) {
+						nr++;
+						break;
+					}
+					HASHLOOPBODY();
+					if (semi)
+						break;
+				}
 			} else {
 				HASHloop_bound(ri, hsh, rb, v, rl, rh) {
 					ro = (oid) (rb - rl + rseq);
@@ -2740,7 +2803,7 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 				r1->trevsorted = false;
 		}
 	} else if (rcand == NULL && lvars == NULL && sr == NULL &&
-		   !nil_matches && !nil_on_miss && !semi && !only_misses &&
+		   bhsh == NULL && !nil_matches && !nil_on_miss && !semi && !only_misses &&
 		   !BATtvoid(l) && (t == TYPE_int || t == TYPE_lng)) {
 		/* special case for a common way of calling this
 		 * function */
@@ -2805,6 +2868,19 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 							break;
 					}
 				}
+			} else if (bhsh) {
+				if (nil_matches || cmp(v, nil) != 0) {
+					BHASHloop_bound(ri, bhsh, rb, v, rl, rh) {
+						ro = (oid) (rb - rl + rseq);
+						if (only_misses) {
+							nr++;
+							break;
+						}
+						HASHLOOPBODY();
+						if (semi)
+							break;
+					}
+				}
 			} else {
 				switch (t) {
 				case TYPE_int:
@@ -2851,6 +2927,23 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 					}
 					break;
 #endif
+				case TYPE_str:
+					if (strelim) {
+						if (nil_matches || cmp(v, nil) != 0) {
+							HASHloop_bound_strelim(hsh, rb, v, rl, rh) {
+								ro = (oid) (rb - rl + rseq);
+								if (only_misses) {
+									nr++;
+									break;
+								}
+								HASHLOOPBODY();
+								if (semi)
+									break;
+							}
+						}
+						break;
+					}
+					/* fall through */
 				default:
 					if (nil_matches || cmp(v, nil) != 0) {
 						HASHloop_bound(ri, hsh, rb, v, rl, rh) {
@@ -2972,6 +3065,337 @@ hashjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches,
 	return GDK_FAIL;
 }
 
+/* Radix-partitioned hash join.
+ *
+ * If the inner (right) input of an equi-join is large, the hash table
+ * that hashjoin builds over it does not fit in the CPU caches, and
+ * just about every probe results in one or more cache misses.  In
+ * that case it pays to first partition both inputs on a few bits of
+ * a hash of the join value so that each partition of the inner input
+ * (values, oids and a small hash table) fits in the cache, and then
+ * to build and probe a small hash table per partition.
+ *
+ * The partitioning is done in a single pass (after a histogram pass)
+ * with a fan-out of at most 1 << RADIX_MAX_BITS so that the scatter
+ * does not thrash the TLB.  Only fixed-size integer types of at least
+ * four bytes are supported (this includes oid, date, timestamp,
+ * etc.); for smaller types the domain is too small to warrant this.
+ *
+ * If ordered is set, the result is sorted on the left output
+ * afterwards so that it can be used as a replacement for the
+ * hashjoin that leftjoin would otherwise use.
+ *
+ * Whether this algorithm is used is controlled with the gdk_radixjoin
+ * option: "no" never, "yes" whenever the types allow, and "auto" (the
+ * default) when the hash table on the inner input would not fit in
+ * the cache anyway. */
+
+#define RADIX_CACHE_SIZE	((size_t) 1 << 18) /* target partition footprint */
+#define RADIX_MIN_INNER		((size_t) 1 << 22) /* auto: min hash table size */
+#define RADIX_MAX_BITS		12 /* max fan-out of the partitioning pass */
+
+#define RADIX_HASH_int(v)	((ulng) (unsigned int) (v) * UINT64_C(0x9E3779B97F4A7C15))
+#define RADIX_HASH_lng(v)	((ulng) (v) * UINT64_C(0x9E3779B97F4A7C15))
+#ifdef HAVE_HGE
+#define RADIX_HASH_hge(v)	RADIX_HASH_lng((ulng) (v) ^ (ulng) ((uhge) (v) >> 64))
+#endif
+
+/* partition number: the top bits of the hash */
+#define RADIX_PART(h)		((BUN) ((h) >> (64 - bits)))
+/* bucket within a partition: the bits just below the partition bits */
+#define RADIX_BUCKET(h)		((BUN) ((h) >> (64 - bits - hbits)) & hmask)
+
+/* Partition the values of b (subject to the candidate list) into the
+ * newly allocated arrays vals and oids, and fill in hist so that
+ * partition p occupies positions hist[p] up to hist[p+1]. */
+#define RADIXPARTITION(TYPE, b, start, end, cand, candend, vals, oids, hist) \
+	do {								\
+		const TYPE *restrict src = (const TYPE *) Tloc(b, 0);	\
+		TYPE *restrict dst;					\
+		const oid *c;						\
+		BUN j;							\
+		TYPE v;							\
+									\
+		memset(hist, 0, (nparts + 1) * sizeof(BUN));		\
+		if (cand) {						\
+			for (c = cand; c < candend; c++) {		\
+				v = src[*c - b->hseqbase];		\
+				if (nil_matches || !is_##TYPE##_nil(v))	\
+					hist[RADIX_PART(RADIX_HASH_##TYPE(v)) + 1]++; \
+			}						\
+		} else {						\
+			for (j = start; j < end; j++) {			\
+				v = src[j];				\
+				if (nil_matches || !is_##TYPE##_nil(v))	\
+					hist[RADIX_PART(RADIX_HASH_##TYPE(v)) + 1]++; \
+			}						\
+		}							\
+		for (p = 0; p < nparts; p++)				\
+			hist[p + 1] += hist[p];				\
+		vals = GDKmalloc(MAX(hist[nparts], 1) * sizeof(TYPE));	\
+		oids = GDKmalloc(MAX(hist[nparts], 1) * sizeof(oid));	\
+		if (vals == NULL || oids == NULL)			\
+			goto bailout;					\
+		dst = vals;						\
+		memcpy(cur, hist, nparts * sizeof(BUN));		\
+		if (cand) {						\
+			for (c = cand; c < candend; c++) {		\
+				v = src[*c - b->hseqbase];		\
+				if (nil_matches || !is_##TYPE##_nil(v)) { \
+					p = RADIX_PART(RADIX_HASH_##TYPE(v)); \
+					dst[cur[p]] = v;		\
+					oids[cur[p]++] = *c;		\
+				}					\
+			}						\
+		} else {						\
+			for (j = start; j < end; j++) {			\
+				v = src[j];				\
+				if (nil_matches || !is_##TYPE##_nil(v)) { \
+					p = RADIX_PART(RADIX_HASH_##TYPE(v)); \
+					dst[cur[p]] = v;		\
+					oids[cur[p]++] = b->hseqbase + j; \
+				}					\
+			}						\
+		}							\
+	} while (false)
+
+#define RADIXJOIN(TYPE)							\
+	do {								\
+		const TYPE *restrict lv, *restrict rv;			\
+		BUN rb, re, lb, le, i, j, n;				\
+		TYPE v;							\
+									\
+		RADIXPARTITION(TYPE, r, rstart, rend, rcand, rcandend,	\
+			       rvals, roids, rhist);			\
+		RADIXPARTITION(TYPE, l, lstart, lend, lcand, lcandend,	\
+			       lvals, loids, lhist);			\
+		rv = rvals;						\
+		lv = lvals;						\
+		/* size the hash table for the largest partition */	\
+		n = 0;							\
+		for (p = 0; p < nparts; p++)				\
+			if (rhist[p + 1] - rhist[p] > n)		\
+				n = rhist[p + 1] - rhist[p];		\
+		for (hbits = 0; ((BUN) 1 << hbits) < n; hbits++)	\
+			;						\
+		if (bits + hbits > 64)					\
+			hbits = 64 - bits;				\
+		bkt = GDKmalloc(((size_t) 1 << hbits) * sizeof(BUN));	\
+		nxt = GDKmalloc(MAX(n, 1) * sizeof(BUN));		\
+		if (bkt == NULL || nxt == NULL)				\
+			goto bailout;					\
+		for (p = 0; p < nparts; p++) {				\
+			rb = rhist[p];					\
+			re = rhist[p + 1];				\
+			lb = lhist[p];					\
+			le = lhist[p + 1];				\
+			if (rb == re || lb == le)			\
+				continue;				\
+			for (hbits = 0; ((BUN) 1 << hbits) < re - rb; hbits++) \
+				;					\
+			if (bits + hbits > 64)				\
+				hbits = 64 - bits;			\
+			hmask = ((BUN) 1 << hbits) - 1;			\
+			for (i = 0; i <= hmask; i++)			\
+				bkt[i] = BUN_NONE;			\
+			/* insert in reverse: chains in position order */ \
+			for (i = re; i > rb; ) {			\
+				i--;					\
+				j = RADIX_BUCKET(RADIX_HASH_##TYPE(rv[i])); \
+				nxt[i - rb] = bkt[j];			\
+				bkt[j] = i;				\
+			}						\
+			for (i = lb; i < le; i++) {			\
+				v = lv[i];				\
+				lo = loids[i];				\
+				nr = 0;					\
+				for (j = bkt[RADIX_BUCKET(RADIX_HASH_##TYPE(v))]; \
+				     j != BUN_NONE;			\
+				     j = nxt[j - rb]) {			\
+					if (rv[j] == v) {		\
+						ro = roids[j];		\
+						HASHLOOPBODY();		\
+					}				\
+				}					\
+				if (nr > 1)				\
+					r1->tkey = false;		\
+			}						\
+		}							\
+	} while (false)
+
+static bool
+radixjoin_possible(BAT *l, BAT *r)
+{
+	if (GDK_radixjoin == 0 ||
+	    BATtvoid(l) || BATtvoid(r) ||
+	    l->tvarsized || r->tvarsized)
+		return false;
+	switch (ATOMbasetype(l->ttype)) {
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Decide whether to use a radix-partitioned join given that r (with
+ * rcount relevant values) would be the inner input and no usable
+ * hash table exists on it. */
+static bool
+radixjoin_wanted(BAT *l, BAT *r, BUN rcount)
+{
+	if (!radixjoin_possible(l, r))
+		return false;
+	if (GDK_radixjoin == 2)
+		return true;
+	/* the size of the hash table (values, bucket and link
+	 * arrays) that hashjoin would build */
+	return (size_t) rcount * (Tsize(r) + 2 * sizeof(BUN)) >= RADIX_MIN_INNER;
+}
+
+static gdk_return
+radixjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
+	  bool nil_matches, bool ordered, BUN maxsize, lng t0,
+	  bool swapped, const char *reason)
+{
+	BUN lstart, lend, lcnt;
+	const oid *lcand = NULL, *lcandend = NULL;
+	BUN rstart, rend, rcnt;
+	const oid *rcand = NULL, *rcandend = NULL;
+	void *lvals = NULL, *rvals = NULL;
+	oid *loids = NULL, *roids = NULL;
+	BUN *lhist = NULL, *rhist = NULL, *cur = NULL;
+	BUN *bkt = NULL, *nxt = NULL;
+	BUN nparts, p, hmask, nr, newcap;
+	int bits, hbits;
+	oid lo, ro;
+
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=" ALGOBATFMT ","
+			  "r=" ALGOBATFMT ",sl=" ALGOOPTBATFMT ","
+			  "sr=" ALGOOPTBATFMT ",nil_matches=%d,"
+			  "ordered=%d)%s%s%s\n",
+			  ALGOBATPAR(l), ALGOBATPAR(r),
+			  ALGOOPTBATPAR(sl), ALGOOPTBATPAR(sr),
+			  nil_matches, ordered,
+			  swapped ? " swapped" : "",
+			  *reason ? " " : "", reason);
+
+	assert(radixjoin_possible(l, r));
+	assert(ATOMtype(l->ttype) == ATOMtype(r->ttype));
+	assert(sl == NULL || sl->tsorted);
+	assert(sr == NULL || sr->tsorted);
+
+	CANDINIT(l, sl, lstart, lend, lcnt, lcand, lcandend);
+	CANDINIT(r, sr, rstart, rend, rcnt, rcand, rcandend);
+	lcnt = lcand ? (BUN) (lcandend - lcand) : lend - lstart;
+	rcnt = rcand ? (BUN) (rcandend - rcand) : rend - rstart;
+
+	if (lcnt == 0 || rcnt == 0)
+		return nomatch(r1, r2, l, r, lstart, lend, lcand, lcandend,
+			       false, false, "radixjoin", t0);
+
+	/* choose the number of partitions such that a partition of
+	 * the inner input fits in the cache */
+	for (bits = 1; bits < RADIX_MAX_BITS; bits++)
+		if (((size_t) rcnt >> bits) * (Tsize(r) + sizeof(oid) + 2 * sizeof(BUN)) <= RADIX_CACHE_SIZE)
+			break;
+	nparts = (BUN) 1 << bits;
+	hbits = 0;
+	hmask = 0;
+
+	lhist = GDKmalloc((nparts + 1) * sizeof(BUN));
+	rhist = GDKmalloc((nparts + 1) * sizeof(BUN));
+	cur = GDKmalloc(nparts * sizeof(BUN));
+	if (lhist == NULL || rhist == NULL || cur == NULL)
+		goto bailout;
+
+	r1->tkey = true;
+	r1->tsorted = false;
+	r1->trevsorted = false;
+	r1->tseqbase = oid_nil;
+	if (r2) {
+		r2->tkey = l->tkey;
+		r2->tsorted = false;
+		r2->trevsorted = false;
+		r2->tseqbase = oid_nil;
+	}
+
+	switch (ATOMbasetype(l->ttype)) {
+	case TYPE_int:
+		RADIXJOIN(int);
+		break;
+	case TYPE_lng:
+		RADIXJOIN(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		RADIXJOIN(hge);
+		break;
+#endif
+	default:
+		assert(0);
+	}
+	GDKfree(lhist);
+	GDKfree(rhist);
+	GDKfree(cur);
+	GDKfree(lvals);
+	GDKfree(rvals);
+	GDKfree(loids);
+	GDKfree(roids);
+	GDKfree(bkt);
+	GDKfree(nxt);
+
+	/* also set other bits of heap to correct value to indicate size */
+	BATsetcount(r1, BATcount(r1));
+	if (r2) {
+		BATsetcount(r2, BATcount(r2));
+		assert(BATcount(r1) == BATcount(r2));
+	}
+	if (ordered && BATcount(r1) > 1) {
+		/* bring the result in the order of the left input */
+		GDKqsort(Tloc(r1, 0), r2 ? Tloc(r2, 0) : NULL, NULL,
+			 (size_t) BATcount(r1), sizeof(oid),
+			 r2 ? sizeof(oid) : 0, TYPE_oid);
+		r1->tsorted = true;
+	}
+	if (BATcount(r1) <= 1) {
+		r1->tsorted = true;
+		r1->trevsorted = true;
+		r1->tkey = true;
+		r1->tseqbase = BATcount(r1) == 1 ? *(oid *) Tloc(r1, 0) : 0;
+		if (r2) {
+			r2->tsorted = true;
+			r2->trevsorted = true;
+			r2->tkey = true;
+			r2->tseqbase = BATcount(r2) == 1 ? *(oid *) Tloc(r2, 0) : 0;
+		}
+	}
+	ALGODEBUG fprintf(stderr, "#radixjoin(l=%s,r=%s)=(" ALGOBATFMT ","
+			  ALGOOPTBATFMT ") %d bits " LLFMT "us\n",
+			  BATgetId(l), BATgetId(r),
+			  ALGOBATPAR(r1), ALGOOPTBATPAR(r2),
+			  bits, GDKusec() - t0);
+	return GDK_SUCCEED;
+
+  bailout:
+	GDKfree(lhist);
+	GDKfree(rhist);
+	GDKfree(cur);
+	GDKfree(lvals);
+	GDKfree(rvals);
+	GDKfree(loids);
+	GDKfree(roids);
+	GDKfree(bkt);
+	GDKfree(nxt);
+	BBPreclaim(r1);
+	BBPreclaim(r2);
+	return GDK_FAIL;
+}
+
 #define MASK_EQ		1
 #define MASK_LT		2
 #define MASK_GT		4
@@ -3001,6 +3425,8 @@ thetajoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int opcode, BUN ma
 	bool lskipped = false;	/* whether we skipped values in l */
 	lng loff = 0, roff = 0;
 	oid lval = oid_nil, rval = oid_nil;
+	Zonemap *zm = NULL;
+	BUN zoff = 0, zend;
 
 	ALGODEBUG fprintf(stderr, "#thetajoin(l=" ALGOBATFMT ","
 			  "r=" ALGOBATFMT ",sl=" ALGOOPTBATFMT ","
@@ -3072,6 +3498,12 @@ thetajoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int opcode, BUN ma
 	assert(lvals != NULL || lcand == NULL);
 	assert(rvals != NULL || rcand == NULL);
 
+	/* if we only look for larger or only for smaller values, the
+	 * zone map of r tells us which blocks of r can have matches */
+	if (rcand == NULL && lcnt > 1 &&
+	    (opcode & (MASK_LT | MASK_GT)) != MASK_NE)
+		zm = ZONEget(r, true, &zoff);
+
 	r1->tkey = true;
 	r1->tsorted = true;
 	r1->trevsorted = true;
@@ -3105,6 +3537,7 @@ thetajoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int opcode, BUN ma
 		if (cmp(vl, nil) != 0) {
 			p = rcand;
 			n = rstart;
+			zend = zm ? rstart : rend;
 			for (;;) {
 				if (rcand) {
 					if (p == rcandend)
@@ -3114,6 +3547,11 @@ thetajoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int opcode, BUN ma
 				} else {
 					if (n == rend)
 						break;
+					if (n == zend &&
+					    !ZONEnextrange(zm, zoff, &n, &zend, rend,
+							   opcode & MASK_LT ? vl : NULL,
+							   opcode & MASK_GT ? vl : NULL))
+						break;
 					if (rvals) {
 						vr = VALUE(r, n);
 						if (roff != 0) {
@@ -3199,6 +3637,89 @@ thetajoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr, int opcode, BUN ma
 	return GDK_FAIL;
 }
 
+/* Calculate the inclusive range of values v of the right column of a
+ * band join that can match the left value *vl, i.e. *vl - *c2 <= v <=
+ * *vl + *c1, for skipping blocks using the zone map.  The bounds are
+ * stored in *lo and *hi and *plo and *phi are pointed at them, unless
+ * the bound is outside the domain of the type (or can't be
+ * calculated), in which case they are left alone.  For the floating
+ * point types the range is widened to also cover the rounding errors
+ * of the calculation in bandjoin. */
+#define BANDRANGE(TYPE, WIDE)						\
+	do {								\
+		WIDE v = (WIDE) *(const TYPE *) vl;			\
+		WIDE l = v - (WIDE) *(const TYPE *) c2;			\
+		WIDE h = v + (WIDE) *(const TYPE *) c1;			\
+		if (l >= (WIDE) GDK_##TYPE##_min) {			\
+			*(TYPE *) lo = l > (WIDE) GDK_##TYPE##_max ?	\
+				GDK_##TYPE##_max : (TYPE) l;		\
+			*plo = lo;					\
+		}							\
+		if (h <= (WIDE) GDK_##TYPE##_max) {			\
+			*(TYPE *) hi = h < (WIDE) GDK_##TYPE##_min ?	\
+				GDK_##TYPE##_min : (TYPE) h;		\
+			*phi = hi;					\
+		}							\
+	} while (false)
+#define BANDRANGE_FLT(TYPE, NEXTAFTER)					\
+	do {								\
+		dbl v = *(const TYPE *) vl;				\
+		dbl d1 = *(const TYPE *) c1;				\
+		dbl d2 = *(const TYPE *) c2;				\
+		dbl eps = (fabs(v) + fabs(d1) + fabs(d2)) * 4 * DBL_EPSILON; \
+		dbl l = v - d2 - eps;					\
+		dbl h = v + d1 + eps;					\
+		if (l >= GDK_##TYPE##_min) {				\
+			TYPE x = l > GDK_##TYPE##_max ? GDK_##TYPE##_max : (TYPE) l; \
+			if (x > l)					\
+				x = NEXTAFTER(x, GDK_##TYPE##_min);	\
+			*(TYPE *) lo = x;				\
+			*plo = lo;					\
+		}							\
+		if (h <= GDK_##TYPE##_max) {				\
+			TYPE x = h < GDK_##TYPE##_min ? GDK_##TYPE##_min : (TYPE) h; \
+			if (x < h)					\
+				x = NEXTAFTER(x, GDK_##TYPE##_max);	\
+			*(TYPE *) hi = x;				\
+			*phi = hi;					\
+		}							\
+	} while (false)
+
+static void
+bandrange(int t, const void *vl, const void *c1, const void *c2,
+	  void *lo, void *hi, const void **plo, const void **phi)
+{
+	switch (t) {
+	case TYPE_bte:
+		BANDRANGE(bte, sht);
+		break;
+	case TYPE_sht:
+		BANDRANGE(sht, int);
+		break;
+	case TYPE_int:
+		BANDRANGE(int, lng);
+		break;
+	case TYPE_lng:
+#ifdef HAVE_HGE
+		BANDRANGE(lng, hge);
+#else
+#ifdef HAVE___INT128
+		BANDRANGE(lng, __int128);
+#endif
+#endif
+		break;
+	case TYPE_flt:
+		BANDRANGE_FLT(flt, nextafterf);
+		break;
+	case TYPE_dbl:
+		BANDRANGE_FLT(dbl, nextafter);
+		break;
+	default:
+		/* no bounds */
+		break;
+	}
+}
+
 static gdk_return
 bandjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
 	 const void *c1, const void *c2, bool li, bool hi, BUN maxsize)
@@ -3220,6 +3741,10 @@ bandjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
 	oid lo, ro;
 	bool lskipped = false;	/* whether we skipped values in l */
 	BUN nils = 0;		/* needed for XXX_WITH_CHECK macros */
+	Zonemap *zm = NULL;
+	BUN zoff = 0, zend;
+	ValRecord zl, zh;
+	const void *zlo = NULL, *zhi = NULL;
 
 	assert(ATOMtype(l->ttype) == ATOMtype(r->ttype));
 	assert(sl == NULL || sl->tsorted);
@@ -3297,6 +3822,11 @@ bandjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
 	assert(lvals != NULL);
 	assert(rvals != NULL);
 
+	/* use the zone map of r to skip the blocks of r that cannot
+	 * contain values in the band around the left value */
+	if (rcand == NULL && lcnt > 1)
+		zm = ZONEget(r, true, &zoff);
+
 	r1->tkey = true;
 	r1->tsorted = true;
 	r1->trevsorted = true;
@@ -3322,6 +3852,12 @@ bandjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
 		nr = 0;
 		p = rcand;
 		n = rstart;
+		zend = rend;
+		if (zm) {
+			zlo = zhi = NULL;
+			bandrange(t, vl, c1, c2, &zl.val, &zh.val, &zlo, &zhi);
+			zend = rstart;
+		}
 		for (;;) {
 			if (rcand) {
 				if (p == rcandend)
@@ -3331,6 +3867,10 @@ bandjoin(BAT *r1, BAT *r2, BAT *l, BAT *r, BAT *sl, BAT *sr,
 			} else {
 				if (n == rend)
 					break;
+				if (n == zend &&
+				    !ZONEnextrange(zm, zoff, &n, &zend, rend,
+						   zlo, zhi))
+					break;
 				vr = FVALUE(r, n);
 				ro = n++ + r->hseqbase;
 			}
@@ -3710,6 +4250,13 @@ leftjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr,
 	phash = sr == NULL &&
 		VIEWtparent(r) != 0 &&
 		BATcount(BBPquickdesc(VIEWtparent(r), false)) == BATcount(r);
+	if (!nil_on_miss && !semi && !only_misses &&
+	    !BATcheckbhash(r) && !BATcheckhash(r) &&
+	    !(phash && (BATcheckbhash(BBPdescriptor(VIEWtparent(r))) ||
+			BATcheckhash(BBPdescriptor(VIEWtparent(r))))) &&
+	    radixjoin_wanted(l, r, rcount))
+		return radixjoin(r1, r2, l, r, sl, sr, nil_matches, true,
+				 maxsize, t0, false, "leftjoin");
 	return hashjoin(r1, r2, l, r, sl, sr, nil_matches, nil_on_miss, semi,
 			only_misses, maxsize, t0, false, phash, "leftjoin");
 }
@@ -3922,6 +4469,16 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches
 		/* both sorted */
 		return mergejoin(r1, r2, l, r, sl, sr, nil_matches, false, false, false, maxsize, t0, false);
 	}
+	/* a bucketized hash was requested explicitly and is cheap to
+	 * probe, so if either side has one, use it */
+	if ((sr == NULL || BATtdense(sr)) && BATcheckbhash(r))
+		return hashjoin(r1, r2, l, r, sl, sr, nil_matches, false, false,
+				false, maxsize, t0, false, false,
+				"right has bucketized hash");
+	if ((sl == NULL || BATtdense(sl)) && BATcheckbhash(l))
+		return hashjoin(r2, r1, r, l, sr, sl, nil_matches, false, false,
+				false, maxsize, t0, true, false,
+				"left has bucketized hash");
 	if (sl == NULL) {
 		lhash = BATcheckhash(l);
 		if (lhash) {
@@ -4015,6 +4572,16 @@ BATjoin(BAT **r1p, BAT **r2p, BAT *l, BAT *r, BAT *sl, BAT *sr, bool nil_matches
 		swap = true;
 		reason = "left is smaller";
 	}
+	if (!lhash && !rhash &&
+	    radixjoin_wanted(l, r, MIN(lcount, rcount))) {
+		/* no hashes and the one we would create does not fit
+		 * in the cache: partition both, smallest is inner */
+		if (lcount < rcount)
+			return radixjoin(r2, r1, r, l, sr, sl, nil_matches,
+					 false, maxsize, t0, true, "no hash");
+		return radixjoin(r1, r2, l, r, sl, sr, nil_matches,
+				 false, maxsize, t0, false, "no hash");
+	}
 	if (swap) {
 		return hashjoin(r2, r1, r, l, sr, sl, nil_matches, false, false,
 				false, maxsize, t0, true, plhash, reason);
@@ -74,6 +74,7 @@
 #define LOG_USE		8
 #define LOG_CLEAR	9
 #define LOG_SEQ		10
+#define LOG_UPDATE_PAX	11	/* LOG_UPDATE, all ids before all values */
 
 #ifdef HAVE_EMBEDDED
 #define printf(fmt,...) ((void) 0)
@@ -101,6 +102,7 @@ static char *log_commands[] = {
 	"LOG_USE",
 	"LOG_CLEAR",
 	"LOG_SEQ",
+	"LOG_UPDATE_PAX",
 };
 
 typedef struct logformat_t {
@@ -264,19 +266,27 @@ avoid_snapshot(logger *lg, log_bid bid)
 	return 0;
 }
 
-static gdk_return
-la_bat_clear(logger *lg, logaction *la)
+/* the BAT to which the LOG_INSERT, LOG_UPDATE, or LOG_CLEAR action
+ * la is to be applied, or 0 if it is to be skipped */
+static log_bid
+la_bat_find(logger *lg, logaction *la)
 {
 	log_bid bid = logger_find_bat(lg, la->name);
+
+	/* do we need to skip these old updates */
+	if (bid == 0 || avoid_snapshot(lg, bid))
+		return 0;
+	return bid;
+}
+
+static gdk_return
+la_bat_clear(logger *lg, logaction *la, log_bid bid)
+{
 	BAT *b;
 
 	if (lg->debug & 1)
 		fprintf(stderr, "#la_bat_clear %s\n", la->name);
 
-	/* do we need to skip these old updates */
-	if (avoid_snapshot(lg, bid))
-		return GDK_SUCCEED;
-
 	b = BATdescriptor(bid);
 	if (b) {
 		int access = b->batRestricted;
@@ -357,6 +367,19 @@ mbrRead(void *dst, stream *s, size_t cnt)
 }
 #endif
 
+/* the values of b were read straight into its heap: set the count
+ * and forget the properties of the (then empty) BAT */
+static void
+log_setcount(BAT *b, BUN cnt)
+{
+	BATsetcount(b, cnt);
+	b->tsorted = b->trevsorted = b->tkey = false;
+	b->tnosorted = b->tnorevsorted = 0;
+	b->tnokey[0] = b->tnokey[1] = 0;
+	b->tnonil = b->tnil = false;
+	BATsettrivprop(b);
+}
+
 static log_return
 log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 {
@@ -364,7 +387,12 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 	BAT *b = BATdescriptor(bid);
 	log_return res = LOG_OK;
 	int ht = -1, tt = -1, tseq = 0;
+	bool pax = l->flag == LOG_UPDATE_PAX;
 
+	/* it's the same update, only the values are laid out
+	 * differently */
+	if (pax)
+		l->flag = LOG_UPDATE;
 	if (lg->debug & 1)
 		fprintf(stderr, "#logger found log_read_updates %s %s " LLFMT "\n", name, l->flag == LOG_INSERT ? "insert" : "update", l->nr);
 
@@ -397,7 +425,10 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 		BAT *uid = NULL;
 		BAT *r;
 		void *(*rt) (ptr, stream *, size_t) = BATatoms[tt].atomRead;
+		void *(*rh) (ptr, stream *, size_t) = ht == TYPE_void ? BATatoms[TYPE_oid].atomRead : BATatoms[ht].atomRead;
 		void *tv = NULL;
+		/* fixed-width values are read as one array */
+		bool bulk = tt > TYPE_void && ATOMstorage(tt) < TYPE_str;
 
 		if (ATOMstorage(tt) < TYPE_str)
 			tv = lg->buf;
@@ -414,7 +445,7 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 
 		assert(l->nr <= (lng) BUN_MAX);
 		if (l->flag == LOG_UPDATE) {
-			uid = COLnew(0, ht, (BUN) l->nr, PERSISTENT);
+			uid = COLnew(0, pax ? TYPE_oid : ht, (BUN) l->nr, PERSISTENT);
 			if (uid == NULL) {
 				logbat_destroy(b);
 				return LOG_ERR;
@@ -432,7 +463,23 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 		if (tseq)
 			BATtseqbase(r, 0);
 
-		if (ht == TYPE_void && l->flag == LOG_INSERT) {
+		if (pax) {
+			/* the ids come first, all of them */
+			if (rh(Tloc(uid, 0), lg->log, (size_t) l->nr) == NULL)
+				res = LOG_EOF;
+			else
+				log_setcount(uid, (BUN) l->nr);
+		}
+		if (res != LOG_OK) {
+			/* nothing more to read */
+		} else if (bulk && (pax || l->flag == LOG_INSERT)) {
+			if (rt(Tloc(r, 0), lg->log, (size_t) l->nr) == NULL) {
+				res = LOG_EOF;
+			} else {
+				log_setcount(r, (BUN) l->nr);
+				l->nr = 0;
+			}
+		} else if (pax || (ht == TYPE_void && l->flag == LOG_INSERT)) {
 			for (; res == LOG_OK && l->nr > 0; l->nr--) {
 				void *t = rt(tv, lg->log, 1);
 
@@ -453,7 +500,6 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 					GDKfree(t);
 			}
 		} else {
-			void *(*rh) (ptr, stream *, size_t) = ht == TYPE_void ? BATatoms[TYPE_oid].atomRead : BATatoms[ht].atomRead;
 			void *hv = ATOMnil(ht);
 
 			if (hv == NULL)
@@ -509,18 +555,10 @@ log_read_updates(logger *lg, trans *tr, logformat *l, char *name)
 }
 
 static gdk_return
-la_bat_updates(logger *lg, logaction *la)
+la_bat_updates(logaction *la, log_bid bid)
 {
-	log_bid bid = logger_find_bat(lg, la->name);
 	BAT *b;
 
-	if (bid == 0)
-		return GDK_SUCCEED; /* ignore bats no longer in the catalog */
-
-	/* do we need to skip these old updates */
-	if (avoid_snapshot(lg, bid))
-		return GDK_SUCCEED;
-
 	b = BATdescriptor(bid);
 	if (b == NULL)
 		return GDK_FAIL;
@@ -782,6 +820,17 @@ tr_find(trans *tr, int tid)
 	return t;
 }
 
+/* apply an update (LOG_INSERT, LOG_UPDATE, or LOG_CLEAR) to BAT bid */
+static gdk_return
+la_bat_apply(logger *lg, logaction *c, log_bid bid)
+{
+	if (bid == 0)
+		return GDK_SUCCEED;
+	if (c->type == LOG_CLEAR)
+		return la_bat_clear(lg, c, bid);
+	return la_bat_updates(c, bid);
+}
+
 static gdk_return
 la_apply(logger *lg, logaction *c)
 {
@@ -790,7 +839,8 @@ la_apply(logger *lg, logaction *c)
 	switch (c->type) {
 	case LOG_INSERT:
 	case LOG_UPDATE:
-		ret = la_bat_updates(lg, c);
+	case LOG_CLEAR:
+		ret = la_bat_apply(lg, c, la_bat_find(lg, c));
 		break;
 	case LOG_CREATE:
 		ret = la_bat_create(lg, c);
@@ -801,9 +851,6 @@ la_apply(logger *lg, logaction *c)
 	case LOG_DESTROY:
 		ret = la_bat_destroy(lg, c);
 		break;
-	case LOG_CLEAR:
-		ret = la_bat_clear(lg, c);
-		break;
 	}
 	lg->changes += (ret == GDK_SUCCEED);
 	return ret;
@@ -839,7 +886,10 @@ static trans *
 tr_destroy(trans *tr)
 {
 	trans *r = tr->tr;
+	int i;
 
+	for (i = 0; i < tr->nr; i++)
+		la_destroy(&tr->changes[i]);
 	GDKfree(tr->changes);
 	GDKfree(tr);
 	return r;
@@ -848,34 +898,236 @@ tr_destroy(trans *tr)
 static trans *
 tr_abort(logger *lg, trans *tr)
 {
-	int i;
-
 	if (lg->debug & 1)
 		fprintf(stderr, "#tr_abort\n");
 
-	for (i = 0; i < tr->nr; i++)
-		la_destroy(&tr->changes[i]);
 	return tr_destroy(tr);
 }
 
-static trans *
-tr_commit(logger *lg, trans *tr)
+/*
+ * Replaying the log.  The changes of a committed transaction are
+ * applied in the order in which they were logged, except that runs
+ * of updates (LOG_INSERT, LOG_UPDATE, and LOG_CLEAR), which only
+ * change the contents of BATs, are applied by a number of threads in
+ * parallel, each thread applying all updates of one BAT at a time.
+ * The BATs the updates apply to are looked up beforehand, since only
+ * the thread reading the log may access the catalog.  The run at the
+ * end of a transaction is applied while the log is read further.  It
+ * is waited for before the next transaction is committed, before the
+ * reader looks at a BAT of the run, and when the whole log has been
+ * read.  Runs with fewer than REPLAY_MINCOUNT values are applied
+ * directly by the reader.
+ */
+#define REPLAY_MINCOUNT	((BUN) 1 << 16)
+
+struct replayact {
+	log_bid bid;		/* BAT to apply the update to */
+	int idx;		/* index of the update in the transaction */
+};
+
+struct replay {
+	logger *lg;
+	MT_Lock lock;
+	trans *tr;		/* transaction being applied */
+	struct replayact *acts;	/* the run, sorted on BAT */
+	int nacts, maxacts;
+	int next;		/* next update to be applied */
+	int changes;		/* number of updates applied */
+	bool failed;
+	int nthreads;		/* number of running threads */
+	MT_Id *tids;
+};
+
+static int
+replaycmp(const void *p1, const void *p2)
+{
+	const struct replayact *a1 = p1, *a2 = p2;
+
+	if (a1->bid != a2->bid)
+		return a1->bid < a2->bid ? -1 : 1;
+	return a1->idx < a2->idx ? -1 : a1->idx > a2->idx;
+}
+
+static void
+replay_worker(void *arg)
+{
+	struct replay *rp = arg;
+	int i, n, cnt;
+
+	for (;;) {
+		/* claim all updates of the next BAT */
+		MT_lock_set(&rp->lock);
+		if (rp->failed || rp->next == rp->nacts) {
+			MT_lock_unset(&rp->lock);
+			return;
+		}
+		i = rp->next;
+		for (n = i + 1; n < rp->nacts && rp->acts[n].bid == rp->acts[i].bid; n++)
+			;
+		rp->next = n;
+		MT_lock_unset(&rp->lock);
+		cnt = n - i;
+		for (; i < n; i++) {
+			if (la_bat_apply(rp->lg, &rp->tr->changes[rp->acts[i].idx],
+					 rp->acts[i].bid) != GDK_SUCCEED) {
+				fprintf(stderr, "!ERROR: replay_worker: "
+					"applying update to %s failed\n",
+					rp->tr->changes[rp->acts[i].idx].name);
+				MT_lock_set(&rp->lock);
+				rp->failed = true;
+				MT_lock_unset(&rp->lock);
+				return;
+			}
+		}
+		MT_lock_set(&rp->lock);
+		rp->changes += cnt;
+		MT_lock_unset(&rp->lock);
+	}
+}
+
+/* wait for the run being applied, and destroy its transaction if it
+ * was handed to us */
+static gdk_return
+replay_wait(struct replay *rp, bool destroy)
 {
 	int i;
 
+	for (i = 0; i < rp->nthreads; i++)
+		MT_join_thread(rp->tids[i]);
+	rp->nthreads = 0;
+	rp->lg->changes += rp->changes;
+	rp->changes = 0;
+	rp->nacts = rp->next = 0;
+	if (destroy && rp->tr)
+		(void) tr_destroy(rp->tr);
+	rp->tr = NULL;
+	return rp->failed ? GDK_FAIL : GDK_SUCCEED;
+}
+
+/* is BAT bid being updated by the run being applied? */
+static bool
+replay_busy(struct replay *rp, log_bid bid)
+{
+	int lo = 0, hi = rp->nacts;
+
+	if (rp->nthreads == 0)
+		return false;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (rp->acts[mid].bid < bid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < rp->nacts && rp->acts[lo].bid == bid;
+}
+
+/* apply the run of nacts updates of transaction tr that were
+ * collected in rp->acts; if async is set, the transaction is handed
+ * to rp and the run may still be in progress on return */
+static gdk_return
+replay_run(struct replay *rp, trans *tr, int nacts, bool async)
+{
+	BUN cnt = 0;
+	int i, ngroups = 0, nthreads;
+
+	qsort(rp->acts, nacts, sizeof(*rp->acts), replaycmp);
+	for (i = 0; i < nacts; i++) {
+		logaction *la = &tr->changes[rp->acts[i].idx];
+
+		if (la->b)
+			cnt += BATcount(la->b);
+		if (i == 0 || rp->acts[i].bid != rp->acts[i - 1].bid)
+			ngroups++;
+	}
+	rp->tr = tr;
+	rp->nacts = nacts;
+	rp->next = 0;
+	/* when asynchronous, the reader doesn't help */
+	nthreads = GDKnr_threads - async;
+	if (nthreads > ngroups)
+		nthreads = ngroups;
+	if (cnt >= REPLAY_MINCOUNT && nthreads > (int) !async) {
+		PERFDEBUG fprintf(stderr, "#replay_run: " BUNFMT " values in "
+				  "%d bats with %d threads%s\n", cnt, ngroups,
+				  nthreads, async ? " in the background" : "");
+		for (i = async ? 0 : 1; i < nthreads; i++) {
+			if (MT_create_thread(&rp->tids[rp->nthreads],
+					     replay_worker, rp,
+					     MT_THR_JOINABLE) == 0)
+				rp->nthreads++;
+		}
+	}
+	if (async && rp->nthreads > 0)
+		return GDK_SUCCEED;
+	/* do (the rest of) the work ourselves */
+	replay_worker(rp);
+	return replay_wait(rp, async);
+}
+
+static trans *
+tr_commit(logger *lg, trans *tr, struct replay *rp)
+{
+	trans *next;
+	int i, n = 0;
+
 	if (lg->debug & 1)
 		fprintf(stderr, "#tr_commit\n");
 
+	/* the previous transaction must be complete first */
+	if (replay_wait(rp, true) != GDK_SUCCEED)
+		goto bailout;
+	if (tr->nr > rp->maxacts) {
+		struct replayact *acts;
+
+		acts = GDKrealloc(rp->acts, tr->nr * sizeof(*rp->acts));
+		if (acts == NULL)
+			goto bailout;
+		rp->acts = acts;
+		rp->maxacts = tr->nr;
+	}
 	for (i = 0; i < tr->nr; i++) {
-		if (la_apply(lg, &tr->changes[i]) != GDK_SUCCEED) {
-			do {
-				tr = tr_abort(lg, tr);
-			} while (tr != NULL);
-			return (trans *) -1;
+		logaction *la = &tr->changes[i];
+
+		switch (la->type) {
+		case LOG_INSERT:
+		case LOG_UPDATE:
+		case LOG_CLEAR:
+			/* collect a run of updates */
+			rp->acts[n].bid = la_bat_find(lg, la);
+			rp->acts[n].idx = i;
+			if (rp->acts[n].bid != 0)
+				n++;
+			else
+				lg->changes++;
+			break;
+		default:
+			if (n > 0 && replay_run(rp, tr, n, false) != GDK_SUCCEED)
+				goto bailout;
+			n = 0;
+			if (la_apply(lg, la) != GDK_SUCCEED)
+				goto bailout;
+			break;
 		}
-		la_destroy(&tr->changes[i]);
 	}
-	return tr_destroy(tr);
+	next = tr->tr;
+	tr->tr = NULL;
+	if (n > 0) {
+		/* rp destroys tr when done */
+		if (replay_run(rp, tr, n, true) != GDK_SUCCEED)
+			goto bailout_next;
+	} else {
+		(void) tr_destroy(tr);
+	}
+	return next;
+
+  bailout:
+	next = tr_destroy(tr);
+  bailout_next:
+	while (next != NULL)
+		next = tr_abort(lg, next);
+	return (trans *) -1;
 }
 
 static gdk_return log_sequence_nrs(logger *lg);
@@ -977,20 +1229,45 @@ logger_open(logger *lg)
 static void
 logger_close(logger *lg)
 {
+	/* transactions may still be waiting for the log to be synced */
+	if (lg->log && log_tsync(lg, lg->flushed) != GDK_SUCCEED)
+		fprintf(stderr, "!ERROR: logger_close: sync failed\n");
 	close_stream(lg->log);
 	lg->log = NULL;
 }
 
+/* reports how far we got reading the log while the server is
+ * starting, e.g. through the status shown by monetdb(1) */
+static logger_progress_fptr logger_progress = NULL;
+
+static void
+logger_report(const char *filename, int pct)
+{
+	char buf[256];
+	const char *base;
+
+	if (logger_progress == NULL)
+		return;
+	if ((base = strrchr(filename, DIR_SEP)) != NULL)
+		filename = base + 1;
+	if (pct < 0)
+		snprintf(buf, sizeof(buf), "replayed write-ahead log %s", filename);
+	else
+		snprintf(buf, sizeof(buf), "replaying write-ahead log %s (%d%% done)", filename, pct);
+	(*logger_progress)(buf);
+}
+
 static gdk_return
 logger_readlog(logger *lg, char *filename)
 {
 	trans *tr = NULL;
 	logformat l;
 	log_return err = LOG_OK;
-	time_t t0, t1;
+	time_t t0, t1, tp;
 	struct stat sb;
 	int dbg = GDKdebug;
-	int fd;
+	int fd, pct = 0;
+	struct replay rp;
 
 	GDKdebug &= ~(CHECKMASK|PROPMASK);
 
@@ -1016,7 +1293,22 @@ logger_readlog(logger *lg, char *filename)
 		 * something weird is going on */
 		return GDK_FAIL;
 	}
-	t0 = time(NULL);
+	if ((rp.tids = GDKmalloc(GDKnr_threads * sizeof(MT_Id))) == NULL) {
+		mnstr_destroy(lg->log);
+		lg->log = NULL;
+		GDKdebug = dbg;
+		return GDK_FAIL;
+	}
+	MT_lock_init(&rp.lock, "logger_readlog");
+	rp.lg = lg;
+	rp.tr = NULL;
+	rp.acts = NULL;
+	rp.nacts = rp.maxacts = rp.next = 0;
+	rp.changes = 0;
+	rp.failed = false;
+	rp.nthreads = 0;
+	tp = t0 = time(NULL);
+	logger_report(filename, 0);
 	if (lg->debug & 1) {
 		printf("# Start reading the write-ahead log '%s'\n", filename);
 		fflush(stdout);
@@ -1025,6 +1317,15 @@ logger_readlog(logger *lg, char *filename)
 		char *name = NULL;
 
 		t1 = time(NULL);
+		if (logger_progress && t1 != tp && sb.st_size > 0) {
+			/* not more than once a second */
+			lng fpos = (lng) getfilepos(getFile(lg->log));
+			tp = t1;
+			if (fpos >= 0 && (int) (fpos * 100 / sb.st_size) != pct) {
+				pct = (int) (fpos * 100 / sb.st_size);
+				logger_report(filename, pct);
+			}
+		}
 		if (t1 - t0 > 10) {
 			lng fpos;
 			t0 = t1;
@@ -1088,15 +1389,19 @@ logger_readlog(logger *lg, char *filename)
 			else if (l.tid != l.nr)	/* abort record */
 				tr = tr_abort(lg, tr);
 			else
-				tr = tr_commit(lg, tr);
+				tr = tr_commit(lg, tr, &rp);
 			break;
 		case LOG_SEQ:
 			err = log_read_seq(lg, &l);
 			break;
 		case LOG_INSERT:
 		case LOG_UPDATE:
+		case LOG_UPDATE_PAX:
 			if (name == NULL || tr == NULL)
 				err = LOG_EOF;
+			else if (replay_busy(&rp, logger_find_bat(lg, name)) &&
+				 replay_wait(&rp, true) != GDK_SUCCEED)
+				err = LOG_ERR;
 			else
 				err = log_read_updates(lg, tr, &l, name);
 			break;
@@ -1135,6 +1440,12 @@ logger_readlog(logger *lg, char *filename)
 			break;
 		}
 	}
+	if (replay_wait(&rp, true) != GDK_SUCCEED)
+		err = LOG_ERR;
+	logger_report(filename, -1);
+	MT_lock_destroy(&rp.lock);
+	GDKfree(rp.tids);
+	GDKfree(rp.acts);
 	logger_close(lg);
 
 	/* remaining transactions are not committed, ie abort */
@@ -1161,11 +1472,16 @@ logger_readlogs(logger *lg, FILE *fp, char *filename)
 {
 	gdk_return res = GDK_SUCCEED;
 	char id[BUFSIZ];
+	lng sid = 0;
 
 	if (lg->debug & 1) {
 		fprintf(stderr, "#logger_readlogs logger id is " LLFMT "\n", lg->id);
 	}
 
+	/* the id of the first log file whose changes are not yet
+	 * contained in the persistent BATs */
+	(void) logger_sequence(lg, LOG_SID, &sid);
+
 	while (fgets(id, sizeof(id), fp) != NULL) {
 		char log_filename[FILENAME_MAX];
 		lng lid = strtoll(id, NULL, 10);
@@ -1174,6 +1490,20 @@ logger_readlogs(logger *lg, FILE *fp, char *filename)
 			fprintf(stderr, "#logger_readlogs last logger id written in %s is " LLFMT "\n", filename, lid);
 		}
 
+		if (!lg->shared && lid < sid) {
+			/* logger_exit committed the BATs but was
+			 * interrupted before it could switch to the
+			 * next log file, so the log file was restored
+			 * from its backup: its changes are already
+			 * persistent and must not be applied again.
+			 * Count a change so that logger_create
+			 * finishes the switch. */
+			if (lg->debug & 1) {
+				fprintf(stderr, "#logger_readlogs %s." LLFMT " is already persistent, continuing with " LLFMT "\n", filename, lid, sid);
+			}
+			lid = sid;
+			lg->changes++;
+		}
 		if (!lg->shared && lid >= lg->id) {
 			lg->id = lid;
 			snprintf(log_filename, sizeof(log_filename), "%s." LLFMT, filename, lg->id);
@@ -1990,6 +2320,7 @@ logger_load(int debug, const char *fn, char filename[FILENAME_MAX], logger *lg)
 	GDKfree(lg->dir);
 	GDKfree(lg->local_dir);
 	GDKfree(lg->buf);
+	MT_lock_destroy(&lg->synclock);
 	GDKfree(lg);
 	return GDK_FAIL;
 }
@@ -2086,6 +2417,15 @@ logger_new(int debug, const char *fn, const char *logdir, int version, preversio
 	lg->postfuncp = postfuncp;
 	lg->log = NULL;
 	lg->end = 0;
+	MT_lock_init(&lg->synclock, "logger_synclock");
+	lg->flushed = 0;
+	lg->synced = 0;
+	lg->syncing = false;
+	lg->syncfailed = false;
+	lg->waiters = NULL;
+	lg->nsyncs = 0;
+	lg->nsynced = 0;
+	lg->maxbatch = 0;
 	lg->catalog_bid = NULL;
 	lg->catalog_nme = NULL;
 	lg->dcatalog = NULL;
@@ -2194,6 +2534,14 @@ logger_destroy(logger *lg)
 	GDKfree(lg->fn);
 	GDKfree(lg->dir);
 	logger_close(lg);
+	if (lg->nsyncs > 0)
+		PERFDEBUG fprintf(stderr, "#logger_destroy: " LLFMT
+				  " transactions in " LLFMT " syncs "
+				  "(%.1f on average, at most " LLFMT ")\n",
+				  lg->nsynced, lg->nsyncs,
+				  (double) lg->nsynced / lg->nsyncs,
+				  lg->maxbatch);
+	MT_lock_destroy(&lg->synclock);
 	GDKfree(lg);
 }
 
@@ -2604,18 +2952,37 @@ log_delta(logger *lg, BAT *uid, BAT *uval, const char *name)
 		gdk_return (*wh) (const void *, stream *, size_t) = BATatoms[TYPE_oid].atomWrite;
 		gdk_return (*wt) (const void *, stream *, size_t) = BATatoms[uval->ttype].atomWrite;
 
-		l.flag = LOG_UPDATE;
-		if (log_write_format(lg, &l) != GDK_SUCCEED ||
-		    log_write_string(lg, name) != GDK_SUCCEED)
-			return GDK_FAIL;
+		if (uid->ttype == TYPE_oid) {
+			/* write all ids and then all values, each as
+			 * one array if we can */
+			l.flag = LOG_UPDATE_PAX;
+			if (log_write_format(lg, &l) != GDK_SUCCEED ||
+			    log_write_string(lg, name) != GDK_SUCCEED)
+				return GDK_FAIL;
+
+			ok = wh(BUNtail(ii, 0), lg->log, (size_t) l.nr);
+			if (uval->ttype > TYPE_void &&
+			    ATOMstorage(uval->ttype) < TYPE_str) {
+				if (ok == GDK_SUCCEED)
+					ok = wt(BUNtail(vi, 0), lg->log, (size_t) l.nr);
+			} else {
+				for (p = 0; p < BUNlast(uval) && ok == GDK_SUCCEED; p++)
+					ok = wt(BUNtail(vi, p), lg->log, 1);
+			}
+		} else {
+			l.flag = LOG_UPDATE;
+			if (log_write_format(lg, &l) != GDK_SUCCEED ||
+			    log_write_string(lg, name) != GDK_SUCCEED)
+				return GDK_FAIL;
 
-		for (p = 0; p < BUNlast(uid) && ok == GDK_SUCCEED; p++) {
-			const void *id = BUNtail(ii, p);
-			const void *val = BUNtail(vi, p);
+			for (p = 0; p < BUNlast(uid) && ok == GDK_SUCCEED; p++) {
+				const void *id = BUNtail(ii, p);
+				const void *val = BUNtail(vi, p);
 
-			ok = wh(id, lg->log, 1);
-			if (ok == GDK_SUCCEED)
-				ok = wt(val, lg->log, 1);
+				ok = wh(id, lg->log, 1);
+				if (ok == GDK_SUCCEED)
+					ok = wt(val, lg->log, 1);
+			}
 		}
 
 		if (lg->debug & 1)
@@ -2652,8 +3019,7 @@ log_bat(logger *lg, BAT *b, const char *name)
 			return GDK_FAIL;
 
 		if (b->ttype > TYPE_void &&
-		    b->ttype < TYPE_str &&
-		    !isVIEW(b)) {
+		    ATOMstorage(b->ttype) < TYPE_str) {
 			const void *t = BUNtail(bi, b->batInserted);
 
 			ok = wt(t, lg->log, (size_t)l.nr);
@@ -2739,14 +3105,106 @@ pre_allocate(logger *lg)
 	return GDK_SUCCEED;
 }
 
+/*
+ * Group commit.  Ending a transaction is done in two steps.
+ * log_tflush writes the end of transaction record and flushes the log
+ * to the operating system; it is called while the caller holds its
+ * exclusive lock, and numbers the transactions in the order in which
+ * they are written.  log_tsync then waits until the log is on disk up
+ * to and including that transaction, and should be called after the
+ * caller released its lock, so that other transactions can flush
+ * theirs in the mean time.  The first thread to call log_tsync syncs
+ * the log on behalf of all transactions flushed up to then, and all
+ * threads that call log_tsync while that sync is in progress wait for
+ * it and then for the next one, which is done by one of them for all
+ * of them.  With gdk_commit_delay set, the syncing thread first waits
+ * (up to that many milliseconds) as long as other transactions keep
+ * getting flushed, so that more of them are synced together.
+ * A transaction is reported committed only when its log records are
+ * on disk, so this does not change the durability guarantees; the
+ * caller must treat a failing log_tsync like a failing log_tend.
+ * log_tend does both steps.
+ */
+struct logwaiter {
+	MT_Sema sema;
+	struct logwaiter *next;
+};
+
 gdk_return
-log_tend(logger *lg)
+log_tsync(logger *lg, lng commit)
+{
+	struct logwaiter w, *wp;
+	stream *log;
+	lng target, t0 = 0;
+	int i, rc;
+
+	if (GDKdebug & NOSYNCMASK)
+		return GDK_SUCCEED;
+	MT_lock_set(&lg->synclock);
+	while (lg->synced < commit && !lg->syncfailed) {
+		if (lg->syncing) {
+			/* wait for the sync in progress and try again,
+			 * since it may not include our transaction */
+			MT_sema_init(&w.sema, 0, "log_tsync");
+			w.next = lg->waiters;
+			lg->waiters = &w;
+			MT_lock_unset(&lg->synclock);
+			MT_sema_down(&w.sema);
+			MT_sema_destroy(&w.sema);
+			MT_lock_set(&lg->synclock);
+			continue;
+		}
+		lg->syncing = true;
+		for (i = 0; i < GDK_commit_delay; i++) {
+			/* give other transactions a chance to join */
+			target = lg->flushed;
+			MT_lock_unset(&lg->synclock);
+			MT_sleep_ms(1);
+			MT_lock_set(&lg->synclock);
+			if (lg->flushed == target)
+				break;
+		}
+		target = lg->flushed;
+		log = lg->log;
+		MT_lock_unset(&lg->synclock);
+		PERFDEBUG t0 = GDKusec();
+		rc = mnstr_fsync(log);
+		MT_lock_set(&lg->synclock);
+		if (rc) {
+			fprintf(stderr, "!ERROR: log_tsync: sync failed\n");
+			lg->syncfailed = true;
+		} else {
+			lng n = target - lg->synced;
+
+			PERFDEBUG fprintf(stderr, "#log_tsync: synced " LLFMT
+					  " transactions (" LLFMT " usec)\n",
+					  n, GDKusec() - t0);
+			lg->nsyncs++;
+			lg->nsynced += n;
+			if (n > lg->maxbatch)
+				lg->maxbatch = n;
+			lg->synced = target;
+		}
+		lg->syncing = false;
+		/* wake up everybody who waited for this sync */
+		while ((wp = lg->waiters) != NULL) {
+			lg->waiters = wp->next;
+			MT_sema_up(&wp->sema);
+		}
+	}
+	rc = lg->synced < commit;
+	MT_lock_unset(&lg->synclock);
+	return rc ? GDK_FAIL : GDK_SUCCEED;
+}
+
+gdk_return
+log_tflush(logger *lg, lng *commit)
 {
 	logformat l;
 	gdk_return res = GDK_SUCCEED;
 
 	if (lg->debug & 1)
-		fprintf(stderr, "#log_tend %d\n", lg->tid);
+		fprintf(stderr, "#log_tflush %d\n", lg->tid);
 
 	if (DELTAdirty(lg->snapshots_bid)) {
 		/* sub commit all new snapshots */
@@ -2781,8 +3239,23 @@ log_tend(logger *lg)
 	if (res != GDK_SUCCEED ||
 	    log_write_format(lg, &l) != GDK_SUCCEED ||
 	    mnstr_flush(lg->log) ||
-	    (!(GDKdebug & NOSYNCMASK) && mnstr_fsync(lg->log)) ||
 	    pre_allocate(lg) != GDK_SUCCEED) {
+		fprintf(stderr, "!ERROR: log_tflush: write failed\n");
+		return GDK_FAIL;
+	}
+	MT_lock_set(&lg->synclock);
+	*commit = ++lg->flushed;
+	MT_lock_unset(&lg->synclock);
+	return GDK_SUCCEED;
+}
+
+gdk_return
+log_tend(logger *lg)
+{
+	lng commit;
+
+	if (log_tflush(lg, &commit) != GDK_SUCCEED ||
+	    log_tsync(lg, commit) != GDK_SUCCEED) {
 		fprintf(stderr, "!ERROR: log_tend: write failed\n");
 		return GDK_FAIL;
 	}
@@ -3066,6 +3539,12 @@ geomcatalogfix_get(void)
 	return geomcatalogfix;
 }
 
+void
+logger_progress_set(logger_progress_fptr f)
+{
+	logger_progress = f;
+}
+
 void
 geomsqlfix_set(geomsqlfix_fptr f)
 {
@@ -74,6 +74,18 @@ typedef struct logger {
 				   commit). */
 	void *buf;
 	size_t bufsize;
+	/* group commit: transactions are numbered in the order in
+	 * which log_tflush wrote them, log_tsync waits until the log
+	 * has been synced up to and including a transaction */
+	MT_Lock synclock;
+	lng flushed;		/* last transaction flushed to the log */
+	lng synced;		/* last transaction synced to disk */
+	bool syncing;		/* a thread is syncing the log */
+	bool syncfailed;	/* syncing the log failed */
+	struct logwaiter *waiters; /* threads waiting for the sync */
+	lng nsyncs;		/* number of syncs */
+	lng nsynced;		/* number of transactions synced by them */
+	lng maxbatch;		/* most transactions synced by a single sync */
 } logger;
 
 /* Holds logger settings
@@ -127,6 +139,8 @@ gdk_export gdk_return log_delta(logger *lg, BAT *uid, BAT *uval, const char *n);
 
 gdk_export gdk_return log_tstart(logger *lg);	/* TODO return transaction id */
 gdk_export gdk_return log_tend(logger *lg);
+gdk_export gdk_return log_tflush(logger *lg, lng *commit);
+gdk_export gdk_return log_tsync(logger *lg, lng commit);
 gdk_export gdk_return log_abort(logger *lg);
 
 gdk_export gdk_return log_sequence(logger *lg, int seq, lng id);
@@ -141,6 +155,9 @@ typedef int (*geomcatalogfix_fptr)(void *, int);
 gdk_export void geomcatalogfix_set(geomcatalogfix_fptr);
 gdk_export geomcatalogfix_fptr geomcatalogfix_get(void);
 
+typedef void (*logger_progress_fptr)(const char *);
+gdk_export void logger_progress_set(logger_progress_fptr);
+
 typedef str (*geomsqlfix_fptr)(int);
 gdk_export void geomsqlfix_set(geomsqlfix_fptr);
 gdk_export geomsqlfix_fptr geomsqlfix_get(void);
@@ -165,15 +165,242 @@ persistOIDX(BAT *b)
 #endif
 }
 
+/* Parallel construction of the order index.
+ *
+ * The BAT is cut into nthreads consecutive slices which are sorted
+ * (stably) by separate threads, after which pairs of adjacent runs are
+ * merged, again in parallel, until a single run remains.  When two
+ * values compare equal, the merge takes the one from the left run, so
+ * the result is the stable sort order of the whole BAT, i.e. exactly
+ * what the serial stable sort produces.  If the values are unique,
+ * there is only one possible order and a non-stable index can also be
+ * built in parallel; otherwise a non-stable index is left to the
+ * serial quicksort since we cannot reproduce its order of ties. */
+#define OIDX_PAR_MIN	((BUN) 1 << 16) /* min nr of values per thread */
+
+struct oidxpar {
+	BAT *b;
+	BUN lo, hi;		/* sort: slice of b */
+	const oid *p0, *q0;	/* merge: left run */
+	const oid *p1, *q1;	/* merge: right run */
+	oid *mv;		/* sort/merge: where the result goes */
+	bool merge;
+	bool failed;
+	MT_Id tid;
+	bool started;
+};
+
+#define OIDX_MERGE(TYPE)						\
+	do {								\
+		const TYPE *restrict v = (const TYPE *) Tloc(b, 0) - b->hseqbase; \
+		while (p0 < q0 && p1 < q1) {				\
+			if (v[*p0] <= v[*p1])				\
+				*mv++ = *p0++;				\
+			else						\
+				*mv++ = *p1++;				\
+		}							\
+	} while (0)
+
+/* merge two runs of oids into mv, ties go to the left run */
+static void
+OIDXmergerun(BAT *b, const oid *p0, const oid *q0,
+	     const oid *p1, const oid *q1, oid *restrict mv)
+{
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_bte: OIDX_MERGE(bte); break;
+	case TYPE_sht: OIDX_MERGE(sht); break;
+	case TYPE_int: OIDX_MERGE(int); break;
+	case TYPE_lng: OIDX_MERGE(lng); break;
+#ifdef HAVE_HGE
+	case TYPE_hge: OIDX_MERGE(hge); break;
+#endif
+	default: {
+		/* also flt and dbl: nil (NaN) must compare smallest */
+		BATiter bi = bat_iterator(b);
+		int (*cmp)(const void *, const void *) = ATOMcompare(b->ttype);
+		oid hseq = b->hseqbase;
+
+		while (p0 < q0 && p1 < q1) {
+			if ((*cmp)(BUNtail(bi, *p0 - hseq),
+				   BUNtail(bi, *p1 - hseq)) <= 0)
+				*mv++ = *p0++;
+			else
+				*mv++ = *p1++;
+		}
+		break;
+	}
+	}
+	while (p0 < q0)
+		*mv++ = *p0++;
+	while (p1 < q1)
+		*mv++ = *p1++;
+}
+
+static void
+OIDXparworker(void *arg)
+{
+	struct oidxpar *op = arg;
+	BAT *s, *on;
+
+	if (op->merge) {
+		OIDXmergerun(op->b, op->p0, op->q0, op->p1, op->q1, op->mv);
+		return;
+	}
+	if ((s = BATslice(op->b, op->lo, op->hi)) == NULL) {
+		op->failed = true;
+		return;
+	}
+	if (BATsortthreads(NULL, &on, NULL, s, NULL, NULL, false, true, 1) != GDK_SUCCEED) {
+		BBPunfix(s->batCacheid);
+		op->failed = true;
+		return;
+	}
+	assert(BATcount(on) == op->hi - op->lo);
+	if (BATtdense(on)) {
+		oid o = on->tseqbase;
+		for (BUN i = op->lo; i < op->hi; i++)
+			*op->mv++ = o++;
+	} else {
+		memcpy(op->mv, Tloc(on, 0), BATcount(on) * sizeof(oid));
+	}
+	BBPunfix(on->batCacheid);
+	BBPunfix(s->batCacheid);
+}
+
+/* run the first n tasks, the calling thread doing the first */
+static void
+OIDXparrun(struct oidxpar *op, int n)
+{
+	int i;
+
+	for (i = 1; i < n; i++)
+		op[i].started = MT_create_thread(&op[i].tid, OIDXparworker,
+						 &op[i], MT_THR_JOINABLE) == 0;
+	OIDXparworker(&op[0]);
+	for (i = 1; i < n; i++) {
+		if (op[i].started)
+			MT_join_thread(op[i].tid);
+		else
+			OIDXparworker(&op[i]); /* couldn't start thread */
+	}
+}
+
+/* Fill mv (BATcount(b) oids) with the stable sort order of b using
+ * nthreads threads. */
+static gdk_return
+OIDXbuildpar(BAT *b, oid *restrict mv, int nthreads)
+{
+	BUN cnt = BATcount(b);
+	struct oidxpar *op;
+	BUN *bounds;
+	oid *tmp, *src, *dst;
+	int nruns, i, j;
+
+	op = GDKzalloc(nthreads * sizeof(struct oidxpar));
+	bounds = GDKmalloc((nthreads + 1) * sizeof(BUN));
+	tmp = GDKmalloc(cnt * sizeof(oid));
+	if (op == NULL || bounds == NULL || tmp == NULL) {
+		GDKfree(op);
+		GDKfree(bounds);
+		GDKfree(tmp);
+		return GDK_FAIL;
+	}
+
+	/* sort the slices into tmp */
+	for (i = 0; i <= nthreads; i++)
+		bounds[i] = (BUN) ((ulng) cnt * i / nthreads);
+	for (i = 0; i < nthreads; i++) {
+		op[i].b = b;
+		op[i].lo = bounds[i];
+		op[i].hi = bounds[i + 1];
+		op[i].mv = tmp + bounds[i];
+	}
+	OIDXparrun(op, nthreads);
+	for (i = 0; i < nthreads; i++) {
+		if (op[i].failed) {
+			GDKfree(op);
+			GDKfree(bounds);
+			GDKfree(tmp);
+			return GDK_FAIL;
+		}
+	}
+
+	/* merge pairs of adjacent runs, flipping between tmp and mv;
+	 * a run without a partner is copied along */
+	src = tmp;
+	dst = mv;
+	for (nruns = nthreads; nruns > 1; nruns = (nruns + 1) / 2) {
+		for (i = j = 0; i < nruns; i += 2, j++) {
+			BUN hi = i + 1 < nruns ? bounds[i + 2] : bounds[i + 1];
+			op[j] = (struct oidxpar) {
+				.b = b,
+				.merge = true,
+				.p0 = src + bounds[i],
+				.q0 = src + bounds[i + 1],
+				.p1 = src + bounds[i + 1],
+				.q1 = src + hi,
+				.mv = dst + bounds[i],
+			};
+			bounds[j] = bounds[i];
+		}
+		bounds[j] = cnt;
+		OIDXparrun(op, j);
+		src = dst;
+		dst = dst == mv ? tmp : mv;
+	}
+	if (src != mv)
+		memcpy(mv, src, cnt * sizeof(oid));
+	GDKfree(op);
+	GDKfree(bounds);
+	GDKfree(tmp);
+	return GDK_SUCCEED;
+}
+
+/* create an order index on b if there isn't one yet, using at most
+ * nthreads threads */
 gdk_return
-BATorderidx(BAT *b, bool stable)
+BATorderidxbuild(BAT *b, bool stable, int nthreads)
 {
+	int npar = nthreads;
+
 	if (BATcheckorderidx(b))
 		return GDK_SUCCEED;
+	if (BATcount(b) / OIDX_PAR_MIN < (BUN) npar)
+		npar = (int) (BATcount(b) / OIDX_PAR_MIN);
+	if (npar > 1 && (stable || b->tkey) && !BATtdense(b) &&
+	    !BATordered(b)) {
+		Heap *m;
+		lng t0 = 0;
+
+		ALGODEBUG {
+			fprintf(stderr, "#BATorderidxbuild(" ALGOBATFMT ",%d) create index with %d threads\n", ALGOBATPAR(b), stable, npar);
+			t0 = GDKusec();
+		}
+		if ((m = createOIDXheap(b, stable)) == NULL)
+			return GDK_FAIL;
+		if (OIDXbuildpar(b, (oid *) m->base + ORDERIDXOFF, npar) != GDK_SUCCEED) {
+			HEAPfree(m, true);
+			GDKfree(m);
+			return GDK_FAIL;
+		}
+		MT_lock_set(&GDKhashLock(b->batCacheid));
+		if (b->torderidx == NULL) {
+			b->torderidx = m;
+			b->batDirtydesc = 1;
+			persistOIDX(b);
+		} else {
+			/* someone beat us to it */
+			HEAPfree(m, true);
+			GDKfree(m);
+		}
+		MT_lock_unset(&GDKhashLock(b->batCacheid));
+		ALGODEBUG fprintf(stderr, "#BATorderidxbuild(" ALGOBATFMT "): " LLFMT " usec\n", ALGOBATPAR(b), GDKusec() - t0);
+		return GDK_SUCCEED;
+	}
 	if (!BATtdense(b)) {
 		BAT *on;
 		ALGODEBUG fprintf(stderr, "#BATorderidx(" ALGOBATFMT ",%d) create index\n", ALGOBATPAR(b), stable);
-		if (BATsort(NULL, &on, NULL, b, NULL, NULL, false, stable) != GDK_SUCCEED)
+		if (BATsortthreads(NULL, &on, NULL, b, NULL, NULL, false, stable, nthreads) != GDK_SUCCEED)
 			return GDK_FAIL;
 		assert(BATcount(b) == BATcount(on));
 		if (BATtdense(on)) {
@@ -207,6 +434,12 @@ BATorderidx(BAT *b, bool stable)
 	return GDK_SUCCEED;
 }
 
+gdk_return
+BATorderidx(BAT *b, bool stable)
+{
+	return BATorderidxbuild(b, stable, GDKnr_threads);
+}
+
 #define BINARY_MERGE(TYPE)						\
 	do {								\
 		TYPE *v = (TYPE *) Tloc(b, 0);				\
@@ -691,6 +691,22 @@ MT_msync(void *p, size_t len)
 	return ret;
 }
 
+/* give the OS advice about how the memory in [p, p+len) is going to
+ * be accessed; p must be page aligned; failure is not an error, since
+ * the advice is just a hint */
+int
+MT_madvise(void *p, size_t len, int advice)
+{
+	int ret = posix_madvise(p, len, advice);
+
+#ifdef MMAP_DEBUG
+	fprintf(stderr,
+		     "#madvise(%p,%zu,%d) = %d\n",
+		     p, len, advice, ret);
+#endif
+	return ret;
+}
+
 int
 MT_path_absolute(const char *pathname)
 {
@@ -891,6 +907,16 @@ MT_msync(void *p, size_t len)
 	return 0;
 }
 
+int
+MT_madvise(void *p, size_t len, int advice)
+{
+	/* there is no equivalent of madvise on Windows */
+	(void) p;
+	(void) len;
+	(void) advice;
+	return 0;
+}
+
 int
 MT_path_absolute(const char *pathname)
 {
@@ -40,6 +40,10 @@ __hidden str ATOMunknown_name(int a)
 	__attribute__((__visibility__("hidden")));
 __hidden void ATOMunknown_clean(void)
 	__attribute__((__visibility__("hidden")));
+__hidden void BATadvise(BAT *b, int advice)
+	__attribute__((__visibility__("hidden")));
+__hidden bool BATcheckbhash(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden bool BATcheckhash(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden bool BATcheckimprints(BAT *b)
@@ -57,7 +61,7 @@ __hidden void BATdestroy(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden void BATfree(BAT *b)
 	__attribute__((__visibility__("hidden")));
-__hidden gdk_return BATgroup_internal(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted)
+__hidden gdk_return BATgroup_internal(BAT **groups, BAT **extents, BAT **histo, BAT *b, BAT *s, BAT *g, BAT *e, BAT *h, bool subsorted, int nthreads)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
 __hidden Hash *BAThash_impl(BAT *b, BAT *s, const char *ext)
@@ -92,6 +96,8 @@ __hidden int BBPselectfarm(int role, int type, enum heaptype hptype)
 	__attribute__((__visibility__("hidden")));
 __hidden void BBPunshare(bat b)
 	__attribute__((__visibility__("hidden")));
+__hidden void BHASHfree(BAT *b)
+	__attribute__((__visibility__("hidden")));
 __hidden BUN binsearch(const oid *restrict indir, oid offset, int type, const void *restrict vals, const char * restrict vars, int width, BUN lo, BUN hi, const void *restrict v, int ordering, int last)
 	__attribute__((__visibility__("hidden")));
 __hidden BUN binsearch_bte(const oid *restrict indir, oid offset, const bte *restrict vals, BUN lo, BUN hi, bte v, int ordering, int last)
@@ -110,6 +116,16 @@ __hidden BUN binsearch_flt(const oid *restrict indir, oid offset, const flt *res
 	__attribute__((__visibility__("hidden")));
 __hidden BUN binsearch_dbl(const oid *restrict indir, oid offset, const dbl *restrict vals, BUN lo, BUN hi, dbl v, int ordering, int last)
 	__attribute__((__visibility__("hidden")));
+__hidden void CANDMASKdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden void CANDMASKfree(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return COMPload(BAT *b, const char *nme)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return COMPsave(BAT *b, const char *nme)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
 __hidden Heap *createOIDXheap(BAT *b, bool stable)
 	__attribute__((__visibility__("hidden")));
 __hidden gdk_return BUNreplace(BAT *b, oid left, const void *right, bool force)
@@ -140,6 +156,8 @@ __hidden void *GDKmremap(const char *path, int mode, void *old_address, size_t o
 __hidden gdk_return GDKmunmap(void *addr, size_t len)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden void GDKprefetch(int farmid, const char *nme, const char *ext)
+	__attribute__((__visibility__("hidden")));
 __hidden gdk_return GDKremovedir(int farmid, const char *nme)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
@@ -195,6 +213,8 @@ void IMPSprint(BAT *b)		/* never called: for debugging only */
 #endif
 __hidden void MT_init_posix(void)
 	__attribute__((__visibility__("hidden")));
+__hidden int MT_madvise(void *p, size_t len, int advice)
+	__attribute__((__visibility__("hidden")));
 __hidden void *MT_mremap(const char *path, int mode, void *old_address, size_t old_size, size_t *new_size)
 	__attribute__((__visibility__("hidden")));
 __hidden int MT_msync(void *p, size_t len)
@@ -206,6 +226,25 @@ __hidden void persistOIDX(BAT *b)
 __hidden gdk_return rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li, bool hi, BUN maxsize)
 	__attribute__((__warn_unused_result__))
 	__attribute__((__visibility__("hidden")));
+__hidden void SELECTinit(void)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return STRDICTcopy(Heap *dst, const Heap *src)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return STRDICTcreate(Heap *h)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
+__hidden void STRDICTfree(Heap *h)
+	__attribute__((__visibility__("hidden")));
+__hidden void STRDICTinsert(Heap *h, var_t pos, BUN strhash)
+	__attribute__((__visibility__("hidden")));
+__hidden void STRDICTload(Heap *h, const char *nme)
+	__attribute__((__visibility__("hidden")));
+__hidden var_t STRDICTlocate(const Heap *h, const char *v, BUN strhash)
+	__attribute__((__visibility__("hidden")));
+__hidden gdk_return STRDICTsave(Heap *h, const char *nme)
+	__attribute__((__warn_unused_result__))
+	__attribute__((__visibility__("hidden")));
 __hidden void strCleanHash(Heap *hp, bool rebuild)
 	__attribute__((__visibility__("hidden")));
 __hidden int strCmpNoNil(const unsigned char *l, const unsigned char *r)
@@ -222,6 +261,16 @@ __hidden gdk_return VIEWreset(BAT *b)
 	__attribute__((__visibility__("hidden")));
 __hidden BAT *virtualize(BAT *bn)
 	__attribute__((__visibility__("hidden")));
+__hidden void ZONEdestroy(BAT *b)
+	__attribute__((__visibility__("hidden")));
+__hidden Zonemap *ZONEget(BAT *b, bool create, BUN *offp)
+	__attribute__((__visibility__("hidden")));
+__hidden bool ZONEminmax(BAT *b, bool max, BUN *startp, BUN *endp)
+	__attribute__((__visibility__("hidden")));
+__hidden Zonemap *ZONEnew(BAT *b, int shift)
+	__attribute__((__visibility__("hidden")));
+__hidden bool ZONEnextrange(const Zonemap *zm, BUN off, BUN *pp, BUN *qp, BUN q, const void *lo, const void *hi)
+	__attribute__((__visibility__("hidden")));
 __hidden bool binsearchcand(const oid *cand, BUN lo, BUN hi, oid v)
 	__attribute__((__visibility__("hidden")));
 __hidden void gdk_bbp_reset(void)
@@ -282,6 +331,25 @@ struct Imprints {
 	BUN dictcnt;		/* counter for cache dictionary               */
 };
 
+struct Zonemap {
+	int type;		/* (base) type of the column */
+	int shift;		/* log2 of the number of values per block */
+	BUN count;		/* number of values covered */
+	BUN nblocks;		/* number of blocks covered */
+	BUN capacity;		/* number of blocks allocated */
+	void *min;		/* smallest non-nil value per block */
+	void *max;		/* largest non-nil value per block */
+};
+
+struct StrDict {
+	BUN mask;		/* number of slots - 1 (a power of two - 1) */
+	BUN count;		/* number of strings in the dictionary */
+	BUN puts;		/* number of strPut calls since creation */
+	BUN hits;		/* number of those that found their string */
+	size_t *base;		/* file header followed by the slots */
+	var_t *slots;		/* offsets of the strings, 0 if empty */
+};
+
 typedef struct {
 	MT_Lock swap;
 	MT_Lock hash;
@@ -310,6 +378,10 @@ extern bbplock_t GDKbbpLock[BBP_THREADMASK + 1];
 extern size_t GDK_mmap_minsize_persistent; /* size after which we use memory mapped files for persistent heaps */
 extern size_t GDK_mmap_minsize_transient; /* size after which we use memory mapped files for transient heaps */
 extern size_t GDK_mmap_pagesize; /* mmap granularity */
+extern int GDK_radixjoin;	/* use radix-partitioned joins (0: no, 1: auto, 2: yes) */
+extern int GDK_strdict;		/* give large string heaps a dictionary (0: no, 1: auto, 2: yes) */
+extern int GDK_compress;	/* save persistent tail heaps compressed (0: no, 1: yes) */
+extern int GDK_commit_delay;	/* max wait (ms) for more transactions to sync the log with */
 extern MT_Lock GDKnameLock;
 extern MT_Lock GDKthreadLock;
 extern MT_Lock GDKtmLock;
@@ -9,6 +9,7 @@
 #include "monetdb_config.h"
 #include "gdk.h"
 #include "gdk_private.h"
+#include "gdk_cand.h"
 
 /*
  * BATproject returns a BAT aligned with the left input whose values
@@ -16,7 +17,51 @@
  * OIDs in the tail of the left input.
  */
 
+/* l is a compressed candidate list, so there are no nils and the
+ * oids are ascending */
+#define project_mask_loop(TYPE)						\
+static gdk_return							\
+project_mask_##TYPE(BAT *bn, BAT *l, BAT *r, bool nilcheck)		\
+{									\
+	struct candmaskiter ci;						\
+	const TYPE *restrict rt;					\
+	TYPE *restrict bt;						\
+	TYPE v;								\
+	BUN lo, hi;							\
+	oid rseq;							\
+									\
+	rseq = r->hseqbase;						\
+	if (l->tmask->first < rseq ||					\
+	    l->tmask->first + l->tmask->nbits > rseq + BATcount(r)) {	\
+		GDKerror("BATproject: does not match always\n");	\
+		return GDK_FAIL;					\
+	}								\
+	rt = (const TYPE *) Tloc(r, 0);					\
+	bt = (TYPE *) Tloc(bn, 0);					\
+	candmask_init(&ci, l->tmask, l->tmask->first);			\
+	hi = BATcount(l);						\
+	if (nilcheck) {							\
+		for (lo = 0; lo < hi; lo++) {				\
+			v = rt[candmask_next(&ci) - rseq];		\
+			bt[lo] = v;					\
+			if (is_##TYPE##_nil(v)) {			\
+				bn->tnonil = false;			\
+				bn->tnil = true;			\
+				lo++;					\
+				break;					\
+			}						\
+		}							\
+	} else {							\
+		lo = 0;							\
+	}								\
+	for (; lo < hi; lo++)						\
+		bt[lo] = rt[candmask_next(&ci) - rseq];			\
+	BATsetcount(bn, hi);						\
+	return GDK_SUCCEED;						\
+}
+
 #define project_loop(TYPE)						\
+project_mask_loop(TYPE)							\
 static gdk_return							\
 project_##TYPE(BAT *bn, BAT *l, BAT *r, bool nilcheck)			\
 {									\
@@ -27,6 +72,8 @@ project_##TYPE(BAT *bn, BAT *l, BAT *r, bool nilcheck)			\
 	const oid *restrict o;						\
 	oid rseq, rend;							\
 									\
+	if (l->tmask)							\
+		return project_mask_##TYPE(bn, l, r, nilcheck);		\
 	o = (const oid *) Tloc(l, 0);					\
 	rt = (const TYPE *) Tloc(r, 0);					\
 	bt = (TYPE *) Tloc(bn, 0);					\
@@ -106,6 +153,8 @@ project_void(BAT *bn, BAT *l, BAT *r)
 	oid rseq, rend;
 
 	assert(BATtdense(r));
+	if (BATcandmaterialize(l) != GDK_SUCCEED)
+		return GDK_FAIL;
 	o = (const oid *) Tloc(l, 0);
 	bt = (oid *) Tloc(bn, 0);
 	bn->tsorted = l->tsorted;
@@ -149,6 +198,8 @@ project_any(BAT *bn, BAT *l, BAT *r, bool nilcheck)
 	const oid *o;
 	oid rseq, rend;
 
+	if (BATcandmaterialize(l) != GDK_SUCCEED)
+		return GDK_FAIL;
 	o = (const oid *) Tloc(l, 0);
 	n = 0;
 	ri = bat_iterator(r);
@@ -288,6 +339,9 @@ BATproject(BAT *l, BAT *r)
 	}
 	bn->tnil = false;
 
+	/* values are fetched from r in the order of l */
+	BATadvise(r, l->tsorted ? MMAP_SEQUENTIAL : MMAP_WILLNEED);
+
 	switch (tpe) {
 	case TYPE_bte:
 		res = project_bte(bn, l, r, nilcheck);
@@ -135,6 +135,8 @@ doubleslice(BAT *b, BUN l1, BUN h1, BUN l2, BUN h2)
 		    (cmp == NULL ||			\
 		     (*cmp)(v, BUNtail(bi, hb)) == 0))
 
+/* if b has a bucketized hash, use it, otherwise use (and if needed
+ * create) the chained hash */
 static BAT *
 hashselect(BAT *b, BAT *s, BAT *bn, const void *tl, BUN maximum, bool phash)
 {
@@ -144,6 +146,7 @@ hashselect(BAT *b, BAT *s, BAT *bn, const void *tl, BUN maximum, bool phash)
 	BUN l, h;
 	oid seq;
 	int (*cmp)(const void *, const void *);
+	bool bucket;
 
 	assert(bn->ttype == TYPE_oid);
 	seq = b->hseqbase;
@@ -174,14 +177,17 @@ hashselect(BAT *b, BAT *s, BAT *bn, const void *tl, BUN maximum, bool phash)
 		}
 		s = NULL;
 	}
-	if (BAThash(b) != GDK_SUCCEED) {
+	bucket = BATcheckbhash(b);
+	if (!bucket && BAThash(b) != GDK_SUCCEED) {
 		BBPreclaim(bn);
 		return NULL;
 	}
 	switch (ATOMbasetype(b->ttype)) {
 	case TYPE_bte:
 	case TYPE_sht:
-		cmp = NULL;	/* no need to compare: "hash" is perfect */
+		/* no need to compare: "hash" is perfect (but the
+		 * tag in the bucketized hash isn't) */
+		cmp = bucket ? ATOMcompare(b->ttype) : NULL;
 		break;
 	default:
 		cmp = ATOMcompare(b->ttype);
@@ -190,7 +196,22 @@ hashselect(BAT *b, BAT *s, BAT *bn, const void *tl, BUN maximum, bool phash)
 	bi = bat_iterator(b);
 	dst = (oid *) Tloc(bn, 0);
 	cnt = 0;
-	if (s) {
+	if (bucket) {
+		ALGODEBUG fprintf(stderr, "#hashselect(" ALGOBATFMT "): "
+				  "using bucketized hash\n",
+				  ALGOBATPAR(b));
+		/* the bucketized hash produces results in the order
+		 * low to high, so no need to reverse */
+		BHASHloop_bound(bi, b->tbhash, i, tl, l, h) {
+			o = (oid) (i - l + seq);
+			if (s == NULL || SORTfnd(s, &o) != BUN_NONE) {
+				buninsfix(bn, dst, cnt, o,
+					  maximum - BATcapacity(bn),
+					  maximum, NULL);
+				cnt++;
+			}
+		}
+	} else if (s) {
 		assert(s->tsorted);
 		HASHloop_bound(bi, b->thash, i, tl, l, h) {
 			o = (oid) (i - l + seq);
@@ -212,7 +233,7 @@ hashselect(BAT *b, BAT *s, BAT *bn, const void *tl, BUN maximum, bool phash)
 	}
 	BATsetcount(bn, cnt);
 	bn->tkey = true;
-	if (cnt > 1) {
+	if (!bucket && cnt > 1) {
 		/* hash chains produce results in the order high to
 		 * low, so we just need to reverse */
 		for (l = 0, h = BUNlast(bn) - 1; l < h; l++, h--) {
@@ -734,7 +755,7 @@ fullscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	BUN p = r;
 	oid o = (oid) (p + off);
 
-	if (!equi || !GDK_ELIMDOUBLES(b->tvheap))
+	if (!equi || !GDK_ELIMALL(b->tvheap))
 		return fullscan_any(b, s, bn, tl, th, li, hi, equi, anti,
 				    lval, hval, lnil, r, q, cnt, off, dst,
 				    candlist, maximum, use_imprints);
@@ -835,6 +856,442 @@ fullscan_str(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 scan_sel(candscan, o = *candlist++, w = (BUN) ((*(oid *) Tloc(s,q?(q - 1):0)) + 1))
 /* scan/imprints select without candidates */
 scan_sel(fullscan, o = (oid) (p+off), w = (BUN) (q+off))
+/* scan/imprints select with a compressed candidate list */
+#define maskscan_init							\
+	struct candmaskiter ci;						\
+	candmask_init(&ci, s->tmask, (oid) off);			\
+	w = (BUN) (s->tmask->first + s->tmask->nbits)
+scan_sel(maskscan, o = candmask_next(&ci), maskscan_init)
+
+/* Vectorized scan select.
+ *
+ * For a scan over (a dense range of) the fixed size values of b with
+ * enough space in the result, the values are compared a whole vector
+ * at a time and the qualifying oids are written using a lookup table
+ * indexed by four bits of the comparison mask: all four candidate
+ * oids are stored and the result count is advanced by the number of
+ * bits set, so there is no branch per value.  The kernels are compiled
+ * for AVX2 and for SSE4.2; which one is used (if any) is determined at
+ * startup.  Only the comparisons whose semantics the vector
+ * instructions reproduce exactly are done this way, the others, and
+ * the tail of the scan, are left to the scalar code. */
+enum simdlevel { SIMD_NONE, SIMD_SSE42, SIMD_AVX2 };
+static enum simdlevel simdlevel = SIMD_NONE;
+
+void
+SELECTinit(void)
+{
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		simdlevel = SIMD_AVX2;
+	else if (__builtin_cpu_supports("sse4.2"))
+		simdlevel = SIMD_SSE42;
+#endif
+}
+
+#if defined(HAVE_X86_SIMD) && SIZEOF_OID == 8
+#include <immintrin.h>
+
+/* the predicates, the same as those of the scalar scanloops */
+enum simdpred {
+	SIMD_EQ,		/* v == vl */
+	SIMD_LE,		/* v <= vh */
+	SIMD_GE,		/* v >= vl */
+	SIMD_RANGE,		/* v >= vl && v <= vh */
+	SIMD_ANTI,		/* v <= vl || v >= vh */
+};
+
+/* for each 4 bit mask, the offsets of the bits that are set */
+static const lng simdoffsets[16][4] = {
+	{0, 0, 0, 0}, {0, 0, 0, 0}, {1, 0, 0, 0}, {0, 1, 0, 0},
+	{2, 0, 0, 0}, {0, 2, 0, 0}, {1, 2, 0, 0}, {0, 1, 2, 0},
+	{3, 0, 0, 0}, {0, 3, 0, 0}, {1, 3, 0, 0}, {0, 1, 3, 0},
+	{2, 3, 0, 0}, {0, 2, 3, 0}, {1, 2, 3, 0}, {0, 1, 2, 3},
+};
+static const unsigned char simdpopcnt[16] = {
+	0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+};
+
+/* Write the oids o+k for the bits k that are set in the LANES bit
+ * mask M.  Each store writes four oids, but never beyond the
+ * (LANES-1)'th entry following the current end of the result. */
+#define SIMDEMIT_AVX2(M, LANES)						\
+	do {								\
+		int _k;							\
+		for (_k = 0; _k < (LANES); _k += 4) {			\
+			unsigned _n = ((M) >> _k) & 15;			\
+			_mm256_storeu_si256(				\
+				(__m256i *) (dst + cnt),		\
+				_mm256_add_epi64(			\
+					_mm256_set1_epi64x((lng) (p + off) + _k), \
+					_mm256_loadu_si256((const __m256i *) simdoffsets[_n]))); \
+			cnt += simdpopcnt[_n];				\
+		}							\
+	} while (false)
+#define SIMDEMIT_SSE42(M, LANES)					\
+	do {								\
+		int _k;							\
+		for (_k = 0; _k < (LANES); _k += 4) {			\
+			unsigned _n = ((M) >> _k) & 15;			\
+			__m128i _b = _mm_set1_epi64x((lng) (p + off) + _k); \
+			_mm_storeu_si128(				\
+				(__m128i *) (dst + cnt),		\
+				_mm_add_epi64(_b, _mm_loadu_si128((const __m128i *) simdoffsets[_n]))); \
+			_mm_storeu_si128(				\
+				(__m128i *) (dst + cnt + 2),		\
+				_mm_add_epi64(_b, _mm_loadu_si128((const __m128i *) &simdoffsets[_n][2]))); \
+			cnt += simdpopcnt[_n];				\
+		}							\
+	} while (false)
+
+/* Compute the mask of qualifying values for signed integers.  The
+ * instruction sets only have "greater than" and "equal", so for all
+ * but equality we compute the mask of the values that don't qualify
+ * and invert it. */
+#define SIMDINTMASK(GT, EQ, MOVEMASK, V, LO, HI, FULL)			\
+	(pred == SIMD_EQ ? MOVEMASK(EQ(V, LO)) :			\
+	 pred == SIMD_LE ? ~MOVEMASK(GT(V, HI)) & (FULL) :		\
+	 pred == SIMD_GE ? ~MOVEMASK(GT(LO, V)) & (FULL) :		\
+	 pred == SIMD_RANGE ? ~MOVEMASK(GT(LO, V) | GT(V, HI)) & (FULL) : \
+	 ~MOVEMASK(GT(V, LO) & GT(HI, V)) & (FULL))
+
+/* Compute the mask of qualifying values for floating point values.
+ * The ordered comparisons are false for NaN (nil), just like the C
+ * comparison operators. */
+#define SIMDFLTMASK(CMP, OR, AND, MOVEMASK, V, LO, HI)			\
+	(pred == SIMD_EQ ? MOVEMASK(CMP(V, LO, _CMP_EQ_OQ)) :		\
+	 pred == SIMD_LE ? MOVEMASK(CMP(V, HI, _CMP_LE_OQ)) :		\
+	 pred == SIMD_GE ? MOVEMASK(CMP(V, LO, _CMP_GE_OQ)) :		\
+	 pred == SIMD_RANGE ? MOVEMASK(AND(CMP(V, LO, _CMP_GE_OQ), CMP(V, HI, _CMP_LE_OQ))) : \
+	 MOVEMASK(OR(CMP(V, LO, _CMP_LE_OQ), CMP(V, HI, _CMP_GE_OQ))))
+
+/* the AVX2 kernels */
+#define avx2_gt8(a, b)	_mm256_cmpgt_epi8(a, b)
+#define avx2_eq8(a, b)	_mm256_cmpeq_epi8(a, b)
+#define avx2_mm8(m)	((unsigned) _mm256_movemask_epi8(m))
+#define avx2_gt16(a, b)	_mm256_cmpgt_epi16(a, b)
+#define avx2_eq16(a, b)	_mm256_cmpeq_epi16(a, b)
+#define avx2_mm16(m)	((unsigned) _mm_movemask_epi8(_mm_packs_epi16(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1))))
+#define avx2_gt32(a, b)	_mm256_cmpgt_epi32(a, b)
+#define avx2_eq32(a, b)	_mm256_cmpeq_epi32(a, b)
+#define avx2_mm32(m)	((unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(m)))
+#define avx2_gt64(a, b)	_mm256_cmpgt_epi64(a, b)
+#define avx2_eq64(a, b)	_mm256_cmpeq_epi64(a, b)
+#define avx2_mm64(m)	((unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(m)))
+
+#define SIMDSCAN_AVX2_INT(TYPE, BITS, SET1)				\
+static __attribute__((__target__("avx2"))) BUN				\
+simdscan_avx2_##TYPE(const TYPE *restrict src, BUN *pp, BUN q, lng off,	\
+		     oid *restrict dst, BUN cnt, TYPE vl, TYPE vh,	\
+		     enum simdpred pred)				\
+{									\
+	const int lanes = 32 / sizeof(TYPE);				\
+	const unsigned full = (unsigned) ((1ULL << lanes) - 1);	\
+	const __m256i lo = SET1(vl), hi = SET1(vh);			\
+	BUN p = *pp;							\
+									\
+	while (p + lanes <= q) {					\
+		__m256i v = _mm256_loadu_si256((const __m256i *) (src + p)); \
+		unsigned m = SIMDINTMASK(avx2_gt##BITS, avx2_eq##BITS,	\
+					 avx2_mm##BITS, v, lo, hi, full); \
+		if (m)							\
+			SIMDEMIT_AVX2(m, lanes);			\
+		p += lanes;						\
+	}								\
+	*pp = p;							\
+	return cnt;							\
+}
+
+#define SIMDSCAN_AVX2_FLT(TYPE, VEC, LOAD, SET1, CMP, OR, AND, MOVEMASK) \
+static __attribute__((__target__("avx2"))) BUN				\
+simdscan_avx2_##TYPE(const TYPE *restrict src, BUN *pp, BUN q, lng off,	\
+		     oid *restrict dst, BUN cnt, TYPE vl, TYPE vh,	\
+		     enum simdpred pred)				\
+{									\
+	const int lanes = 32 / sizeof(TYPE);				\
+	const VEC lo = SET1(vl), hi = SET1(vh);				\
+	BUN p = *pp;							\
+									\
+	while (p + lanes <= q) {					\
+		VEC v = LOAD(src + p);					\
+		unsigned m = (unsigned) SIMDFLTMASK(CMP, OR, AND, MOVEMASK, v, lo, hi); \
+		if (m)							\
+			SIMDEMIT_AVX2(m, lanes);			\
+		p += lanes;						\
+	}								\
+	*pp = p;							\
+	return cnt;							\
+}
+
+SIMDSCAN_AVX2_INT(bte, 8, _mm256_set1_epi8)
+SIMDSCAN_AVX2_INT(sht, 16, _mm256_set1_epi16)
+SIMDSCAN_AVX2_INT(int, 32, _mm256_set1_epi32)
+SIMDSCAN_AVX2_INT(lng, 64, _mm256_set1_epi64x)
+SIMDSCAN_AVX2_FLT(flt, __m256, _mm256_loadu_ps, _mm256_set1_ps, _mm256_cmp_ps, _mm256_or_ps, _mm256_and_ps, _mm256_movemask_ps)
+SIMDSCAN_AVX2_FLT(dbl, __m256d, _mm256_loadu_pd, _mm256_set1_pd, _mm256_cmp_pd, _mm256_or_pd, _mm256_and_pd, _mm256_movemask_pd)
+
+/* the SSE4.2 kernels; the 64 bit types are done two vectors at a
+ * time so that we always have at least four lanes */
+#define sse_gt8(a, b)	_mm_cmpgt_epi8(a, b)
+#define sse_eq8(a, b)	_mm_cmpeq_epi8(a, b)
+#define sse_mm8(m)	((unsigned) _mm_movemask_epi8(m))
+#define sse_gt16(a, b)	_mm_cmpgt_epi16(a, b)
+#define sse_eq16(a, b)	_mm_cmpeq_epi16(a, b)
+#define sse_mm16(m)	((unsigned) _mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128())))
+#define sse_gt32(a, b)	_mm_cmpgt_epi32(a, b)
+#define sse_eq32(a, b)	_mm_cmpeq_epi32(a, b)
+#define sse_mm32(m)	((unsigned) _mm_movemask_ps(_mm_castsi128_ps(m)))
+#define sse_gt64(a, b)	_mm_cmpgt_epi64(a, b)
+#define sse_eq64(a, b)	_mm_cmpeq_epi64(a, b)
+#define sse_mm64(m)	((unsigned) _mm_movemask_pd(_mm_castsi128_pd(m)))
+/* SSE has no _mm_cmp_ps with a predicate argument; map them */
+#define sse_cmp_ps(a, b, P)						\
+	((P) == _CMP_EQ_OQ ? _mm_cmpeq_ps(a, b) :			\
+	 (P) == _CMP_LE_OQ ? _mm_cmple_ps(a, b) : _mm_cmpge_ps(a, b))
+#define sse_cmp_pd(a, b, P)						\
+	((P) == _CMP_EQ_OQ ? _mm_cmpeq_pd(a, b) :			\
+	 (P) == _CMP_LE_OQ ? _mm_cmple_pd(a, b) : _mm_cmpge_pd(a, b))
+
+#define SIMDSCAN_SSE42_INT(TYPE, BITS, SET1, NVEC)			\
+static __attribute__((__target__("sse4.2"))) BUN			\
+simdscan_sse42_##TYPE(const TYPE *restrict src, BUN *pp, BUN q, lng off, \
+		      oid *restrict dst, BUN cnt, TYPE vl, TYPE vh,	\
+		      enum simdpred pred)				\
+{									\
+	const int vlanes = 16 / sizeof(TYPE);				\
+	const int lanes = NVEC * vlanes;				\
+	const unsigned full = (1U << vlanes) - 1;			\
+	const __m128i lo = SET1(vl), hi = SET1(vh);			\
+	BUN p = *pp;							\
+									\
+	while (p + lanes <= q) {					\
+		unsigned m = 0;						\
+		int i;							\
+		for (i = 0; i < NVEC; i++) {				\
+			__m128i v = _mm_loadu_si128((const __m128i *) (src + p + i * vlanes)); \
+			m |= (SIMDINTMASK(sse_gt##BITS, sse_eq##BITS,	\
+					  sse_mm##BITS, v, lo, hi, full)) << (i * vlanes); \
+		}							\
+		if (m)							\
+			SIMDEMIT_SSE42(m, lanes);			\
+		p += lanes;						\
+	}								\
+	*pp = p;							\
+	return cnt;							\
+}
+
+#define SIMDSCAN_SSE42_FLT(TYPE, VEC, LOAD, SET1, CMP, OR, AND, MOVEMASK, NVEC) \
+static __attribute__((__target__("sse4.2"))) BUN			\
+simdscan_sse42_##TYPE(const TYPE *restrict src, BUN *pp, BUN q, lng off, \
+		      oid *restrict dst, BUN cnt, TYPE vl, TYPE vh,	\
+		      enum simdpred pred)				\
+{									\
+	const int vlanes = 16 / sizeof(TYPE);				\
+	const int lanes = NVEC * vlanes;				\
+	const VEC lo = SET1(vl), hi = SET1(vh);				\
+	BUN p = *pp;							\
+									\
+	while (p + lanes <= q) {					\
+		unsigned m = 0;						\
+		int i;							\
+		for (i = 0; i < NVEC; i++) {				\
+			VEC v = LOAD(src + p + i * vlanes);		\
+			m |= (unsigned) (SIMDFLTMASK(CMP, OR, AND, MOVEMASK, v, lo, hi)) << (i * vlanes); \
+		}							\
+		if (m)							\
+			SIMDEMIT_SSE42(m, lanes);			\
+		p += lanes;						\
+	}								\
+	*pp = p;							\
+	return cnt;							\
+}
+
+SIMDSCAN_SSE42_INT(bte, 8, _mm_set1_epi8, 1)
+SIMDSCAN_SSE42_INT(sht, 16, _mm_set1_epi16, 1)
+SIMDSCAN_SSE42_INT(int, 32, _mm_set1_epi32, 1)
+SIMDSCAN_SSE42_INT(lng, 64, _mm_set1_epi64x, 2)
+SIMDSCAN_SSE42_FLT(flt, __m128, _mm_loadu_ps, _mm_set1_ps, sse_cmp_ps, _mm_or_ps, _mm_and_ps, _mm_movemask_ps, 1)
+SIMDSCAN_SSE42_FLT(dbl, __m128d, _mm_loadu_pd, _mm_set1_pd, sse_cmp_pd, _mm_or_pd, _mm_and_pd, _mm_movemask_pd, 2)
+
+/* determine which predicate the scalar scanfunc would evaluate; if
+ * it's one we don't do vectorized, leave everything to the scalar
+ * code */
+#define SIMDPRED(TYPE)							\
+	do {								\
+		vl = *(const TYPE *) tl;				\
+		vh = *(const TYPE *) th;				\
+		if (equi) {						\
+			if (lnil)					\
+				return cnt;				\
+			pred = SIMD_EQ;					\
+		} else if (anti) {					\
+			if (!b->tnonil)					\
+				return cnt;				\
+			pred = SIMD_ANTI;				\
+		} else if (b->tnonil && vl == MINVALUE##TYPE) {		\
+			pred = SIMD_LE;					\
+		} else if (vh == MAXVALUE##TYPE) {			\
+			pred = SIMD_GE;					\
+		} else {						\
+			pred = SIMD_RANGE;				\
+		}							\
+	} while (false)
+
+/* the result is extended (if needed) once per chunk of values, so
+ * that the kernels never have to check for space */
+#define SIMD_CHUNK	((BUN) 1 << 16)
+
+#define SIMDCALL(TYPE)							\
+	do {								\
+		const TYPE *src = (const TYPE *) Tloc(b, 0);		\
+		TYPE vl, vh;						\
+		SIMDPRED(TYPE);						\
+		for (;;) {						\
+			BUN n = q - p < SIMD_CHUNK ? q - p : SIMD_CHUNK; \
+			BUN p1 = p;					\
+			if (BATcapacity(bn) - cnt < n) {		\
+				/* extrapolate, with 10% margin */	\
+				BUN e = (BUN) ((dbl) cnt / (dbl) (p == p0 ? 1 : p - p0) \
+					       * (dbl) (q - p) * 1.1 + 1024); \
+				if (e < n)				\
+					e = n;				\
+				if (e > q - p)				\
+					e = q - p;			\
+				BATsetcount(bn, cnt);			\
+				if (BATextend(bn, cnt + e) != GDK_SUCCEED) { \
+					BBPreclaim(bn);			\
+					return BUN_NONE;		\
+				}					\
+				dst = (oid *) Tloc(bn, 0);		\
+			}						\
+			cnt = simdlevel == SIMD_AVX2 ?			\
+				simdscan_avx2_##TYPE(src, &p, p + n, off, dst, cnt, vl, vh, pred) : \
+				simdscan_sse42_##TYPE(src, &p, p + n, off, dst, cnt, vl, vh, pred); \
+			if (p == p1)					\
+				break;					\
+		}							\
+	} while (false)
+
+/* Do as much as possible of the scan select of positions [*pp,q) of
+ * b using vector instructions, appending to the cnt oids already in
+ * *dstp, the tail of bn.  On return *pp is the position where the
+ * scalar code has to continue and *dstp the (possibly moved) tail of
+ * bn.  Returns the new result count, or BUN_NONE if bn could not be
+ * extended, in which case bn has been reclaimed. */
+static BUN
+simdscan(BAT *b, BAT *bn, const void *tl, const void *th, bool equi,
+	 bool anti, bool lnil, BUN *pp, BUN q, lng off, oid *restrict *dstp,
+	 BUN cnt)
+{
+	enum simdpred pred;
+	BUN p = *pp, p0 = p;
+	oid *restrict dst = *dstp;
+
+	if (simdlevel == SIMD_NONE || (GDKdebug & NOSIMDMASK))
+		return cnt;
+	switch (ATOMbasetype(b->ttype)) {
+	case TYPE_bte:
+		SIMDCALL(bte);
+		break;
+	case TYPE_sht:
+		SIMDCALL(sht);
+		break;
+	case TYPE_int:
+		SIMDCALL(int);
+		break;
+	case TYPE_lng:
+		SIMDCALL(lng);
+		break;
+	case TYPE_flt:
+		SIMDCALL(flt);
+		break;
+	case TYPE_dbl:
+		SIMDCALL(dbl);
+		break;
+	default:
+		return cnt;
+	}
+	ALGODEBUG fprintf(stderr, "#BATselect(b=" ALGOBATFMT ",anti=%d): "
+			  "%s scan select of " BUNFMT " values\n",
+			  ALGOBATPAR(b), anti,
+			  simdlevel == SIMD_AVX2 ? "AVX2" : "SSE4.2",
+			  p - p0);
+	*pp = p;
+	*dstp = dst;
+	return cnt;
+}
+#endif
+
+/* Scan select using the zone map zm of b (see ZONEget for zoff):
+ * only the blocks whose minimum and maximum allow for values in the
+ * range [*tl, *th] are looked at.  The bounds are inclusive and not
+ * nil, i.e. the select has been normalized.  The qualifying oids of
+ * positions [p,q) of b are appended to the cnt oids in bn. */
+#define zonescanloop(TYPE)						\
+	do {								\
+		const TYPE *restrict src = (const TYPE *) Tloc(b, 0);	\
+		TYPE vl = *(const TYPE *) tl;				\
+		TYPE vh = *(const TYPE *) th;				\
+		for (; p < r; p++) {					\
+			if (src[p] >= vl && src[p] <= vh) {		\
+				buninsfix(bn, dst, cnt, (oid) (p + off), \
+					  cnt + 1024, maximum, BUN_NONE); \
+				cnt++;					\
+			}						\
+		}							\
+	} while (false)
+
+static BUN
+zonescan(BAT *b, BAT *bn, const void *tl, const void *th, bool equi,
+	 BUN p, BUN q, BUN cnt, lng off, BUN maximum,
+	 const Zonemap *zm, BUN zoff)
+{
+	oid *restrict dst = (oid *) Tloc(bn, 0);
+	BUN r, nvals = 0;
+
+	(void) equi;
+	while (ZONEnextrange(zm, zoff, &p, &r, q, tl, th)) {
+		nvals += r - p;
+#if defined(HAVE_X86_SIMD) && SIZEOF_OID == 8
+		if ((cnt = simdscan(b, bn, tl, th, equi, false, false,
+				    &p, r, off, &dst, cnt)) == BUN_NONE)
+			return BUN_NONE;
+#endif
+		switch (ATOMbasetype(b->ttype)) {
+		case TYPE_bte:
+			zonescanloop(bte);
+			break;
+		case TYPE_sht:
+			zonescanloop(sht);
+			break;
+		case TYPE_int:
+			zonescanloop(int);
+			break;
+		case TYPE_lng:
+			zonescanloop(lng);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			zonescanloop(hge);
+			break;
+#endif
+		case TYPE_flt:
+			zonescanloop(flt);
+			break;
+		case TYPE_dbl:
+			zonescanloop(dbl);
+			break;
+		default:
+			assert(0);
+			return BUN_NONE;
+		}
+	}
+	ALGODEBUG fprintf(stderr, "#BATselect(b=" ALGOBATFMT "): "
+			  "zone map scan of " BUNFMT " values\n",
+			  ALGOBATPAR(b), nvals);
+	return cnt;
+}
 
 
 static BAT *
@@ -850,6 +1307,9 @@ scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 	oid o, *restrict dst;
 	lng off;
 	const oid *candlist;
+	bool mask = false;
+	Zonemap *zm = NULL;
+	BUN zoff = 0;
 
 	assert(b != NULL);
 	assert(bn != NULL);
@@ -867,6 +1327,14 @@ scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 
 	assert(!lval || !hval || (*cmp)(tl, th) <= 0);
 
+	/* a range select over a range of positions can use the zone
+	 * map; we prefer existing imprints, but rather than building
+	 * imprints we use an existing zone map (it survives appends) */
+	if (!anti && !lnil && (s == NULL || (BATtdense(s) && !s->tmask)) &&
+	    !(use_imprints && BATcheckimprints(b)) &&
+	    (zm = ZONEget(b, false, &zoff)) != NULL)
+		use_imprints = false;
+
 	/* build imprints if they do not exist */
 	if (use_imprints && (BATimprints(b) != GDK_SUCCEED)) {
 		GDKclrerr();	/* not interested in BATimprints errors */
@@ -879,7 +1347,69 @@ scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 
 	t = ATOMbasetype(b->ttype);
 
-	if (s && !BATtdense(s)) {
+	if (s && s->tmask) {
+		/* only the fixed size scans iterate over the mask */
+		switch (t) {
+		case TYPE_bte:
+		case TYPE_sht:
+		case TYPE_int:
+		case TYPE_flt:
+		case TYPE_dbl:
+		case TYPE_lng:
+#ifdef HAVE_HGE
+		case TYPE_hge:
+#endif
+			mask = true;
+			break;
+		default:
+			if (BATcandmaterialize(s) != GDK_SUCCEED) {
+				BBPreclaim(bn);
+				return NULL;
+			}
+			break;
+		}
+	}
+
+	if (mask) {
+		/* iterate over the candidates of s that are in range
+		 * of b */
+		p = 0;
+		q = candmask_count(s->tmask, b->hseqbase,
+				   b->hseqbase + BATcount(b));
+		candlist = NULL;
+		/* note that the imprints code needs at least one
+		 * candidate */
+		switch (q == 0 ? TYPE_void : t) {
+		case TYPE_void:
+			break;
+		case TYPE_bte:
+			cnt = maskscan_bte(scanargs);
+			break;
+		case TYPE_sht:
+			cnt = maskscan_sht(scanargs);
+			break;
+		case TYPE_int:
+			cnt = maskscan_int(scanargs);
+			break;
+		case TYPE_flt:
+			cnt = maskscan_flt(scanargs);
+			break;
+		case TYPE_dbl:
+			cnt = maskscan_dbl(scanargs);
+			break;
+		case TYPE_lng:
+			cnt = maskscan_lng(scanargs);
+			break;
+#ifdef HAVE_HGE
+		case TYPE_hge:
+			cnt = maskscan_hge(scanargs);
+			break;
+#endif
+		default:
+			assert(0);
+			break;
+		}
+	} else if (s && !BATtdense(s)) {
 
 		assert(s->tsorted);
 		assert(s->tkey);
@@ -938,6 +1468,18 @@ scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 			q = BUNlast(b);
 		}
 		candlist = NULL;
+		if (zm != NULL) {
+			cnt = zonescan(b, bn, tl, th, equi, p, q, cnt, off,
+				       maximum, zm, zoff);
+			goto done;
+		}
+#if defined(HAVE_X86_SIMD) && SIZEOF_OID == 8
+		/* the scalar code does whatever is left */
+		if (!use_imprints &&
+		    (cnt = simdscan(b, bn, tl, th, equi, anti, lnil,
+				    &p, q, off, &dst, cnt)) == BUN_NONE)
+			return NULL;
+#endif
 		/* call type-specific core scan select function */
 		switch (t) {
 		case TYPE_bte:
@@ -971,6 +1513,7 @@ scanselect(BAT *b, BAT *s, BAT *bn, const void *tl, const void *th,
 			break;
 		}
 	}
+  done:
 	if (cnt == BUN_NONE) {
 		return NULL;
 	}
@@ -1390,8 +1933,11 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 				  ALGOBATPAR(b), ALGOOPTBATPAR(s), anti);
 		if (s) {
 			oid o = b->hseqbase + BATcount(b);
-			BUN q = SORTfndfirst(s, &o);
-			BUN p = SORTfndfirst(s, &b->hseqbase);
+			BUN q, p;
+			if (BATcandmaterialize(s) != GDK_SUCCEED)
+				return NULL;
+			q = SORTfndfirst(s, &o);
+			p = SORTfndfirst(s, &b->hseqbase);
 			return BATslice(s, p, q);
 		} else {
 			return BATdense(0, b->hseqbase, BATcount(b));
@@ -1526,6 +2072,10 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 		BUN low = 0;
 		BUN high = b->batCount;
 
+		/* binary search and slice s: needs the oids */
+		if (BATcandmaterialize(s) != GDK_SUCCEED)
+			return NULL;
+
 		if (BATtdense(b)) {
 			/* positional */
 			/* we expect nonil to be set, in which case we
@@ -1745,6 +2295,9 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 			maximum = MIN(maximum ,
 				      MIN(oh, s->tseqbase + BATcount(s))
 				      - MAX(ol, s->tseqbase));
+		} else if (s->tmask) {
+			maximum = MIN(maximum,
+				      candmask_count(s->tmask, ol, oh));
 		} else {
 			maximum = MIN(maximum,
 				      SORTfndfirst(s, &oh)
@@ -1791,6 +2344,7 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 		((b->batPersistence == PERSISTENT &&
 		  ATOMsize(b->ttype) >= sizeof(BUN) / 4 &&
 		  BATcount(b) * (ATOMsize(b->ttype) + 2 * sizeof(BUN)) < GDK_mem_maxsize / 2) ||
+		 BATcheckbhash(b) ||
 		 BATcheckhash(b));
 	if (equi && !hash && parent != 0) {
 		/* use parent hash if it already exists and if either
@@ -1800,16 +2354,19 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 		 * than to scan (cost for probe is average length of
 		 * hash chain (count divided by #slots) times the cost
 		 * to do a binary search on the candidate list (or 1
-		 * if no need for search)) */
+		 * if no need for search)); a bucketized hash is
+		 * always cheap enough to probe */
 		tmp = BBPquickdesc(parent, false);
-		hash = phash = BATcheckhash(tmp) &&
-			(BATcount(tmp) == BATcount(b) ||
-			 BATcount(tmp) / ((size_t *) tmp->thash->heap.base)[5] * (s && !BATtdense(s) ? ilog2(BATcount(s)) : 1) < (s ? BATcount(s) : BATcount(b)) ||
-			 HASHget(tmp->thash, HASHprobe(tmp->thash, tl)) == HASHnil(tmp->thash));
+		hash = phash = BATcheckbhash(tmp) ||
+			(BATcheckhash(tmp) &&
+			 (BATcount(tmp) == BATcount(b) ||
+			  BATcount(tmp) / ((size_t *) tmp->thash->heap.base)[5] * (s && !BATtdense(s) ? ilog2(BATcount(s)) : 1) < (s ? BATcount(s) : BATcount(b)) ||
+			  HASHget(tmp->thash, HASHprobe(tmp->thash, tl)) == HASHnil(tmp->thash)));
 	}
 	if (hash &&
 	    !phash && /* phash implies there is a hash table already */
 	    estimate == BUN_NONE &&
+	    !BATcheckbhash(b) &&
 	    !BATcheckhash(b)) {
 		/* no exact result size, but we need estimate to
 		 * choose between hash- & scan-select (if we already
@@ -1871,6 +2428,10 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 				  ",s=" ALGOOPTBATFMT "): "
 				  "hash select\n",
 				  ALGOBATPAR(b), ALGOOPTBATPAR(s));
+		if (BATcandmaterialize(s) != GDK_SUCCEED) {
+			BBPreclaim(bn);
+			return NULL;
+		}
 		bn = hashselect(b, s, bn, tl, maximum, phash);
 	} else {
 		/* use imprints if
@@ -1884,8 +2445,12 @@ BATselect(BAT *b, BAT *s, const void *tl, const void *th,
 			 (parent != 0 &&
 			  (tmp = BBPquickdesc(parent, false)) != NULL &&
 			  tmp->batPersistence == PERSISTENT));
+		BATadvise(b, MMAP_SEQUENTIAL);
 		bn = scanselect(b, s, bn, tl, th, li, hi, equi, anti,
 				lval, hval, lnil, maximum, use_imprints);
+		/* if b is cold, don't let it push hot BATs out of
+		 * memory */
+		BATadvise(b, MMAP_DONTNEED);
 	}
 
 	bn = virtualize(bn);
@@ -1988,6 +2553,8 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 	BAT *tmp;
 	bool use_orderidx = false;
 	oid ll, lh;
+	Zonemap *zm = NULL;
+	BUN zoff = 0;
 
 	assert(ATOMtype(l->ttype) == ATOMtype(rl->ttype));
 	assert(ATOMtype(l->ttype) == ATOMtype(rh->ttype));
@@ -2225,13 +2792,19 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 		     (tmp = BBPquickdesc(VIEWtparent(l), false)) != NULL &&
 		     tmp->batPersistence == PERSISTENT) ||
 		    BATcheckimprints(l)) &&
-		   BATimprints(l) == GDK_SUCCEED) {
-		/* implementation using imprints on left column
+		   ((lcand == NULL && !BATcheckimprints(l) &&
+		     (zm = ZONEget(l, true, &zoff)) != NULL) ||
+		    BATimprints(l) == GDK_SUCCEED)) {
+		/* implementation using a zone map or imprints on left
+		 * column
 		 *
-		 * we use imprints if we can (the type is right for
-		 * imprints) and either the left bat is persistent or
-		 * already has imprints, or the right bats are long
-		 * enough (for creating imprints being worth it) */
+		 * we use them if we can (the type is right) and either
+		 * the left bat is persistent or already has imprints,
+		 * or the right bats are long enough (for creating the
+		 * index being worth it); existing imprints are used,
+		 * otherwise, if there is no candidate list, we use the
+		 * zone map since it is much cheaper to create and it
+		 * is maintained when the left bat is appended to */
 		BUN maximum;
 
 		sorted = 2;
@@ -2296,7 +2869,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_bte(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2334,7 +2911,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_sht(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2385,7 +2966,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_int(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2436,7 +3021,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_lng(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2475,7 +3064,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_hge(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2516,7 +3109,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_flt(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -2556,7 +3153,11 @@ rangejoin(BAT *r1, BAT *r2, BAT *l, BAT *rl, BAT *rh, BAT *sl, BAT *sr, bool li,
 				}
 				if (vl > vh)
 					continue;
-				if (lcand)
+				if (zm)
+					ncnt = zonescan(l, r1, &vl, &vh, false,
+							lstart, lend, cnt, off,
+							cnt + maximum, zm, zoff);
+				else if (lcand)
 					ncnt = candscan_dbl(l, sl, r1, &vl, &vh,
 							    true, true, false,
 							    false, true, true,
@@ -286,6 +286,28 @@ GDKunlink(int farmid, const char *dir, const char *nme, const char *ext)
 	return GDK_FAIL;
 }
 
+/* Ask the OS to start reading file nme.extension into the file system
+ * cache in the background, so that loading the file later doesn't
+ * have to wait for the disk.  This is just a hint, so failures are
+ * ignored. */
+void
+GDKprefetch(int farmid, const char *nme, const char *extension)
+{
+#ifdef POSIX_FADV_WILLNEED
+	int fd;
+
+	if ((fd = GDKfdlocate(farmid, nme, "rb", extension)) < 0)
+		return;
+	IODEBUG fprintf(stderr, "#GDKprefetch(%s.%s)\n", nme, extension);
+	(void) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+#else
+	(void) farmid;
+	(void) nme;
+	(void) extension;
+#endif
+}
+
 /*
  * A move routine is overloaded to deal with extensions.
  */
@@ -768,11 +790,17 @@ BATsave(BAT *bd)
 	nme = BBP_physical(b->batCacheid);
 	if (b->batCopiedtodisk == 0 || b->batDirtydesc || b->theap.dirty)
 		if (err == GDK_SUCCEED && b->ttype)
-			err = HEAPsave(&b->theap, nme, "tail");
+			err = COMPsave(b, nme);
 	if (b->tvheap && (b->batCopiedtodisk == 0 || b->batDirtydesc || b->tvheap->dirty))
 		if (b->ttype && b->tvarsized) {
 			if (err == GDK_SUCCEED)
 				err = HEAPsave(b->tvheap, nme, "theap");
+			/* the dictionary must match the saved heap */
+			if (err == GDK_SUCCEED && b->tvheap->dict)
+				err = STRDICTsave(b->tvheap, nme);
+			else if (b->batCopiedtodisk &&
+				 ATOMstorage(b->ttype) == TYPE_str)
+				GDKunlink(b->tvheap->farmid, BATDIR, nme, "tdict");
 		}
 
 	if (b->tvheap)
@@ -807,7 +835,10 @@ BATload_intern(bat bid, bool lock)
 
 	/* LOAD bun heap */
 	if (b->ttype != TYPE_void) {
-		if (HEAPload(&b->theap, nme, "tail", b->batRestricted == BAT_READ) != GDK_SUCCEED) {
+		/* the tail may have been saved compressed */
+		if (COMPload(b, nme) != GDK_SUCCEED ||
+		    (b->theap.base == NULL &&
+		     HEAPload(&b->theap, nme, "tail", b->batRestricted == BAT_READ) != GDK_SUCCEED)) {
 			HEAPfree(&b->theap, false);
 			return NULL;
 		}
@@ -826,6 +857,7 @@ BATload_intern(bat bid, bool lock)
 		}
 		if (ATOMstorage(b->ttype) == TYPE_str) {
 			strCleanHash(b->tvheap, false);	/* ensure consistency */
+			STRDICTload(b->tvheap, nme);
 		} else {
 			HEAP_recover(b->tvheap, (const var_t *) Tloc(b, 0),
 				     BATcount(b));
@@ -873,7 +905,10 @@ BATdelete(BAT *b)
 		b = loaded;
 		HASHdestroy(b);
 		IMPSdestroy(b);
+		ZONEdestroy(b);
+		BHASHdestroy(b);
 		OIDXdestroy(b);
+		CANDMASKfree(b);
 	}
 	if (b->batCopiedtodisk || (b->theap.storage != STORE_MEM)) {
 		if (b->ttype != TYPE_void &&
@@ -886,6 +921,8 @@ BATdelete(BAT *b)
 	if (b->tvheap) {
 		assert(b->tvheap->parentid == bid);
 		if (b->batCopiedtodisk || (b->tvheap->storage != STORE_MEM)) {
+			if (b->batCopiedtodisk)
+				GDKunlink(b->tvheap->farmid, BATDIR, o, "tdict");
 			if (HEAPdelete(b->tvheap, o, "theap") != GDK_SUCCEED &&
 			    b->batCopiedtodisk)
 				IODEBUG fprintf(stderr, "#BATdelete(%s): tail heap\n", BATgetId(b));
@@ -0,0 +1,329 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2018 MonetDB B.V.
+ */
+
+/*
+ * String dictionaries.
+ *
+ * A string heap eliminates double strings using the hash table at
+ * the start of the heap only while the heap is smaller than
+ * GDK_ELIMLIMIT (see gdk_atoms.h).  When the heap grows past that
+ * limit, it gets a string dictionary: an open addressing hash table
+ * (linear probing) of the offsets of all strings in the heap, stored
+ * outside the heap.  With it, strPut keeps finding strings that are
+ * already present, so the heap stays fully duplicate eliminated at
+ * any size.  As a result, two strings in the heap are equal if and
+ * only if their offsets are, which selects, joins and grouping
+ * exploit (see GDK_ELIMALL).
+ *
+ * The dictionary is only created at the moment the heap crosses the
+ * limit, since only then do we know that the heap doesn't contain
+ * any double strings.  It is dropped when the heap gets modified in
+ * any other way than through strPut (or when we run out of memory),
+ * after which the heap is an ordinary large string heap.  With the
+ * gdk_strdict option set to auto, the dictionary is also dropped
+ * when it turns out that hardly any of the inserted strings were
+ * already present, since then it costs memory without saving any.
+ *
+ * For persistent BATs the dictionary is saved in a file with
+ * extension tdict next to the theap file.  The file starts with a
+ * header of STRDICT_HEADER_SIZE size_t values: the version, the free
+ * value of the heap that the dictionary covers, the number of slots,
+ * the number of strings, and a fingerprint of the end of the heap.
+ * When loaded, the dictionary is only used if it matches the heap.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define STRDICT_VERSION		1
+#define STRDICT_HEADER_SIZE	5
+#define STRDICT_MINSLOTS	((BUN) 1 << 12)
+
+static BUN
+STRDICThash(const Heap *h, var_t pos)
+{
+	BUN strhash;
+
+	if (h->hashash)
+		return ((const BUN *) (h->base + pos))[-1];
+	GDK_STRHASH(h->base + pos, strhash);
+	return strhash;
+}
+
+/* fingerprint of the last (at most) 256 bytes of the heap */
+static size_t
+STRDICTfingerprint(const Heap *h)
+{
+	size_t fp = h->free;
+	size_t i = h->free > 256 ? h->free - 256 : 0;
+
+	for (; i < h->free; i++)
+		fp = fp * 31 + (unsigned char) h->base[i];
+	return fp;
+}
+
+static StrDict *
+STRDICTnew(BUN nslots)
+{
+	StrDict *d;
+
+	if ((d = GDKzalloc(sizeof(StrDict))) == NULL)
+		return NULL;
+	d->base = GDKzalloc(STRDICT_HEADER_SIZE * SIZEOF_SIZE_T +
+			    nslots * sizeof(var_t));
+	if (d->base == NULL) {
+		GDKfree(d);
+		return NULL;
+	}
+	d->slots = (var_t *) (d->base + STRDICT_HEADER_SIZE);
+	d->mask = nslots - 1;
+	return d;
+}
+
+static void
+STRDICTdel(StrDict *d)
+{
+	GDKfree(d->base);
+	GDKfree(d);
+}
+
+/* return the offset of string v with hash value strhash in the heap,
+ * or 0 if it is not there */
+var_t
+STRDICTlocate(const Heap *h, const char *v, BUN strhash)
+{
+	const StrDict *d = h->dict;
+	BUN i;
+
+	for (i = strhash & d->mask; d->slots[i] != 0; i = (i + 1) & d->mask) {
+		var_t pos = d->slots[i];
+
+		if ((!h->hashash ||
+		     ((const BUN *) (h->base + pos))[-1] == strhash) &&
+		    GDK_STRCMP(v, h->base + pos) == 0)
+			return pos;
+	}
+	return 0;
+}
+
+static void
+STRDICTput(StrDict *d, var_t pos, BUN strhash)
+{
+	BUN i;
+
+	for (i = strhash & d->mask; d->slots[i] != 0; i = (i + 1) & d->mask)
+		;
+	d->slots[i] = pos;
+	d->count++;
+}
+
+/* add the string at offset pos with hash value strhash to the
+ * dictionary of h, which must not contain it yet; if the dictionary
+ * had to grow but couldn't, or is not worth keeping, it is dropped */
+void
+STRDICTinsert(Heap *h, var_t pos, BUN strhash)
+{
+	StrDict *d = h->dict, *nd;
+	BUN i;
+
+	if ((d->count + 1) * 2 > d->mask + 1) {
+		/* more than half full: double the number of slots */
+		if (GDK_strdict == 1 &&
+		    d->count >= STRDICT_MINSLOTS * 16 &&
+		    d->hits < d->puts / 8) {
+			/* hardly any duplicates: give up */
+			HEAPDEBUG fprintf(stderr, "#STRDICTinsert(%s): "
+					  "dropping dictionary, only "
+					  BUNFMT " of " BUNFMT " strings "
+					  "were found\n", h->filename,
+					  d->hits, d->puts);
+			STRDICTfree(h);
+			return;
+		}
+		if ((nd = STRDICTnew((d->mask + 1) * 2)) == NULL) {
+			GDKclrerr();
+			STRDICTfree(h);
+			return;
+		}
+		for (i = 0; i <= d->mask; i++)
+			if (d->slots[i] != 0)
+				STRDICTput(nd, d->slots[i],
+					   STRDICThash(h, d->slots[i]));
+		nd->puts = d->puts;
+		nd->hits = d->hits;
+		STRDICTdel(d);
+		h->dict = d = nd;
+	}
+	STRDICTput(d, pos, strhash);
+}
+
+/* create a dictionary of all strings in heap h; the heap layout is
+ * that of strPut: strings are preceded by a hash link while the heap
+ * is smaller than GDK_ELIMLIMIT, and are packed after that */
+gdk_return
+STRDICTcreate(Heap *h)
+{
+	const size_t extralen = h->hashash ? EXTRALEN : 0;
+	StrDict *d;
+	BUN nslots = STRDICT_MINSLOTS;
+	size_t pad, pos;
+	lng t0 = 0;
+
+	assert(h->dict == NULL);
+	HEAPDEBUG t0 = GDKusec();
+	/* a heap of this size has at most this many strings */
+	while (nslots < (h->free / GDK_VARALIGN) * 2)
+		nslots <<= 1;
+	if ((d = STRDICTnew(nslots)) == NULL)
+		return GDK_FAIL;
+	h->dict = d;
+	pos = GDK_STRHASHSIZE;
+	while (pos < h->free) {
+		BUN strhash;
+		const char *s;
+
+		pad = GDK_VARALIGN - (pos & (GDK_VARALIGN - 1));
+		if (pos < GDK_ELIMLIMIT) {
+			if (pad < sizeof(stridx_t))
+				pad += GDK_VARALIGN;
+		} else if (extralen == 0) {
+			pad = 0;
+		} else {
+			pad &= GDK_VARALIGN - 1;
+		}
+		pos += pad + extralen;
+		s = h->base + pos;
+		strhash = STRDICThash(h, pos);
+		if (STRDICTlocate(h, s, strhash) != 0) {
+			/* the heap is not duplicate free after all */
+			h->dict = NULL;
+			STRDICTdel(d);
+			GDKerror("STRDICTcreate: heap contains double strings\n");
+			return GDK_FAIL;
+		}
+		STRDICTput(d, (var_t) pos, strhash);
+		pos += GDK_STRLEN(s);
+	}
+	HEAPDEBUG fprintf(stderr, "#STRDICTcreate(%s): " BUNFMT " strings, "
+			  BUNFMT " slots (" LLFMT " usec)\n", h->filename,
+			  d->count, d->mask + 1, GDKusec() - t0);
+	return GDK_SUCCEED;
+}
+
+/* make dst, which has just been copied from src, share the contents
+ * (not the memory) of src's dictionary */
+gdk_return
+STRDICTcopy(Heap *dst, const Heap *src)
+{
+	const StrDict *d = src->dict;
+	StrDict *nd;
+
+	dst->dict = NULL;
+	if (d == NULL)
+		return GDK_SUCCEED;
+	if ((nd = STRDICTnew(d->mask + 1)) == NULL)
+		return GDK_FAIL;
+	memcpy(nd->slots, d->slots, (d->mask + 1) * sizeof(var_t));
+	nd->count = d->count;
+	dst->dict = nd;
+	return GDK_SUCCEED;
+}
+
+void
+STRDICTfree(Heap *h)
+{
+	if (h->dict) {
+		STRDICTdel(h->dict);
+		h->dict = NULL;
+	}
+}
+
+/* save the dictionary of heap h, which is saved as nme.theap */
+gdk_return
+STRDICTsave(Heap *h, const char *nme)
+{
+	StrDict *d = h->dict;
+
+	d->base[0] = STRDICT_VERSION;
+	d->base[1] = h->free;
+	d->base[2] = d->mask + 1;
+	d->base[3] = d->count;
+	d->base[4] = STRDICTfingerprint(h);
+	return GDKsave(h->farmid, nme, "tdict", d->base,
+		       STRDICT_HEADER_SIZE * SIZEOF_SIZE_T +
+		       (d->mask + 1) * sizeof(var_t),
+		       STORE_MEM, true);
+}
+
+/* load the dictionary of heap h, which was just loaded from
+ * nme.theap, if there is a dictionary that belongs to it */
+void
+STRDICTload(Heap *h, const char *nme)
+{
+	size_t hdata[STRDICT_HEADER_SIZE];
+	struct stat st;
+	StrDict *d;
+	BUN i, cnt;
+	int fd;
+
+	assert(h->dict == NULL);
+	if (GDK_ELIMDOUBLES(h) || GDK_strdict == 0 ||
+	    (fd = GDKfdlocate(h->farmid, nme, "rb", "tdict")) < 0) {
+		GDKclrerr();
+		return;
+	}
+	if (read(fd, hdata, sizeof(hdata)) != (ssize_t) sizeof(hdata) ||
+	    hdata[0] != STRDICT_VERSION ||
+	    hdata[1] != h->free ||
+	    hdata[2] < STRDICT_MINSLOTS ||
+	    (hdata[2] & (hdata[2] - 1)) != 0 ||
+	    hdata[3] * 2 > hdata[2] ||
+	    hdata[4] != STRDICTfingerprint(h) ||
+	    fstat(fd, &st) != 0 ||
+	    st.st_size != (off_t) (sizeof(hdata) + hdata[2] * sizeof(var_t)) ||
+	    (d = STRDICTnew((BUN) hdata[2])) == NULL) {
+		close(fd);
+		goto bailout;
+	}
+	for (i = 0; i < hdata[2]; i += cnt) {
+		ssize_t n;
+
+		cnt = MIN(hdata[2] - i, (BUN) 1 << 24);
+		n = read(fd, d->slots + i, cnt * sizeof(var_t));
+		if (n != (ssize_t) (cnt * sizeof(var_t)))
+			break;
+	}
+	close(fd);
+	if (i < hdata[2]) {
+		STRDICTdel(d);
+		goto bailout;
+	}
+	/* check that the slots point into the heap */
+	for (i = 0, cnt = 0; i < hdata[2]; i++) {
+		if (d->slots[i] == 0)
+			continue;
+		if (d->slots[i] < GDK_STRHASHSIZE || d->slots[i] >= h->free)
+			break;
+		cnt++;
+	}
+	if (i < hdata[2] || cnt != hdata[3]) {
+		STRDICTdel(d);
+		goto bailout;
+	}
+	d->count = cnt;
+	h->dict = d;
+	HEAPDEBUG fprintf(stderr, "#STRDICTload(%s): " BUNFMT " strings\n",
+			  h->filename, cnt);
+	return;
+
+  bailout:
+	/* unlink unusable file */
+	GDKunlink(h->farmid, BATDIR, nme, "tdict");
+	GDKclrerr();
+}
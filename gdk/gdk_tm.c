@@ -163,7 +163,8 @@ TMcommit(void)
  * which may require a lot of I/O.
  *
  * We expect the globally locked phase (BBPsync) to take little time
- * (<100ms) as only the BBP.dir is written out; and for the existing
+ * (<100ms) as only the entries of the subcommitted bats are written
+ * out (to BBP.dlt, see BBPdir_delta); and for the existing
  * bats that were modified, only some heap moves are done (moved from
  * BAKDIR to SUBDIR).  The atomic commit for sub-commit is the rename
  * of SUBDIR to DELDIR.
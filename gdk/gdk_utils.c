@@ -289,6 +289,10 @@ size_t GDK_mem_maxsize = GDK_VM_MAXSIZE;
 size_t GDK_vm_maxsize = GDK_VM_MAXSIZE;
 
 int GDK_vm_trim = 1;
+int GDK_radixjoin = 1;		/* 0: never, 1: automatic, 2: always */
+int GDK_strdict = 1;		/* 0: never, 1: automatic, 2: always */
+int GDK_compress = 0;		/* 0: never, 1: when it saves space */
+int GDK_commit_delay = 0;	/* max wait (ms) for a group commit */
 
 #define SEG_SIZE(x,y)	((x)+(((x)&((1<<(y))-1))?(1<<(y))-((x)&((1<<(y))-1)):0))
 
@@ -577,6 +581,42 @@ GDKinit(opt *set, int setlen)
 			     * two */
 			    (GDK_mmap_pagesize & (GDK_mmap_pagesize - 1)) != 0)
 				GDKfatal("GDKinit: gdk_mmap_pagesize must be power of 2 between 2**12 and 2**20\n");
+		} else if (strcmp("gdk_radixjoin", n[i].name) == 0) {
+			if (strcmp(n[i].value, "no") == 0)
+				GDK_radixjoin = 0;
+			else if (strcmp(n[i].value, "yes") == 0)
+				GDK_radixjoin = 2;
+			else if (strcmp(n[i].value, "auto") == 0)
+				GDK_radixjoin = 1;
+			else
+				GDKfatal("GDKinit: gdk_radixjoin must be one of yes, no, or auto\n");
+		} else if (strcmp("gdk_strdict", n[i].name) == 0) {
+			if (strcmp(n[i].value, "no") == 0)
+				GDK_strdict = 0;
+			else if (strcmp(n[i].value, "yes") == 0)
+				GDK_strdict = 2;
+			else if (strcmp(n[i].value, "auto") == 0)
+				GDK_strdict = 1;
+			else
+				GDKfatal("GDKinit: gdk_strdict must be one of yes, no, or auto\n");
+		} else if (strcmp("gdk_compress", n[i].name) == 0) {
+			if (strcmp(n[i].value, "no") == 0)
+				GDK_compress = 0;
+			else if (strcmp(n[i].value, "yes") == 0)
+				GDK_compress = 1;
+			else
+				GDKfatal("GDKinit: gdk_compress must be one of yes or no\n");
+		} else if (strcmp("gdk_commit_delay", n[i].name) == 0) {
+			GDK_commit_delay = (int) strtol(n[i].value, NULL, 10);
+			if (GDK_commit_delay < 0 || GDK_commit_delay > 1000)
+				GDKfatal("GDKinit: gdk_commit_delay must be between 0 and 1000\n");
+		} else if (strcmp("gdk_vmtrim", n[i].name) == 0) {
+			if (strcmp(n[i].value, "no") == 0)
+				GDK_vm_trim = 0;
+			else if (strcmp(n[i].value, "yes") == 0)
+				GDK_vm_trim = 1;
+			else
+				GDKfatal("GDKinit: gdk_vmtrim must be one of yes or no\n");
 		}
 	}
 
@@ -599,6 +639,7 @@ GDKinit(opt *set, int setlen)
 	GDKnr_threads = GDKgetenv_int("gdk_nr_threads", 0);
 	if (GDKnr_threads == 0)
 		GDKnr_threads = MT_check_nr_cores();
+	SELECTinit();
 
 	if ((p = GDKgetenv("gdk_dbpath")) != NULL &&
 	    (p = strrchr(p, DIR_SEP)) != NULL) {
@@ -0,0 +1,391 @@
+/*
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0.  If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Copyright 1997 - July 2008 CWI, August 2008 - 2018 MonetDB B.V.
+ */
+
+/*
+ * Implementation of zone maps.
+ *
+ * For each block of one cache line worth of values of a fixed size
+ * column, the zone map records the smallest and the largest non-nil
+ * value in the block.  A block without non-nil values gets the
+ * largest value of the domain as minimum and the smallest as maximum,
+ * so that it does not overlap with any range.  A scan for values in
+ * a range only needs to look at the blocks whose [min, max] interval
+ * overlaps with the range, which makes it effective on columns with
+ * clustered values, such as time series that are appended in
+ * (roughly) chronological order.
+ *
+ * The zone map lives in memory only.  Appends do not invalidate it:
+ * when it is requested, the values appended since it was last used
+ * are added to it.  Any other change to the column destroys it.  The
+ * zone map is protected by the imprints lock of the BAT, and for a
+ * view the zone map of the parent is used.
+ */
+
+#include "monetdb_config.h"
+#include "gdk.h"
+#include "gdk_private.h"
+
+#define ZONE_BLOCKSHIFT	6	/* log2 of the block size in bytes */
+
+static bool
+ZONEsupported(int tpe)
+{
+	switch (ATOMbasetype(tpe)) {
+	case TYPE_bte:
+	case TYPE_sht:
+	case TYPE_int:
+	case TYPE_lng:
+#ifdef HAVE_HGE
+	case TYPE_hge:
+#endif
+	case TYPE_flt:
+	case TYPE_dbl:
+		return true;
+	default:
+		return false;
+	}
+}
+
+#define ZONEcompute(TYPE)						\
+	do {								\
+		const TYPE *restrict src = (const TYPE *) Tloc(b, 0);	\
+		TYPE *restrict mn = (TYPE *) zm->min;			\
+		TYPE *restrict mx = (TYPE *) zm->max;			\
+		for (blk = first; blk < nblocks; blk++) {		\
+			TYPE lo = GDK_##TYPE##_max;			\
+			TYPE hi = GDK_##TYPE##_min;			\
+			BUN p = blk << zm->shift;			\
+			BUN q = MIN(p + ((BUN) 1 << zm->shift), cnt);	\
+			for (; p < q; p++) {				\
+				if (is_##TYPE##_nil(src[p]))		\
+					continue;			\
+				if (src[p] < lo)			\
+					lo = src[p];			\
+				if (src[p] > hi)			\
+					hi = src[p];			\
+			}						\
+			mn[blk] = lo;					\
+			mx[blk] = hi;					\
+		}							\
+	} while (false)
+
+/* add the values of b that are not covered yet to the zone map; the
+ * last block is recalculated since it may have been incomplete */
+static gdk_return
+ZONEupdate(Zonemap *zm, BAT *b)
+{
+	BUN cnt = BATcount(b);
+	BUN nblocks = (cnt + ((BUN) 1 << zm->shift) - 1) >> zm->shift;
+	BUN first = MIN(zm->count, cnt) >> zm->shift;
+	BUN blk;
+
+	if (nblocks > zm->capacity) {
+		size_t width = ATOMsize(zm->type);
+		BUN cap = MAX(nblocks, zm->capacity + zm->capacity / 4);
+		void *p;
+
+		if ((p = GDKrealloc(zm->min, cap * width)) == NULL)
+			return GDK_FAIL;
+		zm->min = p;
+		if ((p = GDKrealloc(zm->max, cap * width)) == NULL)
+			return GDK_FAIL;
+		zm->max = p;
+		zm->capacity = cap;
+	}
+	switch (zm->type) {
+	case TYPE_bte:
+		ZONEcompute(bte);
+		break;
+	case TYPE_sht:
+		ZONEcompute(sht);
+		break;
+	case TYPE_int:
+		ZONEcompute(int);
+		break;
+	case TYPE_lng:
+		ZONEcompute(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ZONEcompute(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ZONEcompute(flt);
+		break;
+	case TYPE_dbl:
+		ZONEcompute(dbl);
+		break;
+	default:
+		assert(0);
+	}
+	zm->count = cnt;
+	zm->nblocks = nblocks;
+	return GDK_SUCCEED;
+}
+
+static void
+ZONEfree(Zonemap *zm)
+{
+	GDKfree(zm->min);
+	GDKfree(zm->max);
+	GDKfree(zm);
+}
+
+/* Return the zone map covering the values of b, creating it if it
+ * doesn't exist yet and create is set, or NULL if there is none (or
+ * it could not be created).  The zone map is brought up to date with
+ * the values appended to b since it was last used.  If b is a view,
+ * the zone map of its parent is returned, and *offp is set to the
+ * position of b's first value in the parent. */
+Zonemap *
+ZONEget(BAT *b, bool create, BUN *offp)
+{
+	BAT *pb = b;
+	Zonemap *zm;
+	lng t0 = 0;
+
+	if (!ZONEsupported(b->ttype))
+		return NULL;
+	if (VIEWtparent(b)) {
+		assert(b->tzonemap == NULL);
+		pb = BBPdescriptor(VIEWtparent(b));
+	}
+	*offp = (BUN) (((const char *) Tloc(b, 0) - (const char *) Tloc(pb, 0)) >> b->tshift);
+
+	MT_lock_set(&GDKimprintsLock(pb->batCacheid));
+	if ((zm = pb->tzonemap) == NULL && create) {
+		if ((zm = GDKzalloc(sizeof(Zonemap))) != NULL) {
+			zm->type = ATOMbasetype(pb->ttype);
+			zm->shift = ZONE_BLOCKSHIFT - pb->tshift;
+			pb->tzonemap = zm;
+		}
+	}
+	if (zm != NULL && zm->count != BATcount(pb)) {
+		BUN ocnt = zm->count;
+
+		ALGODEBUG t0 = GDKusec();
+		if (ZONEupdate(zm, pb) != GDK_SUCCEED) {
+			pb->tzonemap = NULL;
+			ZONEfree(zm);
+			zm = NULL;
+		} else {
+			ALGODEBUG fprintf(stderr, "#ZONEget(" ALGOBATFMT "): "
+					  "zone map of " BUNFMT " blocks, "
+					  "added " BUNFMT " values "
+					  "(" LLFMT " usec)\n", ALGOBATPAR(pb),
+					  zm->nblocks, zm->count - MIN(ocnt, zm->count),
+					  GDKusec() - t0);
+		}
+	}
+	MT_lock_unset(&GDKimprintsLock(pb->batCacheid));
+	if (zm == NULL)
+		GDKclrerr();	/* we can do without */
+	return zm;
+}
+
+/* Create a zone map for b (which must not be a view) with blocks of
+ * 1 << shift values whose minima and maxima are filled in by the
+ * caller, and install it.  This is used to turn the block headers of
+ * a compressed heap into a zone map (see gdk_compress.c). */
+Zonemap *
+ZONEnew(BAT *b, int shift)
+{
+	Zonemap *zm;
+	BUN cnt = BATcount(b);
+	BUN nblocks = (cnt + ((BUN) 1 << shift) - 1) >> shift;
+	size_t width = ATOMsize(b->ttype);
+
+	assert(!VIEWtparent(b));
+	if (!ZONEsupported(b->ttype) || nblocks == 0)
+		return NULL;
+	if ((zm = GDKzalloc(sizeof(Zonemap))) == NULL)
+		return NULL;
+	zm->type = ATOMbasetype(b->ttype);
+	zm->shift = shift;
+	zm->count = cnt;
+	zm->nblocks = zm->capacity = nblocks;
+	zm->min = GDKmalloc(nblocks * width);
+	zm->max = GDKmalloc(nblocks * width);
+	if (zm->min == NULL || zm->max == NULL) {
+		ZONEfree(zm);
+		return NULL;
+	}
+	MT_lock_set(&GDKimprintsLock(b->batCacheid));
+	if (b->tzonemap)
+		ZONEfree(b->tzonemap);
+	b->tzonemap = zm;
+	MT_lock_unset(&GDKimprintsLock(b->batCacheid));
+	return zm;
+}
+
+#define ZONEbest(TYPE)							\
+	do {								\
+		const TYPE *restrict mn = (const TYPE *) zm->min;	\
+		const TYPE *restrict mx = (const TYPE *) zm->max;	\
+		for (blk = 0; blk < zm->nblocks; blk++) {		\
+			if (mn[blk] > mx[blk])				\
+				continue; /* only nils */		\
+			if (best == BUN_NONE ||				\
+			    (max ? mx[blk] > mx[best] : mn[blk] < mn[best])) \
+				best = blk;				\
+		}							\
+	} while (false)
+
+/* If b has a zone map, set [*startp, *endp) to the block of b that
+ * contains the first occurrence of the smallest (or, if max is set,
+ * the largest) non-nil value of b, or to an empty range if there are
+ * only nils, and return true.  Return false if b has no zone map. */
+bool
+ZONEminmax(BAT *b, bool max, BUN *startp, BUN *endp)
+{
+	Zonemap *zm;
+	BUN off, blk, best = BUN_NONE;
+
+	if (VIEWtparent(b) || b->tzonemap == NULL ||
+	    (zm = ZONEget(b, false, &off)) == NULL)
+		return false;
+	switch (zm->type) {
+	case TYPE_bte:
+		ZONEbest(bte);
+		break;
+	case TYPE_sht:
+		ZONEbest(sht);
+		break;
+	case TYPE_int:
+		ZONEbest(int);
+		break;
+	case TYPE_lng:
+		ZONEbest(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ZONEbest(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ZONEbest(flt);
+		break;
+	case TYPE_dbl:
+		ZONEbest(dbl);
+		break;
+	default:
+		assert(0);
+		return false;
+	}
+	if (best == BUN_NONE) {
+		*startp = *endp = 0;
+	} else {
+		*startp = best << zm->shift;
+		*endp = MIN((best + 1) << zm->shift, BATcount(b));
+	}
+	return true;
+}
+
+#define ZONEnext(TYPE)							\
+	do {								\
+		const TYPE *restrict mn = (const TYPE *) zm->min;	\
+		const TYPE *restrict mx = (const TYPE *) zm->max;	\
+		TYPE vl = lo ? *(const TYPE *) lo : 0;			\
+		TYPE vh = hi ? *(const TYPE *) hi : 0;			\
+		for (; blk < end; blk++)				\
+			if ((lo == NULL || mx[blk] >= vl) &&		\
+			    (hi == NULL || mn[blk] <= vh))		\
+				break;					\
+		for (run = blk; run < end; run++)			\
+			if ((lo != NULL && mx[run] < vl) ||		\
+			    (hi != NULL && mn[run] > vh))		\
+				break;					\
+	} while (false)
+
+/* Find the first run of positions in [*pp, q) that lie in blocks
+ * that may contain values in the inclusive range [*lo, *hi], where a
+ * NULL bound means no bound, and the bounds are of the type of the
+ * column.  The zone map covers the values starting at position off
+ * (see ZONEget).  The run is returned in [*pp, *qp).  Returns false
+ * if there are no such positions. */
+bool
+ZONEnextrange(const Zonemap *zm, BUN off, BUN *pp, BUN *qp, BUN q,
+	      const void *lo, const void *hi)
+{
+	BUN p = *pp, blk, end, run = 0;
+
+	if (p >= q)
+		return false;
+	blk = (p + off) >> zm->shift;
+	end = ((q - 1 + off) >> zm->shift) + 1;
+	assert(end <= zm->nblocks);
+	switch (zm->type) {
+	case TYPE_bte:
+		ZONEnext(bte);
+		break;
+	case TYPE_sht:
+		ZONEnext(sht);
+		break;
+	case TYPE_int:
+		ZONEnext(int);
+		break;
+	case TYPE_lng:
+		ZONEnext(lng);
+		break;
+#ifdef HAVE_HGE
+	case TYPE_hge:
+		ZONEnext(hge);
+		break;
+#endif
+	case TYPE_flt:
+		ZONEnext(flt);
+		break;
+	case TYPE_dbl:
+		ZONEnext(dbl);
+		break;
+	default:
+		assert(0);
+		return false;
+	}
+	if (blk == end)
+		return false;
+	blk <<= zm->shift;
+	run <<= zm->shift;
+	if (blk > p + off)
+		*pp = blk - off;
+	*qp = MIN(run - off, q);
+	return true;
+}
+
+gdk_return
+BATzonemap(BAT *b)
+{
+	BUN off;
+
+	BATcheck(b, "BATzonemap", GDK_FAIL);
+	if (!ZONEsupported(b->ttype)) {
+		GDKerror("BATzonemap: type not supported.\n");
+		return GDK_FAIL;
+	}
+	if (ZONEget(b, true, &off) == NULL) {
+		GDKerror("BATzonemap: cannot allocate zone map.\n");
+		return GDK_FAIL;
+	}
+	return GDK_SUCCEED;
+}
+
+void
+ZONEdestroy(BAT *b)
+{
+	Zonemap *zm;
+
+	if (b && b->tzonemap) {
+		MT_lock_set(&GDKimprintsLock(b->batCacheid));
+		zm = b->tzonemap;
+		b->tzonemap = NULL;
+		MT_lock_unset(&GDKimprintsLock(b->batCacheid));
+		if (zm)
+			ZONEfree(zm);
+	}
+}
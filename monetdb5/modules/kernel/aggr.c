@@ -9,6 +9,7 @@
 #include "monetdb_config.h"
 #include "mal.h"
 #include "mal_exception.h"
+#include "mal_interpreter.h"
 
 /*
  * grouped aggregates
@@ -1041,3 +1042,98 @@ AGGRsubstr_group_concatcand_sep(bat *retval, const bat *bid, const bat *sepp, co
 	BBPunfix(sep->batCacheid);
 	return msg;
 }
+
+/*
+ * Several grouped aggregates of the same column in one pass.  The
+ * arguments after the flags name the aggregate that is to be
+ * calculated for each of the results, in order.
+ */
+static const char *const AGGRnames[] = {"sum", "count", "min", "max", "avg"};
+#define NAGGRS (sizeof(AGGRnames) / sizeof(AGGRnames[0]))
+
+mal_export str AGGRsubaggrs(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+str
+AGGRsubaggrs(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	BAT *b, *g, *e, *s = NULL, *res[NAGGRS] = {NULL};
+	int slot[NAGGRS], aggr[NAGGRS];
+	int i, sumtp = TYPE_lng, first = pci->retc + 5;
+	size_t k;
+	bool want[NAGGRS] = {false};
+	bit skip_nils, abort_on_error;
+	bat sid = bat_nil;
+	gdk_return rc;
+
+	(void) cntxt;
+	if (isaBatType(getArgType(mb, pci, pci->retc + 3))) {
+		/* with candidate list */
+		sid = *getArgReference_bat(stk, pci, pci->retc + 3);
+		first++;
+	}
+	if (pci->argc - first != pci->retc || pci->retc > (int) NAGGRS)
+		throw(MAL, "aggr.subaggrs", ILLEGAL_ARGUMENT ": one aggregate per result expected");
+	for (i = 0; i < pci->retc; i++) {
+		const char *name = *getArgReference_str(stk, pci, first + i);
+		int tp = getBatType(getArgType(mb, pci, i));
+
+		for (k = 0; k < NAGGRS; k++)
+			if (name && strcmp(name, AGGRnames[k]) == 0)
+				break;
+		if (k == NAGGRS || want[k])
+			throw(MAL, "aggr.subaggrs", ILLEGAL_ARGUMENT ": unknown or duplicate aggregate %s", name ? name : "nil");
+		if ((k == 1 && tp != TYPE_lng) || (k == 4 && tp != TYPE_dbl))
+			throw(MAL, "aggr.subaggrs", SEMANTIC_TYPE_MISMATCH);
+		if (k == 0)
+			sumtp = tp;
+		want[k] = true;
+		slot[k] = i;
+		aggr[i] = (int) k;
+	}
+	skip_nils = *getArgReference_bit(stk, pci, first - 2);
+	abort_on_error = *getArgReference_bit(stk, pci, first - 1);
+
+	b = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc));
+	g = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc + 1));
+	e = BATdescriptor(*getArgReference_bat(stk, pci, pci->retc + 2));
+	if (!is_bat_nil(sid))
+		s = BATdescriptor(sid);
+	if (b == NULL || g == NULL || e == NULL || (!is_bat_nil(sid) && s == NULL)) {
+		if (b)
+			BBPunfix(b->batCacheid);
+		if (g)
+			BBPunfix(g->batCacheid);
+		if (e)
+			BBPunfix(e->batCacheid);
+		if (s)
+			BBPunfix(s->batCacheid);
+		throw(MAL, "aggr.subaggrs", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if ((want[2] && getBatType(getArgType(mb, pci, slot[2])) != b->ttype) ||
+		(want[3] && getBatType(getArgType(mb, pci, slot[3])) != b->ttype)) {
+		BBPunfix(b->batCacheid);
+		BBPunfix(g->batCacheid);
+		BBPunfix(e->batCacheid);
+		if (s)
+			BBPunfix(s->batCacheid);
+		throw(MAL, "aggr.subaggrs", SEMANTIC_TYPE_MISMATCH);
+	}
+	rc = BATgroupaggrs(want[0] ? &res[0] : NULL, sumtp,
+					   want[1] ? &res[1] : NULL,
+					   want[2] ? &res[2] : NULL,
+					   want[3] ? &res[3] : NULL,
+					   want[4] ? &res[4] : NULL,
+					   b, g, e, s, skip_nils, abort_on_error);
+	BBPunfix(b->batCacheid);
+	BBPunfix(g->batCacheid);
+	BBPunfix(e->batCacheid);
+	if (s)
+		BBPunfix(s->batCacheid);
+	if (rc != GDK_SUCCEED)
+		throw(MAL, "aggr.subaggrs", GDK_EXCEPTION);
+	for (i = 0; i < pci->retc; i++) {
+		BAT *bn = res[aggr[i]];
+		*getArgReference_bat(stk, pci, i) = bn->batCacheid;
+		BBPkeepref(bn->batCacheid);
+	}
+	return MAL_SUCCEED;
+}
@@ -290,4 +290,12 @@ comment "Grouped string concat with custom separator";
 command substr_group_concat(b:bat[:str],sep:bat[:str],g:bat[:oid],e:bat[:any_1],s:bat[:oid],skip_nils:bit,abort_on_error:bit) :bat[:str]
 address AGGRsubstr_group_concatcand_sep
 comment "Grouped string concat with candidates list with custom separator";
+
+pattern subaggrs(b:bat[:any_1],g:bat[:oid],e:bat[:any_2],skip_nils:bit,abort_on_error:bit,aggr:str...) :bat[:any]...
+address AGGRsubaggrs
+comment "Grouped sum, count, min, max and/or avg aggregates in one pass, named in the order of the results";
+
+pattern subaggrs(b:bat[:any_1],g:bat[:oid],e:bat[:any_2],s:bat[:oid],skip_nils:bit,abort_on_error:bit,aggr:str...) :bat[:any]...
+address AGGRsubaggrs
+comment "Grouped sum, count, min, max and/or avg aggregates in one pass with candidates list, named in the order of the results";
 EOF
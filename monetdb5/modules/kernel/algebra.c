@@ -240,7 +240,8 @@ ALGselect2(bat *result, const bat *bid, const bat *sid, const void *low, const v
 	if ((b = BATdescriptor(*bid)) == NULL) {
 		throw(MAL, "algebra.select", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
-	if (sid && !is_bat_nil(*sid) && (s = BATdescriptor(*sid)) == NULL) {
+	/* BATselect knows about compressed candidate lists */
+	if (sid && !is_bat_nil(*sid) && (s = BATcanddescriptor(*sid)) == NULL) {
 		BBPunfix(b->batCacheid);
 		throw(MAL, "algebra.select", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
@@ -259,6 +260,7 @@ ALGselect2(bat *result, const bat *bid, const bat *sid, const void *low, const v
 		BBPunfix(s->batCacheid);
 	if (bn == NULL)
 		throw(MAL, "algebra.select", GDK_EXCEPTION);
+	BATcandcompress(bn);
 	*result = bn->batCacheid;
 	BBPkeepref(bn->batCacheid);
 	return MAL_SUCCEED;
@@ -278,7 +280,7 @@ ALGthetaselect2(bat *result, const bat *bid, const bat *sid, const void *val, co
 	if ((b = BATdescriptor(*bid)) == NULL) {
 		throw(MAL, "algebra.thetaselect", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
-	if (sid && !is_bat_nil(*sid) && (s = BATdescriptor(*sid)) == NULL) {
+	if (sid && !is_bat_nil(*sid) && (s = BATcanddescriptor(*sid)) == NULL) {
 		BBPunfix(b->batCacheid);
 		throw(MAL, "algebra.thetaselect", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
@@ -289,6 +291,7 @@ ALGthetaselect2(bat *result, const bat *bid, const bat *sid, const void *val, co
 		BBPunfix(s->batCacheid);
 	if (bn == NULL)
 		throw(MAL, "algebra.select", GDK_EXCEPTION);
+	BATcandcompress(bn);
 	*result = bn->batCacheid;
 	BBPkeepref(bn->batCacheid);
 	return MAL_SUCCEED;
@@ -577,6 +580,72 @@ ALGfirstn(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
 	return MAL_SUCCEED;
 }
 
+/* algebra.firstnkeys([s,] n, b1, asc1, b2, asc2, ...) */
+str
+ALGfirstnkeys(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci)
+{
+	bat *ret = getArgReference_bat(stk, pci, 0);
+	BAT **bats = NULL, *s = NULL, *bn;
+	bool *asc = NULL;
+	int i, k, nkeys, first = pci->retc;
+	lng n;
+	gdk_return rc;
+	str msg = MAL_SUCCEED;
+
+	(void) cntxt;
+
+	if (isaBatType(getArgType(mb, pci, first))) {
+		bat sid = *getArgReference_bat(stk, pci, first);
+		if (!is_bat_nil(sid) &&
+		    (s = BATdescriptor(sid)) == NULL)
+			throw(MAL, "algebra.firstnkeys", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+		first++;
+	}
+	n = *getArgReference_lng(stk, pci, first);
+	first++;
+	nkeys = (pci->argc - first) / 2;
+	if (n < 0 || (lng) n >= (lng) BUN_MAX || nkeys == 0 ||
+	    (pci->argc - first) % 2 != 0) {
+		msg = createException(MAL, "algebra.firstnkeys", ILLEGAL_ARGUMENT);
+		goto bailout;
+	}
+	bats = GDKzalloc(nkeys * sizeof(BAT *));
+	asc = GDKmalloc(nkeys * sizeof(bool));
+	if (bats == NULL || asc == NULL) {
+		msg = createException(MAL, "algebra.firstnkeys", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+		goto bailout;
+	}
+	for (i = 0, k = first; i < nkeys; i++, k += 2) {
+		if (!isaBatType(getArgType(mb, pci, k)) ||
+		    getArgType(mb, pci, k + 1) != TYPE_bit) {
+			msg = createException(MAL, "algebra.firstnkeys", SEMANTIC_TYPE_MISMATCH);
+			goto bailout;
+		}
+		if ((bats[i] = BATdescriptor(*getArgReference_bat(stk, pci, k))) == NULL) {
+			msg = createException(MAL, "algebra.firstnkeys", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+			goto bailout;
+		}
+		asc[i] = *getArgReference_bit(stk, pci, k + 1) != 0;
+	}
+	rc = BATfirstnkeys(&bn, bats, asc, nkeys, s, (BUN) n);
+	if (rc != GDK_SUCCEED) {
+		msg = createException(MAL, "algebra.firstnkeys", GDK_EXCEPTION);
+		goto bailout;
+	}
+	BBPkeepref(*ret = bn->batCacheid);
+  bailout:
+	if (bats) {
+		for (i = 0; i < nkeys; i++)
+			if (bats[i])
+				BBPunfix(bats[i]->batCacheid);
+		GDKfree(bats);
+	}
+	GDKfree(asc);
+	if (s)
+		BBPunfix(s->batCacheid);
+	return msg;
+}
+
 static str
 ALGunary(bat *result, const bat *bid, BAT *(*func)(BAT *), const char *name)
 {
@@ -683,7 +752,24 @@ ALGcrossproduct2( bat *l, bat *r, const bat *left, const bat *right)
 str
 ALGprojection(bat *result, const bat *lid, const bat *rid)
 {
-	return ALGbinary(result, lid, rid, BATproject, "algebra.projection");
+	BAT *left, *right, *bn;
+
+	/* BATproject knows about compressed candidate lists */
+	if ((left = BATcanddescriptor(*lid)) == NULL) {
+		throw(MAL, "algebra.projection", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	if ((right = BATdescriptor(*rid)) == NULL) {
+		BBPunfix(left->batCacheid);
+		throw(MAL, "algebra.projection", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	bn = BATproject(left, right);
+	BBPunfix(left->batCacheid);
+	BBPunfix(right->batCacheid);
+	if (bn == NULL)
+		throw(MAL, "algebra.projection", GDK_EXCEPTION);
+	*result = bn->batCacheid;
+	BBPkeepref(*result);
+	return MAL_SUCCEED;
 }
 
 str
@@ -782,7 +868,8 @@ ALGcount_bat(lng *result, const bat *bid)
 {
 	BAT *b;
 
-	if ((b = BATdescriptor(*bid)) == NULL) {
+	/* only the count is needed: don't materialize candidates */
+	if ((b = BATcanddescriptor(*bid)) == NULL) {
 		throw(MAL, "aggr.count", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
 	*result = (lng) BATcount(b);
@@ -822,14 +909,14 @@ ALGcountCND_bat(lng *result, const bat *bid, const bat *cnd)
 	BAT *b;
 
 	if ( *cnd) {
-		if ((b = BATdescriptor(*cnd)) == NULL) {
+		if ((b = BATcanddescriptor(*cnd)) == NULL) {
 			throw(MAL, "aggr.count", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 		}		
 		*result = (lng) BATcount(b);
 		BBPunfix(b->batCacheid);
 		return MAL_SUCCEED;
 	}
-	if ((b = BATdescriptor(*bid)) == NULL) {
+	if ((b = BATcanddescriptor(*bid)) == NULL) {
 		throw(MAL, "aggr.count", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 	}
 	*result = (lng) BATcount(b);
@@ -850,7 +937,7 @@ ALGcountCND_nil(lng *result, const bat *bid, const bat *cnd, const bit *ignore_n
 		cnt = BATcount_no_nil(b);
 	} else{
 		if ( *cnd) {
-			if ((b = BATdescriptor(*cnd)) == NULL) {
+			if ((b = BATcanddescriptor(*cnd)) == NULL) {
 				throw(MAL, "aggr.count", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
 			}		
 			*result = (lng) BATcount(b);
@@ -42,6 +42,7 @@ mal_export str ALGcrossproduct2(bat *l, bat *r, const bat *lid, const bat *rid);
 /* end legacy join functions */
 
 mal_export str ALGfirstn(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
+mal_export str ALGfirstnkeys(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 
 mal_export str ALGcopy(bat *result, const bat *bid);
 mal_export str ALGunique2(bat *result, const bat *bid, const bat *sid);
@@ -986,6 +986,20 @@ BKCsetHash(bit *ret, const bat *bid)
 	return MAL_SUCCEED;
 }
 
+str
+BKCsetBucketHash(bit *ret, const bat *bid)
+{
+	BAT *b;
+
+	(void) ret;
+	if ((b = BATdescriptor(*bid)) == NULL) {
+		throw(MAL, "bat.setBucketHash", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	*ret = BATbhash(b) == GDK_SUCCEED;
+	BBPunfix(b->batCacheid);
+	return MAL_SUCCEED;
+}
+
 str
 BKCsetImprints(bit *ret, const bat *bid)
 {
@@ -1000,6 +1014,20 @@ BKCsetImprints(bit *ret, const bat *bid)
 	return MAL_SUCCEED;
 }
 
+str
+BKCsetZonemap(bit *ret, const bat *bid)
+{
+	BAT *b;
+
+	(void) ret;
+	if ((b = BATdescriptor(*bid)) == NULL) {
+		throw(MAL, "bat.setZonemap", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	*ret = BATzonemap(b) == GDK_SUCCEED;
+	BBPunfix(b->batCacheid);
+	return MAL_SUCCEED;
+}
+
 str
 BKCgetSequenceBase(oid *r, const bat *bid)
 {
@@ -394,3 +394,320 @@ MBMskewed(bat *ret, oid *base, lng *size, int *domain, int *skew){
 	} else throw(MAL, "microbenchmark.skewed", OPERATION_FAILED);
 	return MAL_SUCCEED;
 }
+
+/*
+ * @- Index Construction
+ * Time the construction of the hash or order index of a BAT with a
+ * given number of threads, and check that a parallel build yields
+ * exactly the same index as a serial one.
+ */
+static str
+MBMindexbuild(BAT *b, const char *idx, int nthreads, const char *func)
+{
+	gdk_return rc;
+
+	if (strcmp(idx, "hash") == 0) {
+		HASHdestroy(b);
+		rc = BAThashbuild(b, nthreads);
+	} else if (strcmp(idx, "orderidx") == 0) {
+		OIDXdestroy(b);
+		rc = BATorderidxbuild(b, true, nthreads);
+	} else
+		throw(MAL, func, ILLEGAL_ARGUMENT ": unknown index %s", idx);
+	if (rc != GDK_SUCCEED)
+		throw(MAL, func, OPERATION_FAILED);
+	return MAL_SUCCEED;
+}
+
+/* return the heap of the index idx of b */
+static const Heap *
+MBMindexheap(BAT *b, const char *idx)
+{
+	if (strcmp(idx, "hash") == 0)
+		return b->thash ? &b->thash->heap : NULL;
+	return b->torderidx;
+}
+
+str
+MBMindextime(lng *ret, bat *bid, str *idx, int *nthreads)
+{
+	BAT *b;
+	lng t0;
+	str msg;
+
+	if (is_int_nil(*nthreads) || *nthreads < 1)
+		throw(MAL, "microbenchmark.indextime", ILLEGAL_ARGUMENT ": number of threads must be positive");
+	if ((b = BATdescriptor(*bid)) == NULL)
+		throw(MAL, "microbenchmark.indextime", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	t0 = GDKusec();
+	msg = MBMindexbuild(b, *idx, *nthreads, "microbenchmark.indextime");
+	*ret = GDKusec() - t0;
+	BBPunfix(b->batCacheid);
+	return msg;
+}
+
+str
+MBMindexcompare(bit *ret, bat *bid, str *idx, int *nthreads)
+{
+	BAT *b;
+	const Heap *hp;
+	char *serial;
+	size_t size;
+	str msg;
+
+	if (is_int_nil(*nthreads) || *nthreads < 1)
+		throw(MAL, "microbenchmark.indexcompare", ILLEGAL_ARGUMENT ": number of threads must be positive");
+	if ((b = BATdescriptor(*bid)) == NULL)
+		throw(MAL, "microbenchmark.indexcompare", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if ((msg = MBMindexbuild(b, *idx, 1, "microbenchmark.indexcompare")) != MAL_SUCCEED) {
+		BBPunfix(b->batCacheid);
+		return msg;
+	}
+	if ((hp = MBMindexheap(b, *idx)) == NULL) {
+		/* no index needed (e.g. sorted input): trivially equal */
+		BBPunfix(b->batCacheid);
+		*ret = TRUE;
+		return MAL_SUCCEED;
+	}
+	size = hp->free;
+	if ((serial = GDKmalloc(size)) == NULL) {
+		BBPunfix(b->batCacheid);
+		throw(MAL, "microbenchmark.indexcompare", SQLSTATE(HY001) MAL_MALLOC_FAIL);
+	}
+	memcpy(serial, hp->base, size);
+	if ((msg = MBMindexbuild(b, *idx, *nthreads, "microbenchmark.indexcompare")) != MAL_SUCCEED) {
+		GDKfree(serial);
+		BBPunfix(b->batCacheid);
+		return msg;
+	}
+	hp = MBMindexheap(b, *idx);
+	*ret = hp != NULL && hp->free == size &&
+		memcmp(serial, hp->base, size) == 0;
+	GDKfree(serial);
+	BBPunfix(b->batCacheid);
+	return MAL_SUCCEED;
+}
+
+/*
+ * @- Grouping
+ * Time the grouping of a BAT (optionally within the groups of g) with
+ * a given number of threads, and check that grouping with multiple
+ * threads yields exactly the same groups, extents and histogram as
+ * grouping with a single thread.
+ */
+static str
+MBMgroupbuild(BAT **gn, BAT **en, BAT **hn, bat *bid, bat *gid, int *nthreads, const char *func)
+{
+	BAT *b, *g = NULL;
+	gdk_return rc;
+
+	if (is_int_nil(*nthreads) || *nthreads < 1)
+		throw(MAL, func, ILLEGAL_ARGUMENT ": number of threads must be positive");
+	if ((b = BATdescriptor(*bid)) == NULL)
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if (!is_bat_nil(*gid) && (g = BATdescriptor(*gid)) == NULL) {
+		BBPunfix(b->batCacheid);
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	}
+	rc = BATgroupthreads(gn, en, hn, b, NULL, g, NULL, NULL, *nthreads);
+	BBPunfix(b->batCacheid);
+	if (g)
+		BBPunfix(g->batCacheid);
+	if (rc != GDK_SUCCEED)
+		throw(MAL, func, OPERATION_FAILED);
+	return MAL_SUCCEED;
+}
+
+str
+MBMgrouptime(lng *ret, bat *bid, bat *gid, int *nthreads)
+{
+	BAT *gn, *en, *hn;
+	lng t0;
+	str msg;
+
+	t0 = GDKusec();
+	msg = MBMgroupbuild(&gn, &en, &hn, bid, gid, nthreads, "microbenchmark.grouptime");
+	*ret = GDKusec() - t0;
+	if (msg == MAL_SUCCEED) {
+		BBPunfix(gn->batCacheid);
+		BBPunfix(en->batCacheid);
+		BBPunfix(hn->batCacheid);
+	}
+	return msg;
+}
+
+/* return whether the tails of a and b are identical */
+static bool
+MBMequal(BAT *a, BAT *b)
+{
+	BUN n = BATcount(a);
+
+	if (n != BATcount(b))
+		return false;
+	if (BATtdense(a) || BATtdense(b)) {
+		/* only oid columns can be dense */
+		BUN i;
+
+		for (i = 0; i < n; i++)
+			if ((BATtdense(a) ? a->tseqbase + i : ((const oid *) Tloc(a, 0))[i]) !=
+			    (BATtdense(b) ? b->tseqbase + i : ((const oid *) Tloc(b, 0))[i]))
+				return false;
+		return true;
+	}
+	return n == 0 || memcmp(Tloc(a, 0), Tloc(b, 0), n * Tsize(a)) == 0;
+}
+
+str
+MBMgroupcompare(bit *ret, bat *bid, bat *gid, int *nthreads)
+{
+	BAT *gn1, *en1, *hn1, *gn2, *en2, *hn2;
+	int one = 1;
+	str msg;
+
+	if ((msg = MBMgroupbuild(&gn1, &en1, &hn1, bid, gid, &one, "microbenchmark.groupcompare")) != MAL_SUCCEED)
+		return msg;
+	if ((msg = MBMgroupbuild(&gn2, &en2, &hn2, bid, gid, nthreads, "microbenchmark.groupcompare")) != MAL_SUCCEED) {
+		BBPunfix(gn1->batCacheid);
+		BBPunfix(en1->batCacheid);
+		BBPunfix(hn1->batCacheid);
+		return msg;
+	}
+	*ret = MBMequal(gn1, gn2) && MBMequal(en1, en2) && MBMequal(hn1, hn2) &&
+		gn1->tsorted == gn2->tsorted && gn1->tkey == gn2->tkey;
+	BBPunfix(gn1->batCacheid);
+	BBPunfix(en1->batCacheid);
+	BBPunfix(hn1->batCacheid);
+	BBPunfix(gn2->batCacheid);
+	BBPunfix(en2->batCacheid);
+	BBPunfix(hn2->batCacheid);
+	return MAL_SUCCEED;
+}
+
+/*
+ * @- Sorting
+ * Time the sorting of a BAT with a given number of threads, and check
+ * that sorting with multiple threads yields the same result as sorting
+ * with a single thread.  For a stable sort the order BATs must be
+ * identical, otherwise the order must produce the sorted values.
+ */
+static str
+MBMsortbuild(BAT **sn, BAT **on, bat *bid, bit *reverse, bit *stable, int *nthreads, const char *func)
+{
+	BAT *b;
+	gdk_return rc;
+
+	if (is_int_nil(*nthreads) || *nthreads < 1)
+		throw(MAL, func, ILLEGAL_ARGUMENT ": number of threads must be positive");
+	if (is_bit_nil(*reverse) || is_bit_nil(*stable))
+		throw(MAL, func, ILLEGAL_ARGUMENT ": reverse and stable must not be nil");
+	if ((b = BATdescriptor(*bid)) == NULL)
+		throw(MAL, func, SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	/* an order index left behind by a previous sort would be used
+	 * instead of sorting */
+	OIDXdestroy(b);
+	rc = BATsortthreads(sn, on, NULL, b, NULL, NULL, *reverse, *stable, *nthreads);
+	BBPunfix(b->batCacheid);
+	if (rc != GDK_SUCCEED)
+		throw(MAL, func, OPERATION_FAILED);
+	return MAL_SUCCEED;
+}
+
+str
+MBMsorttime(lng *ret, bat *bid, bit *reverse, bit *stable, int *nthreads)
+{
+	BAT *sn, *on;
+	lng t0;
+	str msg;
+
+	t0 = GDKusec();
+	msg = MBMsortbuild(&sn, &on, bid, reverse, stable, nthreads, "microbenchmark.sorttime");
+	*ret = GDKusec() - t0;
+	if (msg == MAL_SUCCEED) {
+		BBPunfix(sn->batCacheid);
+		BBPunfix(on->batCacheid);
+	}
+	return msg;
+}
+
+str
+MBMsortcompare(bit *ret, bat *bid, bit *reverse, bit *stable, int *nthreads)
+{
+	BAT *sn1, *on1, *sn2, *on2, *b, *pn;
+	int one = 1;
+	str msg;
+
+	if ((msg = MBMsortbuild(&sn1, &on1, bid, reverse, stable, &one, "microbenchmark.sortcompare")) != MAL_SUCCEED)
+		return msg;
+	if ((msg = MBMsortbuild(&sn2, &on2, bid, reverse, stable, nthreads, "microbenchmark.sortcompare")) != MAL_SUCCEED) {
+		BBPunfix(sn1->batCacheid);
+		BBPunfix(on1->batCacheid);
+		return msg;
+	}
+	*ret = MBMequal(sn1, sn2) &&
+		sn1->tsorted == sn2->tsorted &&
+		sn1->trevsorted == sn2->trevsorted;
+	if (*ret && *stable) {
+		*ret = MBMequal(on1, on2);
+	} else if (*ret) {
+		if ((b = BATdescriptor(*bid)) == NULL) {
+			msg = createException(MAL, "microbenchmark.sortcompare", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+		} else {
+			if ((pn = BATproject(on2, b)) == NULL) {
+				msg = createException(MAL, "microbenchmark.sortcompare", OPERATION_FAILED);
+			} else {
+				*ret = MBMequal(sn1, pn);
+				BBPunfix(pn->batCacheid);
+			}
+			BBPunfix(b->batCacheid);
+		}
+	}
+	BBPunfix(sn1->batCacheid);
+	BBPunfix(on1->batCacheid);
+	BBPunfix(sn2->batCacheid);
+	BBPunfix(on2->batCacheid);
+	return msg;
+}
+
+/*
+ * @- Compression
+ * Compress the tail heap of a BAT the way it would be saved on disk,
+ * and check that decompressing it yields the original values.
+ */
+str
+MBMcompresssize(lng *ret, bat *bid)
+{
+	BAT *b;
+	Heap h;
+	void *img;
+	size_t len;
+	str msg = MAL_SUCCEED;
+
+	if ((b = BATdescriptor(*bid)) == NULL)
+		throw(MAL, "microbenchmark.compresssize", SQLSTATE(HY002) RUNTIME_OBJECT_MISSING);
+	if (isVIEW(b)) {
+		BBPunfix(b->batCacheid);
+		throw(MAL, "microbenchmark.compresssize", ILLEGAL_ARGUMENT ": views are not supported");
+	}
+	if (HEAPcompress(&b->theap, b->ttype, &img, &len) != GDK_SUCCEED) {
+		BBPunfix(b->batCacheid);
+		throw(MAL, "microbenchmark.compresssize", OPERATION_FAILED);
+	}
+	if (img == NULL) {
+		*ret = -1;
+	} else {
+		memset(&h, 0, sizeof(h));
+		h.free = b->theap.free;
+		h.farmid = b->theap.farmid;
+		if (HEAPdecompress(&h, b->ttype, img, len) != GDK_SUCCEED) {
+			msg = createException(MAL, "microbenchmark.compresssize", OPERATION_FAILED);
+		} else {
+			if (memcmp(h.base, b->theap.base, h.free) != 0)
+				msg = createException(MAL, "microbenchmark.compresssize", "decompressed heap differs from the original");
+			GDKfree(h.base);
+		}
+		GDKfree(img);
+		*ret = (lng) len;
+	}
+	BBPunfix(b->batCacheid);
+	return msg;
+}
@@ -20,5 +20,12 @@ mal_export str MBMuniform(bat *ret, oid *base, lng *size, int *domain);
 mal_export str MBMnormal(bat *ret, oid *base, lng *size, int *domain, int *stddev, int *mean);
 mal_export str MBMmix(bat *ret, bat *batid);
 mal_export str MBMskewed(bat *ret, oid *base, lng *size, int *domain, int *skew);
+mal_export str MBMindextime(lng *ret, bat *bid, str *idx, int *nthreads);
+mal_export str MBMindexcompare(bit *ret, bat *bid, str *idx, int *nthreads);
+mal_export str MBMgrouptime(lng *ret, bat *bid, bat *gid, int *nthreads);
+mal_export str MBMgroupcompare(bit *ret, bat *bid, bat *gid, int *nthreads);
+mal_export str MBMsorttime(lng *ret, bat *bid, bit *reverse, bit *stable, int *nthreads);
+mal_export str MBMsortcompare(bit *ret, bat *bid, bit *reverse, bit *stable, int *nthreads);
+mal_export str MBMcompresssize(lng *ret, bat *bid);
 
 #endif /* _MBM_H_ */
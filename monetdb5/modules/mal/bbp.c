@@ -123,6 +123,15 @@ CMDgetPageSize(int *ret)
 	return MAL_SUCCEED;
 }
 
+str
+CMDbbpTrim(lng *ret, const lng *target)
+{
+	if (is_lng_nil(*target) || *target < 0)
+		throw(MAL, "bbp.trim", ILLEGAL_ARGUMENT);
+	*ret = (lng) BBPtrim((size_t) *target);
+	return MAL_SUCCEED;
+}
+
 str
 CMDbbpName(str *ret, bat *bid)
 {
@@ -402,10 +411,12 @@ str CMDbbp(bat *ID, bat *NS, bat *TT, bat *CNT, bat *REFCNT, bat *LREFCNT, bat *
 	}
 	for (i = 1; i < sz; i++) {
 		if (BBP_logical(i) && (BBP_refs(i) || BBP_lrefs(i))) {
+			/* before we fix it ourselves */
+			int heat_ = (int) BBP_heat(i);
+
 			bn = BATdescriptor(i);
 			if (bn) {
 				lng l = BATcount(bn);
-				int heat_ = 0;
 				char *loc = BBP_cache(i) ? "load" : "disk";
 				char *mode = "persistent";
 				int refs = BBP_refs(i);
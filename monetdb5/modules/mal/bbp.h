@@ -30,6 +30,7 @@
 mal_export str CMDbbpbind(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr pci);
 mal_export str CMDbbpDiskSpace(lng *ret);
 mal_export str CMDgetPageSize(int *ret);
+mal_export str CMDbbpTrim(lng *ret, const lng *target);
 mal_export str CMDbbpNames(bat *ret);
 mal_export str CMDbbpName(str *ret, bat *bid);
 mal_export str CMDbbpCount(bat *ret);
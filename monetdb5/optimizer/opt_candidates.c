@@ -50,6 +50,8 @@ OPTcandidatesImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr
 				setVarCList(mb,getArg(p,0));
 			else if(getFunctionId(p) == firstnRef )
 				setVarCList(mb,getArg(p,0));
+			else if(getFunctionId(p) == firstnkeysRef )
+				setVarCList(mb,getArg(p,0));
 			else if(getFunctionId(p) == subsliceRef )
 				setVarCList(mb,getArg(p,0));
 			else if (getFunctionId(p) == projectionRef &&
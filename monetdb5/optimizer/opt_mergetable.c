@@ -1169,6 +1169,69 @@ mat_group_project(MalBlkPtr mb, InstrPtr p, matlist_t *ml, int e, int a)
 	return 0;
 }
 
+/* Weigh the per partition averages avgs by their share in the total
+ * number of values of the group, i.e. return avg*(count/sumcount),
+ * which still need to be summed per group. */
+static InstrPtr
+mat_group_avg(MalBlkPtr mb, int tp, int avgs, int cnts, int g, int e)
+{
+	int tp2 = newBatType(TYPE_lng);
+	InstrPtr r,s,v,w, cond;
+
+	/* lng s = sum counts */
+	s = newInstruction(mb, aggrRef, subsumRef);
+	getArg(s,0) = newTmpVariable(mb, tp2);
+	s = pushArgument(mb, s, cnts);
+	s = pushArgument(mb, s, g);
+	s = pushArgument(mb, s, e);
+	s = pushBit(mb, s, 1); /* skip nils */
+	s = pushBit(mb, s, 1);
+	pushInstruction(mb,s);
+
+	/*  w=count = ifthenelse(s=count==0,NULL,s=count)  */
+	cond = newInstruction(mb, batcalcRef, eqRef);
+	getArg(cond,0) = newTmpVariable(mb, newBatType(TYPE_bit));
+	cond = pushArgument(mb, cond, getArg(s, 0));
+	cond = pushLng(mb, cond, 0);
+	pushInstruction(mb,cond);
+
+	w = newInstruction(mb, batcalcRef, ifthenelseRef);
+	getArg(w,0) = newTmpVariable(mb, tp2);
+	w = pushArgument(mb, w, getArg(cond, 0));
+	w = pushNil(mb, w, TYPE_lng);
+	w = pushArgument(mb, w, getArg(s, 0));
+	pushInstruction(mb,w);
+
+	/* fetchjoin with groups */
+	r = newInstruction(mb, algebraRef, projectionRef);
+	getArg(r, 0) = newTmpVariable(mb, tp2);
+	r = pushArgument(mb, r, g);
+	r = pushArgument(mb, r, getArg(w,0));
+	pushInstruction(mb,r);
+	s = r;
+
+	/* dbl v = double(count) */
+	v = newInstruction(mb, batcalcRef, dblRef);
+	getArg(v,0) = newTmpVariable(mb, newBatType(TYPE_dbl));
+	v = pushArgument(mb, v, cnts);
+	pushInstruction(mb, v);
+
+	/* dbl r = v / s */
+	r = newInstruction(mb, batcalcRef, divRef);
+	getArg(r,0) = newTmpVariable(mb, newBatType(TYPE_dbl));
+	r = pushArgument(mb, r, getArg(v, 0));
+	r = pushArgument(mb, r, getArg(s, 0));
+	pushInstruction(mb,r);
+
+	/* dbl s = avg * r */
+	s = newInstruction(mb, batcalcRef, mulRef);
+	getArg(s,0) = newTmpVariable(mb, tp);
+	s = pushArgument(mb, s, avgs);
+	s = pushArgument(mb, s, getArg(r, 0));
+	pushInstruction(mb,s);
+	return s;
+}
+
 /* Per partition aggregates are merged and aggregated together. For 
  * most (handled) aggregates thats relatively simple. AVG is somewhat
  * more complex. */
@@ -1225,63 +1288,8 @@ mat_group_aggr(MalBlkPtr mb, InstrPtr p, mat_t *mat, int b, int g, int e)
 		pushInstruction(mb, ai10);
 
 	/* for avg we do sum (avg*(count/sumcount) ) */
-	if (isAvg) {
-		InstrPtr r,s,v,w, cond;
-
-		/* lng s = sum counts */
- 		s = newInstruction(mb, aggrRef, subsumRef);
-		getArg(s,0) = newTmpVariable(mb, tp2);
-		s = pushArgument(mb, s, getArg(ai10, 0));
-		s = pushArgument(mb, s, mat[g].mv);
-		s = pushArgument(mb, s, mat[e].mv);
-		s = pushBit(mb, s, 1); /* skip nils */
-		s = pushBit(mb, s, 1);
-		pushInstruction(mb,s);
-
-		/*  w=count = ifthenelse(s=count==0,NULL,s=count)  */
-		cond = newInstruction(mb, batcalcRef, eqRef);
-		getArg(cond,0) = newTmpVariable(mb, newBatType(TYPE_bit));
-		cond = pushArgument(mb, cond, getArg(s, 0));
-		cond = pushLng(mb, cond, 0);
-		pushInstruction(mb,cond);
-
-		w = newInstruction(mb, batcalcRef, ifthenelseRef);
-		getArg(w,0) = newTmpVariable(mb, tp2);
-		w = pushArgument(mb, w, getArg(cond, 0));
-		w = pushNil(mb, w, TYPE_lng);
-		w = pushArgument(mb, w, getArg(s, 0));
-		pushInstruction(mb,w);
-
-		/* fetchjoin with groups */
- 		r = newInstruction(mb, algebraRef, projectionRef);
-		getArg(r, 0) = newTmpVariable(mb, tp2);
-		r = pushArgument(mb, r, mat[g].mv);
-		r = pushArgument(mb, r, getArg(w,0));
-		pushInstruction(mb,r);
-		s = r;
-
-		/* dbl v = double(count) */
-		v = newInstruction(mb, batcalcRef, dblRef);
-		getArg(v,0) = newTmpVariable(mb, newBatType(TYPE_dbl));
-		v = pushArgument(mb, v, getArg(ai10, 0));
-		pushInstruction(mb, v);
-
-		/* dbl r = v / s */
-		r = newInstruction(mb, batcalcRef, divRef);
-		getArg(r,0) = newTmpVariable(mb, newBatType(TYPE_dbl));
-		r = pushArgument(mb, r, getArg(v, 0));
-		r = pushArgument(mb, r, getArg(s, 0));
-		pushInstruction(mb,r);
-
-		/* dbl s = avg * r */
-		s = newInstruction(mb, batcalcRef, mulRef);
-		getArg(s,0) = newTmpVariable(mb, tp);
-		s = pushArgument(mb, s, getArg(ai1, 0));
-		s = pushArgument(mb, s, getArg(r, 0));
-		pushInstruction(mb,s);
-
-		ai1 = s;
-	}
+	if (isAvg)
+		ai1 = mat_group_avg(mb, tp, getArg(ai1, 0), getArg(ai10, 0), mat[g].mv, mat[e].mv);
  	ai2 = newInstruction(mb, aggrRef, aggr2);
 	getArg(ai2,0) = getArg(p,0);
 	ai2 = pushArgument(mb, ai2, getArg(ai1, 0));
@@ -1294,6 +1302,89 @@ mat_group_aggr(MalBlkPtr mb, InstrPtr p, mat_t *mat, int b, int g, int e)
 	return 0;
 }
 
+/* Several aggregates calculated in one pass per partition (see
+ * aggr.subaggrs) are merged like the individual aggregates.  The
+ * averages need the counts, so these are added to the per partition
+ * aggregates if not requested already. */
+static int
+mat_group_aggrs(MalBlkPtr mb, InstrPtr p, mat_t *mat, int b, int g, int e)
+{
+	int k, j, nr = p->retc, first = p->retc + 5, cnt = -1, avg = -1;
+	int tps[6];
+	InstrPtr pk[6], q, ai2;
+
+	assert(nr < 6);
+	for (j = 0; j < nr; j++) {
+		const char *name = getVarConstant(mb, getArg(p, first + j)).val.sval;
+
+		tps[j] = getArgType(mb, p, j);
+		if (strcmp(name, "count") == 0)
+			cnt = j;
+		else if (strcmp(name, "avg") == 0)
+			avg = j;
+	}
+	if (avg >= 0 && cnt < 0) {
+		cnt = nr++;
+		tps[cnt] = newBatType(TYPE_lng);
+	}
+	for (j = 0; j < nr; j++) {
+		if ((pk[j] = newInstruction(mb, matRef, packRef)) == NULL) {
+			while (--j >= 0)
+				freeInstruction(pk[j]);
+			return -1;
+		}
+		getArg(pk[j], 0) = newTmpVariable(mb, tps[j]);
+	}
+
+	for (k = 1; k < mat[b].mi->argc; k++) {
+		q = newInstruction(mb, aggrRef, subaggrsRef);
+		getArg(q, 0) = newTmpVariable(mb, tps[0]);
+		for (j = 1; j < nr; j++)
+			q = pushReturn(mb, q, newTmpVariable(mb, tps[j]));
+		q = pushArgument(mb, q, getArg(mat[b].mi, k));
+		q = pushArgument(mb, q, getArg(mat[g].mi, k));
+		q = pushArgument(mb, q, getArg(mat[e].mi, k));
+		q = pushArgument(mb, q, getArg(p, p->retc + 3));
+		q = pushArgument(mb, q, getArg(p, p->retc + 4));
+		for (j = first; j < p->argc; j++)
+			q = pushArgument(mb, q, getArg(p, j));
+		if (nr > p->retc)
+			q = pushStr(mb, q, "count");
+		pushInstruction(mb, q);
+
+		/* pack the results into mats */
+		for (j = 0; j < nr; j++)
+			pk[j] = pushArgument(mb, pk[j], getArg(q, j));
+	}
+	for (j = 0; j < nr; j++)
+		pushInstruction(mb, pk[j]);
+
+	for (j = 0; j < p->retc; j++) {
+		const char *name = getVarConstant(mb, getArg(p, first + j)).val.sval;
+		int arg = getArg(pk[j], 0);
+
+		if (j == avg) {
+			q = mat_group_avg(mb, tps[j], arg, getArg(pk[cnt], 0), mat[g].mv, mat[e].mv);
+			arg = getArg(q, 0);
+		}
+		if (strcmp(name, "min") == 0)
+			ai2 = newInstruction(mb, aggrRef, subminRef);
+		else if (strcmp(name, "max") == 0)
+			ai2 = newInstruction(mb, aggrRef, submaxRef);
+		else
+			ai2 = newInstruction(mb, aggrRef, subsumRef);
+		getArg(ai2,0) = getArg(p,j);
+		ai2 = pushArgument(mb, ai2, arg);
+		ai2 = pushArgument(mb, ai2, mat[g].mv);
+		ai2 = pushArgument(mb, ai2, mat[e].mv);
+		ai2 = pushBit(mb, ai2, 1); /* skip nils */
+		if (getFunctionId(ai2) == subsumRef)
+			ai2 = pushBit(mb, ai2, 1);
+		pushInstruction(mb, ai2);
+	}
+	return 0;
+}
+
 /* The mat_group_{new,derive} keep an ext,attr1..attrn table.
  * This is the input for the final second phase group by.
  */
@@ -1713,6 +1804,88 @@ mat_topn(MalBlkPtr mb, InstrPtr p, matlist_t *ml, int m, int n, int o)
 	return 0;
 }
 
+/* all key columns of a firstnkeys are mats with the same number of parts */
+static int
+is_firstnkeys_mat(MalBlkPtr mb, InstrPtr p, matlist_t *ml)
+{
+	int j, m, parts = -1;
+
+	if (getModuleId(p) != algebraRef || getFunctionId(p) != firstnkeysRef ||
+	    isaBatType(getArgType(mb, p, p->retc)))
+		return 0;
+	for (j = p->retc + 1; j < p->argc; j += 2) {
+		if ((m = is_a_mat(getArg(p, j), ml)) < 0)
+			return 0;
+		if (parts >= 0 && ml->v[m].mi->argc != parts)
+			return 0;
+		parts = ml->v[m].mi->argc;
+	}
+	return parts > 0;
+}
+
+static int
+mat_firstnkeys(MalBlkPtr mb, InstrPtr p, matlist_t *ml)
+{
+	/* transform
+	 * a := algebra.firstnkeys(n, b, asc1, c, asc2);
+	 * into
+	 * t1 := algebra.firstnkeys(n, b1, asc1, c1, asc2);
+	 * t2 := algebra.firstnkeys(n, b2, asc1, c2, asc2);
+	 * ...
+	 * b0 := mat.pack(algebra.projection(t1, b1), algebra.projection(t2, b2), ...);
+	 * c0 := mat.pack(algebra.projection(t1, c1), algebra.projection(t2, c2), ...);
+	 * a := algebra.firstnkeys(n, b0, asc1, c0, asc2);
+	 *
+	 * a refers to the packed parts, so (as for the other topn's)
+	 * projections on a are done on the parts t1, t2, ... first */
+	int tpe = getArgType(mb,p,0), m = is_a_mat(getArg(p,p->retc+1), ml);
+	int parts = ml->v[m].mi->argc, j, k;
+	InstrPtr pck, q, r;
+
+	pck = newInstruction(mb, matRef, packRef);
+	getArg(pck,0) = getArg(p,0);
+	for(k=1; k<parts; k++) {
+		if((q = copyInstruction(p)) == NULL) {
+			freeInstruction(pck);
+			return -1;
+		}
+		getArg(q,0) = newTmpVariable(mb, tpe);
+		for(j=p->retc+1; j<p->argc; j+=2)
+			getArg(q,j) = getArg(ml->v[is_a_mat(getArg(p,j), ml)].mi, k);
+		pushInstruction(mb,q);
+		pck = pushArgument(mb, pck, getArg(q,0));
+	}
+
+	if((r = copyInstruction(p)) == NULL) {
+		freeInstruction(pck);
+		return -1;
+	}
+	for(j=p->retc+1; j<p->argc; j+=2) {
+		InstrPtr mi = ml->v[is_a_mat(getArg(p,j), ml)].mi, c;
+		int btpe = getArgType(mb,p,j);
+
+		c = newInstruction(mb, matRef, packRef);
+		getArg(c,0) = newTmpVariable(mb, btpe);
+		for(k=1; k<parts; k++) {
+			q = newInstruction(mb, algebraRef, projectionRef);
+			getArg(q,0) = newTmpVariable(mb, btpe);
+			q = pushArgument(mb, q, getArg(pck,k));
+			q = pushArgument(mb, q, getArg(mi,k));
+			pushInstruction(mb,q);
+			c = pushArgument(mb, c, getArg(q,0));
+		}
+		pushInstruction(mb,c);
+		getArg(r,j) = getArg(c,0);
+	}
+	pushInstruction(mb,r);
+
+	if(mat_add_var(ml, pck, p, getArg(p,0), mat_slc, m, -1, 0)) {
+		freeInstruction(pck);
+		return -1;
+	}
+	return 0;
+}
+
 static int
 mat_sample(MalBlkPtr mb, InstrPtr p, matlist_t *ml, int m)
 {
@@ -1989,6 +2162,14 @@ OPTmergetableImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr
 			actions++;
 			continue;
 		}
+		if (!distinct_topn && match > 0 && match == bats && is_firstnkeys_mat(mb, p, &ml)) {
+			if(mat_firstnkeys(mb, p, &ml)) {
+				msg = createException(MAL,"optimizer.mergetable",SQLSTATE(HY001) MAL_MALLOC_FAIL);
+				goto cleanup;
+			}
+			actions++;
+			continue;
+		}
 
 		/* Now we handle subgroup and aggregation statements. */
 		if (!groupdone && match == 1 && bats == 1 && p->argc == 4 && getModuleId(p) == groupRef && 
@@ -2013,6 +2194,22 @@ OPTmergetableImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr
 			actions++;
 			continue;
 		}
+		/* aggregates in one pass, only when skipping nils */
+		if (match == 3 && bats == 3 && getModuleId(p) == aggrRef &&
+		    getFunctionId(p) == subaggrsRef && p->retc < 6 &&
+		    p->argc == 2 * p->retc + 5 &&
+		    isVarConstant(mb, getArg(p, p->retc + 3)) &&
+		    getVarConstant(mb, getArg(p, p->retc + 3)).val.btval == 1 &&
+		   ((m=is_a_mat(getArg(p,p->retc), &ml)) >= 0) &&
+		   ((n=is_a_mat(getArg(p,p->retc+1), &ml)) >= 0) &&
+		   ((o=is_a_mat(getArg(p,p->retc+2), &ml)) >= 0)) {
+			if(mat_group_aggrs(mb, p, ml.v, m, n, o)) {
+				msg = createException(MAL,"optimizer.mergetable",SQLSTATE(HY001) MAL_MALLOC_FAIL);
+				goto cleanup;
+			}
+			actions++;
+			continue;
+		}
 		/* TODO sub'aggr' with cand list */
 		if (match == 3 && bats == 3 && getModuleId(p) == aggrRef && p->argc >= 4 &&
 		   (getFunctionId(p) == subcountRef ||
@@ -65,6 +65,7 @@ OPTmitosisImplementation(Client cntxt, MalBlkPtr mb, MalStkPtr stk, InstrPtr p)
 		    	getFunctionId(p) != subavgRef &&
 		    	getFunctionId(p) != subsumRef &&
 		    	getFunctionId(p) != subprodRef &&
+		    	getFunctionId(p) != subaggrsRef &&
 
 		        getFunctionId(p) != countRef &&
 		    	getFunctionId(p) != minRef &&
@@ -131,6 +131,7 @@ str export_tableRef;
 str findRef;
 str finishRef;
 str firstnRef;
+str firstnkeysRef;
 str generatorRef;
 str getRef;
 str getTraceRef;
@@ -269,6 +270,7 @@ str stopRef;
 str stoptraceRef;
 str streamsRef;
 str strRef;
+str subaggrsRef;
 str subavgRef;
 str subcountRef;
 str subdeltaRef;
@@ -428,6 +430,7 @@ void optimizerInit(void)
 	findRef = putName("find");
 	finishRef = putName("finish");
 	firstnRef = putName("firstn");
+	firstnkeysRef = putName("firstnkeys");
 	generatorRef = putName("generator");
 	getRef = putName("get");
 	getTraceRef = putName("getTrace");
@@ -566,6 +569,7 @@ void optimizerInit(void)
 	stoptraceRef = putName("stoptrace");
 	streamsRef = putName("streams");
 	strRef = putName("str");
+	subaggrsRef = putName("subaggrs");
 	subavgRef = putName("subavg");
 	subcountRef = putName("subcount");
 	subdeltaRef = putName("subdelta");
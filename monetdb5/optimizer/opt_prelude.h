@@ -132,6 +132,7 @@ mal_export  str export_tableRef;
 mal_export  str findRef;
 mal_export  str finishRef;
 mal_export  str firstnRef;
+mal_export  str firstnkeysRef;
 mal_export  str generatorRef;
 mal_export  str getRef;
 mal_export  str getTraceRef;
@@ -277,6 +278,7 @@ mal_export  str stopRef;
 mal_export  str stoptraceRef;
 mal_export  str streamsRef;
 mal_export  str strRef;
+mal_export  str subaggrsRef;
 mal_export  str subavgRef;
 mal_export  str subcountRef;
 mal_export  str subdeltaRef;
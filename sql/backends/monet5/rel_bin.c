@@ -2600,7 +2600,27 @@ rel2bin_project(backend *be, sql_rel *rel, list *refs, sql_rel *topn)
 		int distinct = need_distinct(rel);
 		stmt *limit = NULL, *lpiv = NULL, *lgid = NULL; 
 
-		for (n=oexps->h; n; n = n->next) {
+		/* topn based on several columns at once */
+		if (!distinct && list_length(oexps) > 1) {
+			list *cols = sa_list(sql->sa);
+			int *dirs = SA_NEW_ARRAY(sql->sa, int, list_length(oexps)), i = 0;
+
+			if (!dirs)
+				return NULL;
+			for (n=oexps->h; n; n = n->next, i++) {
+				sql_exp *orderbycole = n->data; 
+				stmt *orderbycolstmt = exp_bin(be, orderbycole, sub, psub, NULL, NULL, NULL, NULL); 
+
+				if (!orderbycolstmt) 
+					return NULL;
+				list_append(cols, column(be, orderbycolstmt));
+				dirs[i] = is_ascending(orderbycole);
+			}
+			lpiv = stmt_limitkeys(be, cols, dirs, stmt_atom_lng(be, 0), l);
+			if (!lpiv)
+				return NULL;
+		}
+		for (n=lpiv?NULL:oexps->h; n; n = n->next) {
 			sql_exp *orderbycole = n->data; 
  			int last = (n->next == NULL);
 
@@ -2769,6 +2789,97 @@ rel2bin_select(backend *be, sql_rel *rel, list *refs)
 	return stmt_list(be, l);
 }
 
+/* can the aggregate be calculated together with others of the same
+ * column (see groupby_aggrs) */
+static int
+aggr_fusable(sql_exp *e)
+{
+	sql_subaggr *a;
+	const char *imp;
+
+	if (e->type != e_aggr || need_distinct(e) || list_length(e->l) != 1)
+		return 0;
+	a = e->f;
+	if (a->aggr->lang != FUNC_LANG_INT || strcmp(a->aggr->mod, "aggr") != 0)
+		return 0;
+	imp = a->aggr->imp;
+	return strcmp(imp, "sum") == 0 || strcmp(imp, "count") == 0 ||
+		strcmp(imp, "min") == 0 || strcmp(imp, "max") == 0 ||
+		strcmp(imp, "avg") == 0;
+}
+
+/* The aggregates sum, count, min, max and avg of the same column in a
+ * group by are calculated in a single pass over the column.  Returns
+ * the statements of the aggregates that are calculated together,
+ * indexed like the aggregate expressions (NULL for the others). */
+static stmt **
+groupby_aggrs(backend *be, list *aggrs, stmt *sub, stmt *grp, stmt *ext)
+{
+	mvc *sql = be->mvc;
+	int i, j, k, n = list_length(aggrs), idx[5];
+	sql_exp **exps;
+	stmt **res;
+	node *m;
+
+	if (!grp || n < 2)
+		return NULL;
+	exps = SA_NEW_ARRAY(sql->sa, sql_exp*, n);
+	res = SA_NEW_ARRAY(sql->sa, stmt*, n);
+	if (!exps || !res)
+		return NULL;
+	for (i = 0, m = aggrs->h; m; m = m->next, i++) {
+		exps[i] = aggr_fusable(m->data) ? m->data : NULL;
+		res[i] = NULL;
+	}
+	for (i = 0; i < n; i++) {
+		sql_exp *e = exps[i], *at;
+		list *ops;
+		stmt *as, *s;
+
+		if (!e)
+			continue;
+		at = ((list*)e->l)->h->data;
+		ops = sa_list(sql->sa);
+		list_append(ops, e->f);
+		idx[0] = i;
+		exps[i] = NULL;
+		for (j = i + 1; j < n && list_length(ops) < 5; j++) {
+			sql_exp *f = exps[j];
+			sql_subaggr *a;
+
+			if (!f || need_no_nil(f) != need_no_nil(e) ||
+			    !exp_match_exp(at, ((list*)f->l)->h->data))
+				continue;
+			a = f->f;
+			for (k = 0, m = ops->h; m; m = m->next, k++)
+				if (strcmp(((sql_subaggr*)m->data)->aggr->imp, a->aggr->imp) == 0)
+					break;
+			if (m)	/* each aggregate only once */
+				continue;
+			idx[list_length(ops)] = j;
+			list_append(ops, a);
+			exps[j] = NULL;
+		}
+		if (list_length(ops) < 2)
+			continue;
+
+		as = exp_bin(be, at, sub, NULL, NULL, NULL, NULL, NULL);
+		if (as && as->nrcols <= 0)
+			as = stmt_const(be, bin_first_column(be, sub), as);
+		if (!as || !(s = stmt_aggrs(be, as, grp, ext, ops, need_no_nil(e))))
+			continue;
+		for (k = 0, m = s->op4.lval->h; m; m = m->next, k++) {
+			stmt *r = m->data;
+			sql_exp *f = list_fetch(aggrs, idx[k]);
+
+			if (find_prop(f->p, PROP_COUNT)) /* see exp_bin */
+				r->flag |= OUTER_ZERO;
+			res[idx[k]] = r;
+		}
+	}
+	return res;
+}
+
 static stmt *
 rel2bin_groupby(backend *be, sql_rel *rel, list *refs)
 {
@@ -2777,6 +2888,8 @@ rel2bin_groupby(backend *be, sql_rel *rel, list *refs)
 	node *n, *en;
 	stmt *sub = NULL, *cursub;
 	stmt *groupby = NULL, *grp = NULL, *ext = NULL, *cnt = NULL;
+	stmt **fused;
+	int i;
 
 	if (rel->l) { /* first construct the sub relation */
 		sub = subrel_bin(be, rel->l, refs);
@@ -2827,10 +2940,11 @@ rel2bin_groupby(backend *be, sql_rel *rel, list *refs)
 	l = sa_list(sql->sa);
 	aggrs = rel->exps;
 	cursub = stmt_list(be, l);
-	for( n = aggrs->h; n; n = n->next ) {
+	fused = groupby_aggrs(be, aggrs, sub, grp, ext);
+	for( n = aggrs->h, i = 0; n; n = n->next, i++ ) {
 		sql_exp *aggrexp = n->data;
 
-		stmt *aggrstmt = NULL;
+		stmt *aggrstmt = fused ? fused[i] : NULL;
 
 		/* first look in the current aggr list (l) and group by column list */
 		if (l && !aggrstmt && aggrexp->type == e_column) 
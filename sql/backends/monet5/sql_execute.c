@@ -189,6 +189,70 @@ SQLsetTrace(Client cntxt, MalBlkPtr mb)
 	return msg;
 }
 
+/*
+ * Before a plan is run, we start reading all columns that it binds
+ * from disk (see BBPprefetch), so that the I/O overlaps with the
+ * execution of the instructions that come before the ones that need
+ * the columns, instead of each worker having to wait for the disk when
+ * it gets to use a column.  Only the main column BATs are prefetched;
+ * the delta BATs are small.
+ */
+static int
+bidcmp(const void *p1, const void *p2)
+{
+	bat b1 = *(const bat *) p1, b2 = *(const bat *) p2;
+
+	return b1 < b2 ? -1 : b1 > b2;
+}
+
+static void
+SQLprefetch(mvc *m, MalBlkPtr mb)
+{
+	bat *bids;
+	int i, j, n = 0;
+
+	for (i = 1; i < mb->stop; i++) {
+		InstrPtr p = getInstrPtr(mb, i);
+
+		if (getModuleId(p) == sqlRef && getFunctionId(p) == bindRef)
+			n++;
+	}
+	if (n == 0 || (bids = GDKmalloc(n * sizeof(bat))) == NULL)
+		return;
+	n = 0;
+	for (i = 1; i < mb->stop; i++) {
+		InstrPtr p = getInstrPtr(mb, i);
+		int upd = (p->argc == 7 || p->argc == 9);
+		sql_schema *s;
+		sql_table *t;
+		sql_column *c;
+		BAT *b;
+
+		if (getModuleId(p) != sqlRef || getFunctionId(p) != bindRef ||
+		    upd ||
+		    !isVarConstant(mb, getArg(p, 2)) ||
+		    !isVarConstant(mb, getArg(p, 3)) ||
+		    !isVarConstant(mb, getArg(p, 4)) ||
+		    !isVarConstant(mb, getArg(p, 5)) ||
+		    getVarConstant(mb, getArg(p, 5)).val.ival != RDONLY)
+			continue;
+		if ((s = mvc_bind_schema(m, getVarConstant(mb, getArg(p, 2)).val.sval)) == NULL ||
+		    (t = mvc_bind_table(m, s, getVarConstant(mb, getArg(p, 3)).val.sval)) == NULL ||
+		    (c = mvc_bind_column(m, t, getVarConstant(mb, getArg(p, 4)).val.sval)) == NULL ||
+		    (b = store_funcs.bind_col(m->session->tr, c, QUICK)) == NULL)
+			continue;
+		bids[n++] = b->batCacheid;
+	}
+	/* partitioned plans bind the same column many times */
+	qsort(bids, n, sizeof(bat), bidcmp);
+	for (i = 0; i < n; i = j) {
+		BBPprefetch(bids[i]);
+		for (j = i + 1; j < n && bids[j] == bids[i]; j++)
+			;
+	}
+	GDKfree(bids);
+}
+
 /*
  * Execution of the SQL program is delegated to the MALengine.
  * Different cases should be distinguished. The default is to
@@ -259,6 +323,7 @@ SQLexecutePrepared(Client c, backend *be, MalBlkPtr mb)
 		}
 	}
 	glb = (MalStkPtr) (q->stk);
+	SQLprefetch(m, mb);
 	ret = callMAL(c, mb, &glb, argv, (m->emod & mod_debug ? 'n' : 0));
 	/* cleanup the arguments */
 	for (i = pci->retc; i < pci->argc; i++) {
@@ -365,6 +430,7 @@ SQLrun(Client c, backend *be, mvc *m)
 	} else if( m->emod & mod_debug) {
 		msg = runMALDebugger(c, mb);
 	} else {
+		SQLprefetch(m, mb);
 		if( m->emod & mod_trace){
 			if((msg = SQLsetTrace(c,mb)) == MAL_SUCCEED) {
 				msg = runMAL(c, mb, 0, 0);
@@ -1140,6 +1140,55 @@ stmt_limit(backend *be, stmt *col, stmt *piv, stmt *gid, stmt *offset, stmt *lim
 	return NULL;
 }
 
+/* topn on several columns at once, dirs tells which are ascending */
+stmt *
+stmt_limitkeys(backend *be, list *cols, int *dirs, stmt *offset, stmt *limit)
+{
+	MalBlkPtr mb = be->mb;
+	InstrPtr q = NULL;
+	stmt *col = cols->h->data;
+	node *n;
+	int i, topn;
+
+	if (offset->nr < 0 || limit->nr < 0)
+		return NULL;
+	for (n = cols->h; n; n = n->next)
+		if (((stmt *) n->data)->nr < 0)
+			return NULL;
+
+	q = newStmt(mb, calcRef, "+");
+	q = pushArgument(mb, q, offset->nr);
+	q = pushArgument(mb, q, limit->nr);
+	if (q == NULL)
+		return NULL;
+	topn = getDestVar(q);
+
+	q = newStmt(mb, algebraRef, firstnkeysRef);
+	q = pushArgument(mb, q, topn);
+	for (n = cols->h, i = 0; n; n = n->next, i++) {
+		q = pushArgument(mb, q, ((stmt *) n->data)->nr);
+		q = pushBit(mb, q, dirs[i] != 0);
+	}
+	if (q) {
+		stmt *ns = stmt_create(be->mvc->sa, st_limit);
+		if (ns == NULL) {
+			freeInstruction(q);
+			return NULL;
+		}
+
+		ns->op1 = col;
+		ns->op2 = offset;
+		ns->op3 = limit;
+		ns->nrcols = col->nrcols;
+		ns->key = col->key;
+		ns->aggr = col->aggr;
+		ns->q = q;
+		ns->nr = getDestVar(q);
+		return ns;
+	}
+	return NULL;
+}
+
 stmt *
 stmt_sample(backend *be, stmt *s, stmt *sample)
 {
@@ -3130,6 +3179,67 @@ stmt_aggr(backend *be, stmt *op1, stmt *grp, stmt *ext, sql_subaggr *op, int red
 	return NULL;
 }
 
+/* The grouped aggregates ops (sum, count, min, max and/or avg) of op1
+ * calculated in one pass.  Returns a list with an aggregate statement
+ * per op. */
+stmt *
+stmt_aggrs(backend *be, stmt *op1, stmt *grp, stmt *ext, list *ops, int no_nil)
+{
+	MalBlkPtr mb = be->mb;
+	InstrPtr q = NULL;
+	list *l;
+	node *n;
+	int i;
+
+	if (op1->nr < 0 || grp->nr < 0 || ext->nr < 0)
+		return NULL;
+	q = newStmt(mb, aggrRef, subaggrsRef);
+	if (q == NULL)
+		return NULL;
+	for (i = 0, n = ops->h; n; n = n->next, i++) {
+		sql_subaggr *op = n->data;
+		sql_subtype *res = op->res->h->data;
+		int restype = newBatType(res->type->localtype);
+
+		if (i > 0)
+			q = pushReturn(mb, q, newTmpVariable(mb, restype));
+		else
+			setVarType(mb, getArg(q, 0), restype);
+		setVarUDFtype(mb, getArg(q, i));
+	}
+	q = pushArgument(mb, q, op1->nr);
+	q = pushArgument(mb, q, grp->nr);
+	q = pushArgument(mb, q, ext->nr);
+	q = pushBit(mb, q, no_nil);
+	q = pushBit(mb, q, TRUE);
+	for (n = ops->h; n; n = n->next) {
+		sql_subaggr *op = n->data;
+
+		q = pushStr(mb, q, op->aggr->imp);
+	}
+	if (q == NULL)
+		return NULL;
+
+	l = sa_list(be->mvc->sa);
+	for (i = 0, n = ops->h; n; n = n->next, i++) {
+		stmt *s = stmt_create(be->mvc->sa, st_aggr);
+		if(!s)
+			return NULL;
+		s->op1 = op1;
+		s->op2 = grp;
+		s->op3 = ext;
+		s->nrcols = 1;
+		s->key = 1;
+		s->aggr = 1;
+		s->flag = no_nil;
+		s->op4.aggrval = n->data;
+		s->nr = getArg(q, i);
+		s->q = q;
+		list_append(l, s);
+	}
+	return stmt_list(be, l);
+}
+
 static stmt *
 stmt_alias_(backend *be, stmt *op1, const char *tname, const char *alias)
 {
@@ -210,6 +210,7 @@ extern stmt *stmt_result(backend *be, stmt *s, int nr);
  * order:    is order important or not (firstn vs slice)
  */ 
 extern stmt *stmt_limit(backend *sa, stmt *c, stmt *piv, stmt *gid, stmt *offset, stmt *limit, int distinct, int dir, int last, int order);
+extern stmt *stmt_limitkeys(backend *be, list *cols, int *dirs, stmt *offset, stmt *limit);
 extern stmt *stmt_sample(backend *be, stmt *s, stmt *sample);
 extern stmt *stmt_order(backend *be, stmt *s, int direction);
 extern stmt *stmt_reorder(backend *be, stmt *s, int direction, stmt *orderby_ids, stmt *orderby_grp);
@@ -220,6 +221,7 @@ extern stmt *stmt_binop(backend *be, stmt *op1, stmt *op2, sql_subfunc *op);
 extern stmt *stmt_Nop(backend *be, stmt *ops, sql_subfunc *op);
 extern stmt *stmt_func(backend *be, stmt *ops, const char *name, sql_rel *imp, int f_union);
 extern stmt *stmt_aggr(backend *be, stmt *op1, stmt *grp, stmt *ext, sql_subaggr *op, int reduce, int no_nil, int nil_if_empty);
+extern stmt *stmt_aggrs(backend *be, stmt *op1, stmt *grp, stmt *ext, list *ops, int no_nil);
 
 extern stmt *stmt_alias(backend *be, stmt *op1, const char *tname, const char *name);
 
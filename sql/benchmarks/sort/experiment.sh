@@ -0,0 +1,108 @@
+#/bin/bash
+
+# This script can be used to assess the performance of the (parallel)
+# sort kernel for various numbers of threads.
+# It creates a table with random values of several fixed size types in
+# the given database (which must be managed by monetdbd) and times a
+# number of queries that sort the whole table on it.
+
+if [ "x"$1 = "x" ]
+then
+	echo "usage: dbname [rows [threads]]"
+	exit
+fi
+
+db=$1
+
+if [ "x$2" = "x" ]
+then
+	rows=10000000
+else
+	rows=$2
+fi
+
+if [ "x$3" = "x" ]
+then
+	threads="1 2 4 8"
+else
+	threads=$3
+fi
+
+TAG=`date +%y%m%d`
+TIMEFORMAT="%R"
+RUNLENGTH=5
+
+#fixed query load
+declare -a arr=(
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY i) AS r FROM sorttest) AS x WHERE r = 1;"
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY l) AS r FROM sorttest) AS x WHERE r = 1;"
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY d) AS r FROM sorttest) AS x WHERE r = 1;"
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY i DESC) AS r FROM sorttest) AS x WHERE r = 1;"
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY d DESC) AS r FROM sorttest) AS x WHERE r = 1;"
+"trace SELECT count(*) FROM (SELECT rank() OVER (ORDER BY s, i) AS r FROM sorttest) AS x WHERE r = 1;"
+)
+
+#database initialization
+declare -a init=(
+"DROP TABLE sorttest;"
+"CREATE TABLE sorttest (s SMALLINT, i INTEGER, l BIGINT, d DOUBLE);"
+"INSERT INTO sorttest SELECT CAST(rand() % 1000 AS SMALLINT), rand(), CAST(rand() AS BIGINT) * rand(), rand() / 3.0 FROM generate_series(0, ${rows});"
+)
+
+monetdb start $db 2>&1 >/dev/null
+for (( QID=0; QID<${#init[*]}; QID++ ))
+do
+	echo "${init[$QID]}" | mclient -d $db 2>&1 >/dev/null
+done
+
+DATA=`pwd`/${db}-sort-${TAG}
+mkdir -p $DATA
+rm ${DATA}/*
+files="filenames = \""
+for n in ${threads}
+do
+	monetdb stop $db 2>&1 >/dev/null
+	monetdb set nthreads=$n $db
+	monetdb start $db 2>&1 >/dev/null
+	for (( QID=0; QID<${#arr[*]}; QID++ ))
+	do
+		qry=${arr[$QID]}
+		echo "${QID}	${qry}" >>${DATA}/workload
+
+		row="${QID},${n},"`date +%Y%m%d:%H%M%S`
+		for (( i=0; i< ${RUNLENGTH}; i++ ))
+		do
+			echo "${qry}" | mclient -d $db -ei   2>&1 >${DATA}/Q${QID}.out
+			t=`cat ${DATA}/Q${QID}.out |tail -1 |sed -e "s/ //g"  -e "s/.*tuples//" -e "s/(//" -e "s/)//" -e "s/\.\(.*\)ms/.\1/"  -e "s/\.\(.*\)s/000.\1/"`
+			row=${row}","$t
+			echo "$n	$t" >>${DATA}/Q${QID}.data
+		done
+		echo ${row}",\""${qry}"\""
+		echo ${row}",\""${qry}"\"">> ${DATA}/summary
+	done
+done
+monetdb stop $db 2>&1 >/dev/null
+monetdb inherit nthreads $db
+
+for (( QID=0; QID<${#arr[*]}; QID++ ))
+do
+	files="${files}Q${QID}.data "
+done
+files="${files}\""
+
+# create the gnuplot script file
+
+echo "set title \"${TAG} ${db} sort ${rows} rows\"
+set logscale y
+set xlabel \"threads\"
+set terminal pdfcairo noenhanced font 'verdana,10' color solid size 7,9 
+set output 'plot.pdf'
+set key outside
+$files 
+plot \\" >>${DATA}/plot.gpl
+for (( QID=0; QID<${#arr[*]}; QID++ ))
+do
+	echo "'Q${QID}.data' with points,\\"  >>${DATA}/plot.gpl
+done
+echo "" >>${DATA}/plot.gpl
+cd ${DATA}; gnuplot plot.gpl
@@ -394,11 +394,22 @@ sql_trans_deref( sql_trans *tr )
 	return tr->parent;
 }
 
+static void
+mvc_sync(const char *operation, lng commit)
+{
+	if (store_sync(commit) != SQL_OK) {
+		char *err = sql_message(SQLSTATE(40000) "%s transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", operation, GDKerrbuf);
+		GDKfatal("%s", err);
+		_DELETE(err);
+	}
+}
+
 str
 mvc_commit(mvc *m, int chain, const char *name, bool enabling_auto_commit)
 {
 	sql_trans *cur, *tr = m->session->tr, *ctr;
 	int ok = SQL_OK;//, wait = 0;
+	lng commit = 0;
 	str msg, other;
 	char operation[BUFSIZ];
 
@@ -504,7 +515,7 @@ build up the hash (not copied in the trans dup)) */
 	 * */
 	/* validation phase */
 	if (sql_trans_validate(tr)) {
-		if ((ok = sql_trans_commit(tr)) != SQL_OK) {
+		if ((ok = sql_trans_commit_nosync(tr, &commit)) != SQL_OK) {
 			char *err = sql_message(SQLSTATE(40000) "%s transaction commit failed (perhaps your disk is full?) exiting (kernel error: %s)", operation, GDKerrbuf);
 			GDKfatal("%s", err);
 			_DELETE(err);
@@ -519,6 +530,7 @@ build up the hash (not copied in the trans dup)) */
 	msg = WLCcommit(m->clientid);
 	if(msg != MAL_SUCCEED) {
 		store_unlock();
+		mvc_sync(operation, commit);
 		if((other = mvc_rollback(m, chain, name, false)) != MAL_SUCCEED)
 			GDKfree(other);
 		return msg;
@@ -527,6 +539,10 @@ build up the hash (not copied in the trans dup)) */
 	if (chain)
 		sql_trans_begin(m->session);
 	store_unlock();
+	/* the commit is only done once it is on disk; we wait for
+	 * that outside the store lock so that concurrent commits can
+	 * share the sync of the log */
+	mvc_sync(operation, commit);
 	m->type = Q_TRANS;
 	if (mvc_debug)
 		fprintf(stderr, "#mvc_commit %s done\n", (name) ? name : "");
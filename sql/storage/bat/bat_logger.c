@@ -1031,9 +1031,15 @@ bl_tstart(void)
 }
 
 static int 
-bl_tend(void)
+bl_tflush(lng *commit)
 {
-	return log_tend(bat_logger) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+	return log_tflush(bat_logger, commit) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
+}
+
+static int 
+bl_tsync(lng commit)
+{
+	return log_tsync(bat_logger, commit) == GDK_SUCCEED ? LOG_OK : LOG_ERR;
 }
 
 static int 
@@ -1104,7 +1110,8 @@ bat_logger_init( logger_functions *lf )
 	lf->get_sequence = bl_get_sequence;
 	lf->log_isnew = bl_log_isnew;
 	lf->log_tstart = bl_tstart;
-	lf->log_tend = bl_tend;
+	lf->log_tflush = bl_tflush;
+	lf->log_tsync = bl_tsync;
 	lf->log_sequence = bl_sequence;
 	lf->log_find_table_value = bl_find_table_value;
 }
@@ -291,7 +291,8 @@ typedef int (*logger_reload_fptr) (void);
 
 typedef int (*log_isnew_fptr)(void);
 typedef int (*log_tstart_fptr) (void);
-typedef int (*log_tend_fptr) (void);
+typedef int (*log_tflush_fptr) (lng *commit);
+typedef int (*log_tsync_fptr) (lng commit);
 typedef int (*log_sequence_fptr) (int seq, lng id);
 
 typedef void *(*log_find_table_value_fptr)(const char *, const char *, const void *, ...);
@@ -311,7 +312,8 @@ typedef struct logger_functions {
 
 	log_isnew_fptr log_isnew;
 	log_tstart_fptr log_tstart;
-	log_tend_fptr log_tend;
+	log_tflush_fptr log_tflush;
+	log_tsync_fptr log_tsync;
 	log_sequence_fptr log_sequence;
 	log_find_table_value_fptr log_find_table_value;
 } logger_functions;
@@ -345,6 +347,8 @@ extern sql_trans *sql_trans_create(backend_stack stk, sql_trans *parent, const c
 extern sql_trans *sql_trans_destroy(sql_trans *tr);
 extern int sql_trans_validate(sql_trans *tr);
 extern int sql_trans_commit(sql_trans *tr);
+extern int sql_trans_commit_nosync(sql_trans *tr, lng *commit);
+extern int store_sync(lng commit);
 
 extern sql_type *sql_trans_create_type(sql_trans *tr, sql_schema * s, const char *sqlname, int digits, int scale, int radix, const char *impl);
 extern int sql_trans_drop_type(sql_trans *tr, sql_schema * s, int id, int drop_action);
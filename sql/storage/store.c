@@ -3970,11 +3970,18 @@ catalog_corrupt( sql_trans *tr )
 }
 #endif /*CAT_DEBUG*/
 
+/* Commit the transaction, but don't wait for its log records to be
+ * on disk: *commit is set to the number of the transaction in the log
+ * (or 0 if nothing was logged), which should be passed to store_sync
+ * after the store lock has been released.  This way transactions that
+ * commit concurrently share the sync of the log. */
 int
-sql_trans_commit(sql_trans *tr)
+sql_trans_commit_nosync(sql_trans *tr, lng *commit)
 {
 	int ok = LOG_OK;
 
+	*commit = 0;
+
 	/* write phase */
 	if (bs_debug)
 		fprintf(stderr, "#forwarding changes %d,%d %d,%d\n", gtrans->stime, tr->stime, gtrans->wstime, tr->wstime);
@@ -3990,7 +3997,7 @@ sql_trans_commit(sql_trans *tr)
 			ok = logger_funcs.log_sequence(OBJ_SID, store_oid);
 		prev_oid = store_oid;
 		if (ok == LOG_OK)
-			ok = logger_funcs.log_tend();
+			ok = logger_funcs.log_tflush(commit);
 		tr->schema_number = store_schema_number();
 	}
 	if (ok == LOG_OK) {
@@ -4003,6 +4010,26 @@ sql_trans_commit(sql_trans *tr)
 	return (ok==LOG_OK)?SQL_OK:SQL_ERR;
 }
 
+/* wait until the log is on disk up to and including transaction
+ * commit (as returned by sql_trans_commit_nosync) */
+int
+store_sync(lng commit)
+{
+	if (commit == 0)
+		return SQL_OK;
+	return logger_funcs.log_tsync(commit) == LOG_OK ? SQL_OK : SQL_ERR;
+}
+
+int
+sql_trans_commit(sql_trans *tr)
+{
+	lng commit;
+
+	if (sql_trans_commit_nosync(tr, &commit) != SQL_OK)
+		return SQL_ERR;
+	return store_sync(commit);
+}
+
 
 static int
 sql_trans_drop_all_dependencies(sql_trans *tr, sql_schema *s, int id, short type)
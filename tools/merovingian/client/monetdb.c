@@ -277,7 +277,7 @@ printStatus(sabdb *stats, int mode, int dbwidth, int uriwidth)
 		char locked = '\0';
 		char uptime[12];
 		char avg[8];
-		char info[32];
+		char info[64];
 		char *dbname;
 		char *uri;
 
@@ -303,7 +303,9 @@ printStatus(sabdb *stats, int mode, int dbwidth, int uriwidth)
 			locked = 'L';
 
 		info[0] = '\0';
-		if (stats->state == SABdbStarting) {
+		if (stats->state == SABdbStarting && stats->progress != NULL) {
+			snprintf(info, sizeof(info), "%s", stats->progress);
+		} else if (stats->state == SABdbStarting) {
 			struct tm *t;
 			t = localtime(&uplog.laststart);
 			strftime(info, sizeof(info), "starting up since %Y-%m-%d %H:%M:%S", t);
@@ -384,6 +386,8 @@ printStatus(sabdb *stats, int mode, int dbwidth, int uriwidth)
 		printf("  database name: %s\n", stats->dbname);
 		printf("  state: %s\n", state);
 		printf("  locked: %s\n", stats->locked == 1 ? "yes" : "no");
+		if (stats->state == SABdbStarting && stats->progress != NULL)
+			printf("  progress: %s\n", stats->progress);
 		entry = stats->scens;
 		printf("  scenarios:");
 		if (entry == NULL) {
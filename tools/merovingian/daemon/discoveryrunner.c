@@ -195,6 +195,7 @@ getRemoteDB(char *database)
 			walk->uri = NULL;
 			walk->next = NULL;
 			walk->uplog = NULL;
+			walk->progress = NULL;
 
 			/* cut out first returned entry, put it down the list
 			 * later, as to implement a round-robin DNS-like
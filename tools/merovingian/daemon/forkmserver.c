@@ -198,6 +198,7 @@ forkMserver(char *database, sabdb** stats, int force)
 	char *sabdbfarm;
 	char dbpath[1024];
 	char dbextra_path[1024];
+	char progress[256];
 	char port[24];
 	char muri[512]; /* possibly undersized */
 	char usock[512];
@@ -650,6 +651,7 @@ forkMserver(char *database, sabdb** stats, int force)
 		 * mserver needs time to start up, we shouldn't interrupt it,
 		 * and if it hangs, we're just doomed, with the drawback that we
 		 * completely kill the functionality of monetdbd too */
+		progress[0] = '\0';
 		do {
 			/* give the database a break */
 			sleep_ms(500);
@@ -680,6 +682,16 @@ forkMserver(char *database, sabdb** stats, int force)
 			/* server doesn't run, no need to wait any longer */
 			if (dp == NULL)
 				break;
+
+			/* log what it's doing if it takes a while, e.g. when
+			 * replaying a long write-ahead log */
+			if ((*stats)->state == SABdbStarting &&
+				(*stats)->progress != NULL &&
+				strcmp((*stats)->progress, progress) != 0)
+			{
+				snprintf(progress, sizeof(progress), "%s", (*stats)->progress);
+				Mfprintf(stdout, "database '%s' is %s\n", database, progress);
+			}
 		} while ((*stats)->state != SABdbRunning);
 
 		/* check if the SQL scenario was loaded */
@@ -19,6 +19,7 @@
 #include "mal_authorize.h"
 #include "msabaoth.h"
 #include "mutils.h"
+#include "gdk_logger.h"
 
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
@@ -221,6 +222,16 @@ static void emergencyBreakpoint(void)
 	/* just a handle to break after system initialization for GDB */
 }
 
+static void
+progress(const char *msg)
+{
+	char *err;
+
+	/* let whoever watches our status know how far we are */
+	if ((err = msab_registerProgress(msg)) != NULL)
+		free(err);
+}
+
 static void
 handler(int sig)
 {
@@ -561,6 +572,7 @@ main(int argc, char **av)
 		fprintf(stderr, "!%s\n", err);
 		free(err);
 	}
+	logger_progress_set(progress);
 
 #ifdef HAVE_SIGACTION
 	{